@@ -1,29 +1,135 @@
 #include "ACTrie.hpp"
 
 #include <algorithm>
+#include <atomic>
+#include <bit>
 #include <cassert>
+#include <climits>
+#include <cstdint>
 #include <iterator>
+#include <limits>
+#include <string>
 #include <string_view>
 
+#include "CpuFeatures.hpp"
+#include "Workers.hpp"
+
 namespace AppSpace::ACTrieDS {
 
-ACTrie::ACTrie() {
+namespace {
+
+using Edges = std::array<ACTrie::VertexIndex, ACTrie::kAlphabetLength>;
+// Bit i is set if the node has a child by the symbol with index i
+using ChildrenMask = std::uint64_t;
+static_assert(ACTrie::kAlphabetLength <= sizeof(ChildrenMask) * CHAR_BIT);
+
+ChildrenMask MaterializeEdgesScalar(Edges& edges, const Edges& suffix_edges,
+                                    std::size_t start_index) noexcept {
+    ChildrenMask children_mask = 0;
+    for (std::size_t i = start_index; i < edges.size(); i++) {
+        if (edges[i] != ACTrie::kNullNodeIndex) {
+            children_mask |= ChildrenMask{1} << i;
+        } else {
+            edges[i] = suffix_edges[i];
+        }
+    }
+    return children_mask;
+}
+
+#if ACTRIE_X86_SIMD
+
+ChildrenMask MaterializeEdgesSse2(Edges& edges,
+                                  const Edges& suffix_edges) noexcept {
+    constexpr std::size_t kBlockSize =
+        sizeof(__m128i) / sizeof(Edges::value_type);
+    const __m128i null_index  = _mm_set1_epi32(ACTrie::kNullNodeIndex);
+    ChildrenMask missing_mask = 0;
+    std::size_t i             = 0;
+    for (; i + kBlockSize <= edges.size(); i += kBlockSize) {
+        auto* block_address = reinterpret_cast<__m128i*>(edges.data() + i);
+        const __m128i block = _mm_loadu_si128(block_address);
+
+        const __m128i suffix_block = _mm_loadu_si128(
+            reinterpret_cast<const __m128i*>(suffix_edges.data() + i));
+        const __m128i missing      = _mm_cmpeq_epi32(block, null_index);
+        _mm_storeu_si128(block_address,
+                         _mm_or_si128(_mm_and_si128(missing, suffix_block),
+                                      _mm_andnot_si128(missing, block)));
+        missing_mask |= ChildrenMask(static_cast<std::uint32_t>(
+                            _mm_movemask_ps(_mm_castsi128_ps(missing))))
+                        << i;
+    }
+    const ChildrenMask blocks_mask = (ChildrenMask{1} << i) - 1;
+    return (~missing_mask & blocks_mask) |
+           MaterializeEdgesScalar(edges, suffix_edges, i);
+}
+
+ACTRIE_TARGET_AVX2
+ChildrenMask MaterializeEdgesAvx2(Edges& edges,
+                                  const Edges& suffix_edges) noexcept {
+    constexpr std::size_t kBlockSize =
+        sizeof(__m256i) / sizeof(Edges::value_type);
+    const __m256i null_index  = _mm256_set1_epi32(ACTrie::kNullNodeIndex);
+    ChildrenMask missing_mask = 0;
+    std::size_t i             = 0;
+    for (; i + kBlockSize <= edges.size(); i += kBlockSize) {
+        auto* block_address = reinterpret_cast<__m256i*>(edges.data() + i);
+        const __m256i block = _mm256_loadu_si256(block_address);
+
+        const __m256i suffix_block = _mm256_loadu_si256(
+            reinterpret_cast<const __m256i*>(suffix_edges.data() + i));
+        const __m256i missing      = _mm256_cmpeq_epi32(block, null_index);
+        _mm256_storeu_si256(block_address,
+                            _mm256_blendv_epi8(block, suffix_block, missing));
+        missing_mask |= ChildrenMask(static_cast<std::uint32_t>(
+                            _mm256_movemask_ps(_mm256_castsi256_ps(missing))))
+                        << i;
+    }
+    const ChildrenMask blocks_mask = (ChildrenMask{1} << i) - 1;
+    return (~missing_mask & blocks_mask) |
+           MaterializeEdgesScalar(edges, suffix_edges, i);
+}
+
+#endif
+
+/// @brief Replaces the missing edges by the edges of the suffix link node
+///         (the same symbol leads to the same node from both of them).
+/// @return Mask of the symbols by which the node has its own children.
+ChildrenMask MaterializeEdges(Edges& edges,
+                              const Edges& suffix_edges) noexcept {
+#if ACTRIE_X86_SIMD
+    if (CpuFeatures::HasAvx2()) {
+        return MaterializeEdgesAvx2(edges, suffix_edges);
+    }
+    return MaterializeEdgesSse2(edges, suffix_edges);
+#else
+    return MaterializeEdgesScalar(edges, suffix_edges, 0);
+#endif
+}
+
+}  // namespace
+
+ACTrie::ACTrie() : ACTrie(std::pmr::get_default_resource()) {}
+
+ACTrie::ACTrie(std::pmr::memory_resource* memory_resource)
+    : nodes_(memory_resource),
+      words_lengths_(memory_resource),
+      words_groups_(memory_resource),
+      words_weights_(memory_resource),
+      words_max_counted_occurances_(memory_resource),
+      outputs_weights_(memory_resource) {
     nodes_.reserve(kDefaultNodesCapacity);
     CreateInitialNodes();
 }
 
-ACTrie& ACTrie::AddPattern(std::string_view pattern) {
+ACTrie& ACTrie::AddPattern(std::string_view pattern, GroupsMask groups) {
     assert(!is_ready_);
     if (is_ready_) {
         ResetACTrie();
     }
 
-    for (std::size_t i = 0; i < pattern.size(); i++) {
-        const char symbol = pattern[i];
-        if (SymbolToIndex(symbol) >= kAlphabetLength) {
-            bad_input_port_.Notify({i, symbol});
-            return *this;
-        }
+    if (!CheckPatternSymbols(pattern)) {
+        return *this;
     }
 
     VertexIndex current_node_index = kRootIndex;
@@ -39,8 +145,13 @@ ACTrie& ACTrie::AddPattern(std::string_view pattern) {
         }
     }
 
-    size_t lasted_max_length = size_t(pattern_end - pattern_iter);
-    nodes_.reserve(nodes_.size() + lasted_max_length);
+    // Capacity grows geometrically, exact reserve here would reallocate
+    //  all the nodes on almost every added pattern.
+    const std::size_t lasted_max_length = size_t(pattern_end - pattern_iter);
+    if (nodes_.capacity() - nodes_.size() < lasted_max_length) {
+        nodes_.reserve(
+            std::max(nodes_.size() + lasted_max_length, 2 * nodes_.capacity()));
+    }
 
     for (VertexIndex new_node_index = VertexIndex(nodes_.size());
          pattern_iter != pattern_end; ++pattern_iter) {
@@ -52,9 +163,35 @@ ACTrie& ACTrie::AddPattern(std::string_view pattern) {
         current_node_index = new_node_index++;
     }
 
-    nodes_[current_node_index].word_index =
-        SizeToWordLength(words_lengths_.size());
+    const WordLength word_index = SizeToWordLength(words_lengths_.size());
     words_lengths_.push_back(SizeToWordLength(pattern.size()));
+    words_groups_.push_back(groups);
+    SetWordIndex(nodes_[current_node_index], word_index);
+    return *this;
+}
+
+ACTrie& ACTrie::AddPatterns(std::span<const Pattern> patterns,
+                            GroupsMask groups) {
+    assert(!is_ready_);
+    if (is_ready_) {
+        ResetACTrie();
+    }
+
+    // Subtries can be built separately only if they are empty yet
+    //  (root may be terminal though). Subscriber of the updated nodes
+    //  wants to see the nodes added one by one.
+    const bool insert_in_parallel =
+        build_threads_count_ > 1 &&
+        patterns.size() >= kParallelInsertMinPatternsSize &&
+        nodes_.size() == kInitialNodesCount &&
+        !updated_nodes_port_.HasSubscriber();
+    if (insert_in_parallel) {
+        InsertPatternsInParallel(patterns, groups);
+    } else {
+        for (Pattern pattern : patterns) {
+            AddPattern(pattern, groups);
+        }
+    }
     return *this;
 }
 
@@ -62,15 +199,33 @@ ACTrie& ACTrie::BuildACTrie() {
     assert(!is_ready_);
     nodes_[kRootIndex].suffix_link            = kFakePreRootIndex;
     nodes_[kRootIndex].compressed_suffix_link = kRootIndex;
+    nodes_[kRootIndex].output_groups = WordGroups(nodes_[kRootIndex]);
+    words_weights_.resize(words_lengths_.size(), kDefaultPatternWeight);
+    words_max_counted_occurances_.resize(words_lengths_.size(),
+                                         kUncappedOccurances);
+    has_capped_patterns_ =
+        std::ranges::any_of(words_max_counted_occurances_,
+                            [](std::uint32_t max_counted_occurances) {
+                                return max_counted_occurances !=
+                                       kUncappedOccurances;
+                            });
+    max_word_length_ =
+        words_lengths_.empty() ? 0 : std::ranges::max(words_lengths_);
+    outputs_weights_.assign(nodes_.size(), Score{0});
+    outputs_weights_[kRootIndex] = WordWeight(nodes_[kRootIndex]);
     NotifyAboutComputedSuffixLinks(kRootIndex, kFakePreRootIndex, '\0');
 
-    std::queue<VertexIndex> bfs_queue;
-    bfs_queue.push(kRootIndex);
+    // Links of the nodes of one level depend only on the nodes of the
+    //  previous levels, so they are the same in any order of the nodes
+    //  in the level, and the level can be processed by several threads.
+    std::vector<VertexIndex> bfs_level{kRootIndex};
+    std::vector<VertexIndex> bfs_next_level;
     do {
-        VertexIndex vertex_index = bfs_queue.front();
-        bfs_queue.pop();
-        ComputeLinksForNodeChildren(vertex_index, bfs_queue);
-    } while (!bfs_queue.empty());
+        ComputeLinksForLevel(bfs_level, bfs_next_level);
+        bfs_level.swap(bfs_next_level);
+        bfs_next_level.clear();
+    } while (!bfs_level.empty());
+    SetupFirstSymbolPrefilter();
     is_ready_ = true;
     return *this;
 }
@@ -79,35 +234,119 @@ ACTrie& ACTrie::ResetACTrie() {
     is_ready_ = false;
     nodes_.clear();
     words_lengths_.clear();
+    words_groups_.clear();
+    words_weights_.clear();
+    words_max_counted_occurances_.clear();
+    outputs_weights_.clear();
+    has_capped_patterns_ = false;
+    max_word_length_     = 0;
+    first_symbol_prefilter_.Reset();
     CreateInitialNodes();
     return *this;
 }
 
 ACTrie& ACTrie::FindAllSubstringsInText(std::string_view text) {
+    return FindAllSubstringsInText(text, kAllGroups);
+}
+
+ACTrie& ACTrie::FindAllSubstringsInText(std::string_view text,
+                                        GroupsMask groups) {
     if (!is_ready_) {
         BuildACTrie();
         assert(IsACTrieInCorrectState());
     }
 
-    VertexIndex current_node_index = kRootIndex;
-    NotifyAboutPassingThroughNode(current_node_index);
-    for (std::size_t i = 0; i < text.size(); i++) {
-        VertexIndex symbol_index = SymbolToIndex(text[i]);
-        current_node_index       = symbol_index < kAlphabetLength
-                                       ? nodes_[current_node_index][symbol_index]
-                                       : kRootIndex;
-        NotifyAboutPassingThroughNode(current_node_index);
-        assert(current_node_index != kNullNodeIndex);
-        if (nodes_[current_node_index].IsTerminal()) {
-            NotifyAboutFoundSubstring(current_node_index, i, text);
-        }
+    // Skipped symbols would only lead from the root to the root again,
+    //  but subscriber of the passing_through_port_ wants to see each of them.
+    const bool use_prefilter =
+        IsPrefilterActive() && !passing_through_port_.HasSubscriber();
+    auto on_found_substring = [this](const FoundSubstringInfo& info) {
+        found_substrings_port_.Notify(info);
+    };
+    ScanText(text, groups, use_prefilter, on_found_substring,
+             [this](VertexIndex node_index) {
+                 NotifyAboutPassingThroughNode(node_index);
+             });
+    return *this;
+}
 
-        JumpThroughCompressedSuffixLinks(current_node_index, i, text);
+bool ACTrie::FindAllSubstringsInText(Text text, ScanCursor& cursor,
+                                     ScanBudget budget) {
+    if (!is_ready_) {
+        BuildACTrie();
+        assert(IsACTrieInCorrectState());
     }
 
+    const bool use_prefilter =
+        IsPrefilterActive() && !passing_through_port_.HasSubscriber();
+    auto on_output = [&](VertexIndex terminal_node_index) {
+        found_substrings_port_.Notify(MakeFoundSubstringInfo(
+            terminal_node_index, cursor.position - 1, text));
+    };
+    return ScanTextPart(text, kAllGroups, use_prefilter, budget, cursor,
+                        on_output, [this](VertexIndex node_index) {
+                            NotifyAboutPassingThroughNode(node_index);
+                        });
+}
+
+ACTrie& ACTrie::SetPatternWeight(std::size_t word_index, Score weight,
+                                 std::uint32_t max_counted_occurances) {
+    assert(!is_ready_);
+    assert(word_index < words_lengths_.size());
+    if (words_weights_.size() <= word_index) {
+        words_weights_.resize(word_index + 1, kDefaultPatternWeight);
+        words_max_counted_occurances_.resize(word_index + 1,
+                                             kUncappedOccurances);
+    }
+    words_weights_[word_index]                = weight;
+    words_max_counted_occurances_[word_index] = max_counted_occurances;
     return *this;
 }
 
+ACTrie::Score ACTrie::ScoreText(Text text, GroupsMask groups) const {
+    assert(is_ready_);
+    if (groups == kAllGroups && !has_capped_patterns_) {
+        return ScoreTextByOutputsWeights(text);
+    }
+
+    CountedOccurances counted_occurances;
+    return ScoreTextByWords(text, groups, counted_occurances);
+}
+
+std::vector<ACTrie::Score> ACTrie::ScoreTexts(std::span<const Text> texts,
+                                              GroupsMask groups) const {
+    assert(is_ready_);
+    std::vector<Score> scores;
+    scores.reserve(texts.size());
+    if (groups == kAllGroups && !has_capped_patterns_) {
+        for (Text text : texts) {
+            scores.push_back(ScoreTextByOutputsWeights(text));
+        }
+        return scores;
+    }
+
+    // Counters are shared by the texts, ScoreTextByWords() resets
+    //  only the ones it has touched.
+    CountedOccurances counted_occurances;
+    for (Text text : texts) {
+        scores.push_back(ScoreTextByWords(text, groups, counted_occurances));
+    }
+    return scores;
+}
+
+void ACTrie::CountOccurances(Text text,
+                             std::span<OccurancesCount> words_counts) const {
+    assert(is_ready_);
+    assert(words_counts.size() >= words_lengths_.size());
+    auto count_word = [this, words_counts](VertexIndex terminal_node_index) {
+        words_counts[nodes_[terminal_node_index].word_index]++;
+    };
+    auto on_node = [this, &count_word](VertexIndex node_index, std::size_t) {
+        ForEachOutput(node_index, kAllGroups, count_word);
+    };
+    WalkText(text, IsPrefilterActive(), on_node);
+}
+
 ACTrie& ACTrie::AddSubscriber(UpdatedNodeObserver* observer) {
     updated_nodes_port_.Subscribe(observer);
     NotifyAboutInitialNodes();
@@ -129,73 +368,324 @@ ACTrie& ACTrie::AddSubscriber(PassingThroughObserver* observer) {
     return *this;
 }
 
+ACTrie& ACTrie::SetPrefilterEnabled(bool enabled) noexcept {
+    prefilter_enabled_ = enabled;
+    return *this;
+}
+
+ACTrie& ACTrie::SetBuildThreadsCount(std::size_t threads_count) noexcept {
+    build_threads_count_ =
+        threads_count != 0 ? threads_count : Workers::HardwareThreadsCount();
+    return *this;
+}
+
+void ACTrie::InsertIntoSubtrie(std::vector<ACTNode>& subtrie, Pattern pattern,
+                               WordLength word_index,
+                               std::span<GroupsMask> words_groups) {
+    // Node of the first symbol has local index 0, so kNullNodeIndex == 0
+    //  still means a missing edge (no edge leads to that node).
+    if (subtrie.empty()) {
+        subtrie.emplace_back();
+    }
+
+    VertexIndex current_node_index = 0;
+    for (char symbol : pattern.substr(1)) {
+        VertexIndex symbol_index    = SymbolToIndex(symbol);
+        VertexIndex next_node_index = subtrie[current_node_index][symbol_index];
+        if (next_node_index == kNullNodeIndex) {
+            next_node_index = VertexIndex(subtrie.size());
+            subtrie.emplace_back();
+            subtrie[current_node_index][symbol_index] = next_node_index;
+        }
+        current_node_index = next_node_index;
+    }
+    ACTNode& node = subtrie[current_node_index];
+    if (node.IsTerminal()) {
+        words_groups[word_index] |= words_groups[node.word_index];
+    }
+    node.word_index = word_index;
+}
+
 void ACTrie::CreateInitialNodes() {
     nodes_.resize(kInitialNodesCount);
     nodes_[kFakePreRootIndex].edges.fill(kRootIndex);
     NotifyAboutInitialNodes();
 }
 
-void ACTrie::NotifyAboutFoundSubstring(VertexIndex current_node_index,
-                                       std::size_t position_in_text,
-                                       std::string_view text) {
-    auto word_index = nodes_[current_node_index].word_index;
-    assert(word_index < words_lengths_.size());
-    auto word_length         = words_lengths_[word_index];
-    auto word_start_position = position_in_text + 1 - word_length;
+void ACTrie::SetWordIndex(ACTNode& node, WordLength word_index) {
+    // Repeated pattern is found with the index of the last addition
+    //  by the queries with any of the groups of all the additions.
+    if (node.IsTerminal()) {
+        words_groups_[word_index] |= words_groups_[node.word_index];
+    }
+    node.word_index = word_index;
+}
 
-    found_substrings_port_.Notify(FoundSubstringInfo{
-        .found_substring       = text.substr(word_start_position, word_length),
-        .substring_start_index = word_start_position,
-        .current_vertex_index  = current_node_index,
-    });
+ACTrie::GroupsMask ACTrie::WordGroups(const ACTNode& node) const noexcept {
+    return node.IsTerminal() ? words_groups_[node.word_index] : 0;
+}
+
+bool ACTrie::CheckPatternSymbols(Pattern pattern) {
+    for (std::size_t i = 0; i < pattern.size(); i++) {
+        const char symbol = pattern[i];
+        if (SymbolToIndex(symbol) >= kAlphabetLength) {
+            bad_input_port_.Notify({i, symbol});
+            return false;
+        }
+    }
+    return true;
+}
+
+void ACTrie::InsertPatternsInParallel(std::span<const Pattern> patterns,
+                                      GroupsMask groups) {
+    assert(nodes_.size() == kInitialNodesCount);
+    struct SubtriePattern final {
+        Pattern pattern;
+        WordLength word_index;
+    };
+
+    // Word indexes are given in the order of the patterns, like
+    //  AddPattern() does, so the patterns are checked here sequentially.
+    std::array<std::vector<SubtriePattern>, kAlphabetLength> subtries_patterns;
+    words_lengths_.reserve(words_lengths_.size() + patterns.size());
+    words_groups_.reserve(words_groups_.size() + patterns.size());
+    for (Pattern pattern : patterns) {
+        if (!CheckPatternSymbols(pattern)) {
+            continue;
+        }
+
+        const WordLength word_index = SizeToWordLength(words_lengths_.size());
+        words_lengths_.push_back(SizeToWordLength(pattern.size()));
+        words_groups_.push_back(groups);
+        if (pattern.empty()) {
+            SetWordIndex(nodes_[kRootIndex], word_index);
+        } else {
+            subtries_patterns[SymbolToIndex(pattern.front())].push_back(
+                SubtriePattern{
+                    .pattern    = pattern,
+                    .word_index = word_index,
+                });
+        }
+    }
+
+    // Patterns with the different first symbols share no nodes, so
+    //  subtries of the root children are built independently in the local
+    //  indexes and then copied to the nodes_ with the shifted indexes.
+    std::array<std::vector<ACTNode>, kAlphabetLength> subtries;
+    std::atomic<std::size_t> next_symbol_index{0};
+    auto build_subtries = [&](std::size_t) {
+        for (std::size_t symbol_index = next_symbol_index.fetch_add(1);
+             symbol_index < kAlphabetLength;
+             symbol_index = next_symbol_index.fetch_add(1)) {
+            for (const SubtriePattern& subtrie_pattern :
+                 subtries_patterns[symbol_index]) {
+                InsertIntoSubtrie(subtries[symbol_index],
+                                  subtrie_pattern.pattern,
+                                  subtrie_pattern.word_index, words_groups_);
+            }
+        }
+    };
+    const std::size_t threads_count =
+        std::min(build_threads_count_, kAlphabetLength);
+    Workers::Run(threads_count, build_subtries);
+
+    std::array<VertexIndex, kAlphabetLength> subtries_offsets{};
+    std::size_t nodes_size = nodes_.size();
+    for (std::size_t symbol_index = 0; symbol_index < kAlphabetLength;
+         symbol_index++) {
+        subtries_offsets[symbol_index] = VertexIndex(nodes_size);
+        if (!subtries[symbol_index].empty()) {
+            nodes_[kRootIndex][symbol_index] = VertexIndex(nodes_size);
+        }
+        nodes_size += subtries[symbol_index].size();
+    }
+    nodes_.resize(nodes_size);
+
+    next_symbol_index = 0;
+    auto copy_subtries = [&](std::size_t) {
+        for (std::size_t symbol_index = next_symbol_index.fetch_add(1);
+             symbol_index < kAlphabetLength;
+             symbol_index = next_symbol_index.fetch_add(1)) {
+            const VertexIndex offset = subtries_offsets[symbol_index];
+            auto node_iter           = nodes_.begin() + offset;
+            for (const ACTNode& subtrie_node : subtries[symbol_index]) {
+                ACTNode& node = *node_iter++;
+                node          = subtrie_node;
+                for (VertexIndex& child_index : node.edges) {
+                    if (child_index != kNullNodeIndex) {
+                        child_index += offset;
+                    }
+                }
+            }
+            std::vector<ACTNode>().swap(subtries[symbol_index]);
+        }
+    };
+    Workers::Run(threads_count, copy_subtries);
+}
+
+ACTrie::Score ACTrie::ScoreTextByOutputsWeights(Text text) const noexcept {
+    Score score  = 0;
+    auto on_node = [this, &score](VertexIndex node_index, std::size_t) {
+        score += outputs_weights_[node_index];
+    };
+    WalkText(text, IsPrefilterActive(), on_node);
+    return score;
+}
+
+ACTrie::Score ACTrie::ScoreTextByWords(
+    Text text, GroupsMask groups, CountedOccurances& counted_occurances) const {
+    if (has_capped_patterns_) {
+        counted_occurances.words_counts.resize(words_lengths_.size());
+    }
+
+    Score score     = 0;
+    auto score_word = [&](VertexIndex terminal_node_index) {
+        const WordLength word_index = nodes_[terminal_node_index].word_index;
+        const std::uint32_t max_counted_occurances =
+            words_max_counted_occurances_[word_index];
+        if (max_counted_occurances != kUncappedOccurances) {
+            std::uint32_t& word_count =
+                counted_occurances.words_counts[word_index];
+            if (word_count == max_counted_occurances) {
+                return;
+            }
+            if (word_count++ == 0) {
+                counted_occurances.counted_words.push_back(word_index);
+            }
+        }
+        score += words_weights_[word_index];
+    };
+    auto on_node = [&](VertexIndex node_index, std::size_t) {
+        ForEachOutput(node_index, groups, score_word);
+    };
+    WalkText(text, IsPrefilterActive(), on_node);
+
+    for (WordLength word_index : counted_occurances.counted_words) {
+        counted_occurances.words_counts[word_index] = 0;
+    }
+    counted_occurances.counted_words.clear();
+    return score;
 }
 
-void ACTrie::JumpThroughCompressedSuffixLinks(VertexIndex current_node_index,
-                                              std::size_t position_in_text,
-                                              std::string_view text) {
-    for (VertexIndex terminal_node_index =
-             nodes_[current_node_index].compressed_suffix_link;
-         terminal_node_index != kRootIndex;
-         terminal_node_index =
-             nodes_[terminal_node_index].compressed_suffix_link) {
-        assert(terminal_node_index != kNullNodeIndex);
-        assert(nodes_[terminal_node_index].IsTerminal());
-        NotifyAboutFoundSubstring(terminal_node_index, position_in_text, text);
+ACTrie::Score ACTrie::WordWeight(const ACTNode& node) const noexcept {
+    // Pattern without groups is never found, so it is never scored
+    return WordGroups(node) != 0 ? words_weights_[node.word_index] : Score{0};
+}
+
+void ACTrie::ComputeLinksForLevel(const std::vector<VertexIndex>& level,
+                                  std::vector<VertexIndex>& next_level) {
+    const std::size_t threads_count = std::min(
+        build_threads_count_, level.size() / kParallelBuildMinLevelSize);
+    // Subscriber of the updated nodes wants to see them in the BFS order.
+    if (threads_count <= 1 || updated_nodes_port_.HasSubscriber()) {
+        for (VertexIndex node_index : level) {
+            ComputeLinksForNodeChildren(node_index, next_level);
+        }
+        return;
+    }
+
+    // Links of the node children depend only on the rows and the links of
+    //  the nodes from this and the previous levels, which were computed
+    //  before this level, so nodes of one level are processed independently.
+    std::vector<std::vector<VertexIndex>> threads_next_levels(threads_count);
+    std::atomic<std::size_t> next_chunk_start{0};
+    auto compute_links = [&](std::size_t thread_index) {
+        std::vector<VertexIndex>& thread_next_level =
+            threads_next_levels[thread_index];
+        auto take_chunk = [&next_chunk_start]() noexcept {
+            return next_chunk_start.fetch_add(kParallelBuildChunkSize);
+        };
+        for (std::size_t chunk_start = take_chunk(); chunk_start < level.size();
+             chunk_start = take_chunk()) {
+            const std::size_t chunk_end =
+                std::min(chunk_start + kParallelBuildChunkSize, level.size());
+            for (std::size_t i = chunk_start; i < chunk_end; i++) {
+                ComputeLinksForNodeChildren(level[i], thread_next_level);
+            }
+        }
+    };
+    Workers::Run(threads_count, compute_links);
+    for (const std::vector<VertexIndex>& thread_next_level :
+         threads_next_levels) {
+        next_level.insert(next_level.end(), thread_next_level.begin(),
+                          thread_next_level.end());
     }
 }
 
 void ACTrie::ComputeLinksForNodeChildren(VertexIndex node_index,
-                                         std::queue<VertexIndex>& bfs_queue) {
-    ACTNode& node = nodes_[node_index];
-    for (VertexIndex child_node_symbol_index = 0;
-         child_node_symbol_index < kAlphabetLength; child_node_symbol_index++) {
+                                         std::vector<VertexIndex>& next_level) {
+    ACTNode& node                 = nodes_[node_index];
+    const ACTNode& suffix_link_node = nodes_[node.suffix_link];
+    assert(&suffix_link_node != &node);
+    // Edges to the children are not changed, so they can be
+    //  read after the missing edges are filled.
+    for (ChildrenMask children_mask =
+             MaterializeEdges(node.edges, suffix_link_node.edges);
+         children_mask != 0; children_mask &= children_mask - 1) {
+        const auto child_node_symbol_index =
+            static_cast<VertexIndex>(std::countr_zero(children_mask));
         VertexIndex child_link_v_index =
-            nodes_[node.suffix_link][child_node_symbol_index];
+            suffix_link_node[child_node_symbol_index];
         assert(child_link_v_index != kNullNodeIndex);
         VertexIndex child_index = node[child_node_symbol_index];
-        if (child_index != kNullNodeIndex) {
-            nodes_[child_index].suffix_link = child_link_v_index;
-            assert(nodes_[child_link_v_index].compressed_suffix_link !=
-                   kNullNodeIndex);
-
-            bool suffix_child_is_terminal_or_root =
-                nodes_[child_link_v_index].IsTerminal() ||
-                child_link_v_index == kRootIndex;
-            nodes_[child_index].compressed_suffix_link =
-                suffix_child_is_terminal_or_root
-                    ? child_link_v_index
-                    : nodes_[child_link_v_index].compressed_suffix_link;
-
-            char parent_to_node_edge_symbol =
-                IndexToSymbol(child_node_symbol_index);
-            NotifyAboutComputedSuffixLinks(child_index, node_index,
-                                           parent_to_node_edge_symbol);
-
-            bfs_queue.push(child_index);
-        } else {
-            node[child_node_symbol_index] = child_link_v_index;
+        assert(child_index != kNullNodeIndex);
+        nodes_[child_index].suffix_link = child_link_v_index;
+        assert(nodes_[child_link_v_index].compressed_suffix_link !=
+               kNullNodeIndex);
+
+        bool suffix_child_is_terminal_or_root =
+            nodes_[child_link_v_index].IsTerminal() ||
+            child_link_v_index == kRootIndex;
+        nodes_[child_index].compressed_suffix_link =
+            suffix_child_is_terminal_or_root
+                ? child_link_v_index
+                : nodes_[child_link_v_index].compressed_suffix_link;
+        nodes_[child_index].output_groups =
+            WordGroups(nodes_[child_index]) |
+            nodes_[child_link_v_index].output_groups;
+        // Empty pattern is found only when the walk is at the root, it is
+        //  not a part of the output chains ending there
+        outputs_weights_[child_index] =
+            WordWeight(nodes_[child_index]) +
+            (child_link_v_index == kRootIndex
+                 ? Score{0}
+                 : outputs_weights_[child_link_v_index]);
+
+        char parent_to_node_edge_symbol =
+            IndexToSymbol(child_node_symbol_index);
+        NotifyAboutComputedSuffixLinks(child_index, node_index,
+                                       parent_to_node_edge_symbol);
+
+        next_level.push_back(child_index);
+    }
+}
+
+void ACTrie::SetupFirstSymbolPrefilter() {
+    // If the root is terminal (empty pattern was added), every
+    //  symbol leading to the root is a match, so nothing can be skipped.
+    if (nodes_[kRootIndex].IsTerminal()) {
+        first_symbol_prefilter_.Reset();
+        return;
+    }
+
+    // Iterate over all bytes and not over the alphabet because
+    //  in the case insensitive mode several bytes map to one symbol.
+    std::string first_symbols;
+    const ACTNode& root = nodes_[kRootIndex];
+    for (std::uint32_t byte = 0;
+         byte <= std::numeric_limits<std::uint8_t>::max(); byte++) {
+        const char symbol        = static_cast<char>(byte);
+        VertexIndex symbol_index = SymbolToIndex(symbol);
+        if (symbol_index < kAlphabetLength &&
+            root[symbol_index] != kRootIndex) {
+            first_symbols.push_back(symbol);
+            if (first_symbols.size() > FirstSymbolPrefilter::kMaxSymbols) {
+                break;
+            }
         }
     }
+
+    first_symbol_prefilter_.Setup(first_symbols);
 }
 
 bool ACTrie::IsACTrieInCorrectState() const {
@@ -1,15 +1,20 @@
 #pragma once
 
+#include <algorithm>
 #include <array>
 #include <cassert>
 #include <cctype>
 #include <cstdint>
 #include <limits>
-#include <queue>
+#include <memory_resource>
+#include <optional>
+#include <span>
 #include <string>
 #include <string_view>
 #include <vector>
 
+#include "FirstSymbolPrefilter.hpp"
+#include "LineTracker.hpp"
 #include "Observer.hpp"
 
 namespace AppSpace::ACTrieDS {
@@ -20,6 +25,10 @@ public:
     using WordLength  = std::uint32_t;
     using Pattern     = std::string_view;
     using Text        = std::string_view;
+    // Bit i is set if the pattern belongs to the group i
+    using GroupsMask      = std::uint64_t;
+    using Score           = double;
+    using OccurancesCount = std::uint64_t;
 
     static constexpr bool kIsCaseInsensitive = false;
     static constexpr char kAlphabetStart     = 'A';
@@ -30,6 +39,11 @@ public:
     static constexpr VertexIndex kFakePreRootIndex  = kNullNodeIndex + 1;
     static constexpr VertexIndex kRootIndex         = kFakePreRootIndex + 1;
     static constexpr VertexIndex kInitialNodesCount = kRootIndex + 1;
+    static constexpr GroupsMask kAllGroups =
+        std::numeric_limits<GroupsMask>::max();
+    static constexpr std::uint32_t kUncappedOccurances =
+        std::numeric_limits<std::uint32_t>::max();
+    static constexpr Score kDefaultPatternWeight = 1;
 
     struct ACTNode final {
         static constexpr WordLength kMissingWord =
@@ -50,6 +64,12 @@ public:
          */
         WordLength word_index = kMissingWord;
 
+        /*
+         * Union of the groups of the words which end in this node or in
+         * the nodes reachable by the suffix links, 0 if there are none
+         */
+        GroupsMask output_groups = 0;
+
         VertexIndex operator[](std::size_t index) const noexcept {
             assert(index < edges.size());
             return edges[index];
@@ -80,12 +100,50 @@ public:
     struct FoundSubstringInfo {
         std::string_view found_substring;
         std::size_t substring_start_index;
+        // kNullNodeIndex if substring was found by the matcher without nodes
         VertexIndex current_vertex_index;
+        // Index of the found pattern in order of the AddPattern() calls
+        WordLength word_index;
     };
     struct BadInputPatternInfo {
         std::size_t symbol_index;
         char bad_symbol;
     };
+    enum class LineMatchMode {
+        // Each substring, like FindAllSubstringsInText() finds them
+        kAllSubstrings,
+        // Only the first of them in each line, the rest of the line is
+        //  skipped
+        kFirstSubstringOfLine,
+    };
+    struct FoundInLineInfo {
+        FoundSubstringInfo substring;
+        // Lines end with '\n' and are counted from 0
+        std::size_t line_index;
+        std::size_t line_start_index;
+    };
+    struct FoundInStreamInfo {
+        // Index after the last symbol of the substring in the current part
+        //  of the stream, the substring starts in the previous parts if its
+        //  length is greater
+        std::size_t end_index;
+        WordLength word_index;
+        WordLength length;
+    };
+    /// @brief State of the scan stopped after a found substring: the node
+    ///         after the symbol text[position - 1] and the next node of its
+    ///         output chain to look at (kRootIndex if there are none left).
+    struct ScanCursor {
+        VertexIndex node_index        = kRootIndex;
+        VertexIndex output_node_index = kRootIndex;
+        std::size_t position          = 0;
+    };
+    // Limits of one call of the resumable scan
+    struct ScanBudget {
+        std::size_t max_symbols_count = std::numeric_limits<std::size_t>::max();
+        std::size_t max_found_substrings_count =
+            std::numeric_limits<std::size_t>::max();
+    };
     using PassingThroughInfo        = VertexIndex;
     using UpdatedNodeInfoPassBy     = UpdatedNodeInfo;
     using FoundSubstringInfoPassBy  = FoundSubstringInfo;
@@ -101,31 +159,221 @@ public:
         Observer<PassingThroughInfo, PassingThroughInfoPassBy>;
 
     ACTrie();
-    ACTrie& AddPattern(Pattern pattern);
+    /// @brief Nodes and lengths of the words will be allocated from the
+    ///         memory_resource (for example, HugePagesMemoryResource).
+    /// @param memory_resource must outlive the ACTrie
+    explicit ACTrie(std::pmr::memory_resource* memory_resource);
+    /// @brief Adds pattern which will be found only by the queries with
+    ///         at least one of its groups. Repeated pattern belongs to the
+    ///         groups of all its additions.
+    /// @param pattern
+    /// @param groups
+    ACTrie& AddPattern(Pattern pattern, GroupsMask groups = kAllGroups);
+    /// @brief Adds patterns as if AddPattern() was called for each of them.
+    ///         If the trie is empty and the patterns are many, subtries of
+    ///         the different first symbols are built by several threads.
+    /// @param patterns
+    /// @param groups
+    ACTrie& AddPatterns(std::span<const Pattern> patterns,
+                        GroupsMask groups = kAllGroups);
     ACTrie& BuildACTrie();
     ACTrie& ResetACTrie();
     ACTrie& FindAllSubstringsInText(Text text);
+    /// @brief Finds only the patterns from at least one of the groups.
+    ///         Nodes where no such pattern ends are passed without
+    ///         looking at their outputs.
+    /// @param text
+    /// @param groups
+    ACTrie& FindAllSubstringsInText(Text text, GroupsMask groups);
+    /// @brief Calls on_found_substring(FoundSubstringInfo) for each found
+    ///         substring in the same order as FindAllSubstringsInText(text)
+    ///         notifies the subscriber. Does not change the ACTrie, so it
+    ///         may be called from several threads at once, but only after
+    ///         BuildACTrie().
+    template <class OnFoundSubstring>
+    void FindAllSubstringsInText(Text text,
+                                 OnFoundSubstring&& on_found_substring) const;
+    template <class OnFoundSubstring>
+    void FindAllSubstringsInText(Text text, GroupsMask groups,
+                                 OnFoundSubstring&& on_found_substring) const;
+    /// @brief Resumable FindAllSubstringsInText(text): scans at most
+    ///         budget.max_symbols_count symbols from the cursor and notifies
+    ///         the subscribers about at most budget.max_found_substrings_count
+    ///         substrings, then stops. The cursor keeps the position in the
+    ///         output chain, so the next call with the same text and cursor
+    ///         continues without losing or repeating a substring. Lets a
+    ///         single-threaded loop (like the runtime loop of the visualizer)
+    ///         interleave the scan of a huge text with other work.
+    /// @param text
+    /// @param cursor
+    /// @param budget both limits must be positive
+    /// @return true if the text is scanned to the end
+    bool FindAllSubstringsInText(Text text, ScanCursor& cursor,
+                                 ScanBudget budget);
+    /// @brief Resumable FindAllSubstringsInText(text, groups,
+    ///         on_found_substring), see above. May be called from several
+    ///         threads at once (with different cursors) after BuildACTrie().
+    template <class OnFoundSubstring>
+    bool FindAllSubstringsInText(Text text, GroupsMask groups,
+                                 ScanCursor& cursor, ScanBudget budget,
+                                 OnFoundSubstring&& on_found_substring) const;
+    /// @brief Sets the weight with which the pattern is counted by
+    ///         ScoreText(). Must be called before BuildACTrie().
+    /// @param word_index index of the pattern in order of the AddPattern()
+    ///         calls. Repeated pattern is scored with the weight of its last
+    ///         addition.
+    /// @param weight
+    /// @param max_counted_occurances only that many first occurances of the
+    ///         pattern add its weight to the score of the text.
+    ACTrie& SetPatternWeight(
+        std::size_t word_index, Score weight,
+        std::uint32_t max_counted_occurances = kUncappedOccurances);
+    /// @brief Returns the sum of the weights of all occurances of the
+    ///         patterns from at least one of the groups, without making
+    ///         FoundSubstringInfo for them. If all patterns are uncapped
+    ///         and all groups are enabled, the output chains are not
+    ///         walked: sum of the weights of the chain is stored for each
+    ///         node, so each symbol costs one addition. May be called from
+    ///         several threads at once after BuildACTrie().
+    /// @param text
+    /// @param groups
+    Score ScoreText(Text text, GroupsMask groups = kAllGroups) const;
+    /// @brief Returns ScoreText(text, groups) for each of the texts.
+    /// @param texts
+    /// @param groups
+    std::vector<Score> ScoreTexts(std::span<const Text> texts,
+                                  GroupsMask groups = kAllGroups) const;
+    /// @brief Adds the number of the occurances of each pattern in the text
+    ///         to words_counts[word_index] without making FoundSubstringInfo.
+    ///         Repeated pattern is counted at the index of its last addition.
+    ///         May be called from several threads at once (with different
+    ///         words_counts) after BuildACTrie().
+    /// @param text
+    /// @param words_counts at least PatternsSize() counters
+    void CountOccurances(Text text,
+                         std::span<OccurancesCount> words_counts) const;
+    /// @brief Calls on_found_in_line(FoundInLineInfo) for the substrings
+    ///         with their lines, which are tracked during the scan (see
+    ///         LineTracker). '\n' is out of the alphabet, so the automaton
+    ///         restarts at each line boundary and no substring crosses it.
+    ///         May be called from several threads at once after
+    ///         BuildACTrie().
+    /// @param text
+    /// @param mode
+    /// @param on_found_in_line
+    template <class OnFoundInLine>
+    void FindSubstringsInLines(Text text, LineMatchMode mode,
+                               OnFoundInLine&& on_found_in_line) const;
+    template <class OnFoundInLine>
+    void FindSubstringsInLines(Text text, GroupsMask groups,
+                               LineMatchMode mode,
+                               OnFoundInLine&& on_found_in_line) const;
+    /// @brief Returns the next substring found after the cursor, in the same
+    ///         order as FindAllSubstringsInText() finds them, and moves the
+    ///         cursor past it, or std::nullopt at the end of the text. Text
+    ///         is scanned only up to the returned substring (see MatchRange).
+    ///         May be called from several threads at once (with different
+    ///         cursors) after BuildACTrie().
+    /// @param text must be the same for all calls with the cursor
+    /// @param groups
+    /// @param cursor
+    std::optional<FoundSubstringInfo> FindNextSubstring(
+        Text text, GroupsMask groups, ScanCursor& cursor) const;
+    /// @brief Like FindNextSubstring(), but the text is the current part of
+    ///         a stream: when the part is scanned, returns std::nullopt and
+    ///         moves the cursor to the start of the next part, keeping the
+    ///         node, so the substrings crossing the parts are found without
+    ///         copying the end of the previous part.
+    /// @param part
+    /// @param groups
+    /// @param cursor
+    std::optional<FoundInStreamInfo> FindNextInStream(Text part,
+                                                      GroupsMask groups,
+                                                      ScanCursor& cursor) const;
     ACTrie& AddSubscriber(UpdatedNodeObserver* observer);
     ACTrie& AddSubscriber(FoundSubstringObserver* observer);
     ACTrie& AddSubscriber(BadInputPatternObserver* observer);
     ACTrie& AddSubscriber(PassingThroughObserver* observer);
+    /// @brief Enables or disables skipping of the text regions that can not
+    ///         start any pattern (see FirstSymbolPrefilter). Enabled by
+    ///         default. Found substrings do not depend on this setting.
+    /// @param enabled
+    ACTrie& SetPrefilterEnabled(bool enabled) noexcept;
+    /// @brief Returns true if FindAllSubstringsInText() will use the first
+    ///         symbol prefilter (it is used only when the number of the
+    ///         distinct first symbols of the patterns is small).
+    constexpr bool IsPrefilterActive() const noexcept;
+    constexpr bool IsReady() const noexcept;
+    /// @brief Sets the maximal number of threads used by AddPatterns() and
+    ///         BuildACTrie(), 0 means the number of hardware threads. By
+    ///         default the ACTrie is built by the calling thread only.
+    ///         Threads are used only if nobody listens to the updated nodes.
+    /// @param threads_count
+    ACTrie& SetBuildThreadsCount(std::size_t threads_count) noexcept;
+    constexpr std::size_t BuildThreadsCount() const noexcept;
     constexpr std::size_t NodesSize() const noexcept;
     constexpr std::size_t PatternsSize() const noexcept;
+    /// @brief Length of the longest added pattern, valid after BuildACTrie().
+    ///         Scan of the text part that starts MaxPatternLength() - 1
+    ///         symbols earlier reaches the part in the same state as the scan
+    ///         of the whole text.
+    constexpr WordLength MaxPatternLength() const noexcept;
     static constexpr VertexIndex SymbolToIndex(char symbol) noexcept;
     static constexpr char IndexToSymbol(VertexIndex index) noexcept;
 
 private:
     static constexpr std::size_t kDefaultNodesCapacity = 16;
+    // Smaller levels of the BFS are not worth starting the threads
+    static constexpr std::size_t kParallelBuildMinLevelSize = 1 << 12;
+    // Nodes of the level are given to the threads by chunks of that size
+    static constexpr std::size_t kParallelBuildChunkSize        = 1 << 8;
+    static constexpr std::size_t kParallelInsertMinPatternsSize = 1 << 12;
     static constexpr WordLength SizeToWordLength(std::size_t size) noexcept;
+    static void InsertIntoSubtrie(std::vector<ACTNode>& subtrie,
+                                  Pattern pattern, WordLength word_index,
+                                  std::span<GroupsMask> words_groups);
     void CreateInitialNodes();
-    void NotifyAboutFoundSubstring(VertexIndex current_node_index,
-                                   std::size_t position_in_text,
-                                   std::string_view text);
-    void JumpThroughCompressedSuffixLinks(VertexIndex current_node_index,
-                                          std::size_t position_in_text,
-                                          std::string_view text);
+    bool CheckPatternSymbols(Pattern pattern);
+    void SetWordIndex(ACTNode& node, WordLength word_index);
+    GroupsMask WordGroups(const ACTNode& node) const noexcept;
+    void InsertPatternsInParallel(std::span<const Pattern> patterns,
+                                  GroupsMask groups);
+    // Occurances counted by ScoreText() for the capped patterns
+    struct CountedOccurances final {
+        std::vector<std::uint32_t> words_counts;
+        std::vector<WordLength> counted_words;
+    };
+
+    template <class OnNode>
+    void WalkText(Text text, bool use_prefilter, OnNode& on_node) const;
+    template <class OnOutput>
+    void ForEachOutput(VertexIndex node_index, GroupsMask groups,
+                       OnOutput& on_output) const;
+    /// @brief Returns the next terminal node reported after the cursor, the
+    ///         word ends at the symbol text[cursor.position - 1].
+    std::optional<VertexIndex> FindNextOutput(Text text, GroupsMask groups,
+                                              ScanCursor& cursor) const;
+    template <class OnOutput, class OnPassingThrough>
+    bool ScanTextPart(Text text, GroupsMask groups, bool use_prefilter,
+                      ScanBudget budget, ScanCursor& cursor,
+                      OnOutput& on_output,
+                      OnPassingThrough on_passing_through) const;
+    template <class OnFoundSubstring, class OnPassingThrough>
+    void ScanText(Text text, GroupsMask groups, bool use_prefilter,
+                  OnFoundSubstring& on_found_substring,
+                  OnPassingThrough on_passing_through) const;
+    FoundSubstringInfo MakeFoundSubstringInfo(VertexIndex current_node_index,
+                                              std::size_t position_in_text,
+                                              Text text) const noexcept;
+    Score ScoreTextByOutputsWeights(Text text) const noexcept;
+    Score ScoreTextByWords(Text text, GroupsMask groups,
+                           CountedOccurances& counted_occurances) const;
+    Score WordWeight(const ACTNode& node) const noexcept;
+    void ComputeLinksForLevel(const std::vector<VertexIndex>& level,
+                              std::vector<VertexIndex>& next_level);
     void ComputeLinksForNodeChildren(VertexIndex node_index,
-                                     std::queue<VertexIndex>& queue);
+                                     std::vector<VertexIndex>& next_level);
+    void SetupFirstSymbolPrefilter();
     bool IsACTrieInCorrectState() const;
     bool IsFakePreRootNodeInCorrectState() const;
     void NotifyAboutAddedNode(VertexIndex added_node_index,
@@ -137,9 +385,21 @@ private:
     void NotifyAboutInitialNodes();
     void NotifyAboutPassingThroughNode(VertexIndex node_index);
 
-    std::vector<ACTNode> nodes_;
-    std::vector<WordLength> words_lengths_;
-    bool is_ready_ = false;
+    std::pmr::vector<ACTNode> nodes_;
+    std::pmr::vector<WordLength> words_lengths_;
+    std::pmr::vector<GroupsMask> words_groups_;
+    // Filled up to the number of the patterns by BuildACTrie()
+    std::pmr::vector<Score> words_weights_;
+    std::pmr::vector<std::uint32_t> words_max_counted_occurances_;
+    // Sum of the weights of the words found at the node: the ones of its
+    //  output chain, or the empty pattern at the root (0 if there are none)
+    std::pmr::vector<Score> outputs_weights_;
+    FirstSymbolPrefilter first_symbol_prefilter_;
+    std::size_t build_threads_count_ = 1;
+    WordLength max_word_length_      = 0;
+    bool is_ready_                   = false;
+    bool prefilter_enabled_          = true;
+    bool has_capped_patterns_        = false;
     Observable<UpdatedNodeInfo, UpdatedNodeInfoPassBy> updated_nodes_port_;
     Observable<FoundSubstringInfo, FoundSubstringInfoPassBy>
         found_substrings_port_;
@@ -148,6 +408,322 @@ private:
         passing_through_port_;
 };
 
+constexpr bool ACTrie::IsPrefilterActive() const noexcept {
+    return prefilter_enabled_ && first_symbol_prefilter_.IsEnabled();
+}
+
+constexpr bool ACTrie::IsReady() const noexcept {
+    return is_ready_;
+}
+
+template <class OnFoundSubstring>
+void ACTrie::FindAllSubstringsInText(
+    Text text, OnFoundSubstring&& on_found_substring) const {
+    FindAllSubstringsInText(text, kAllGroups, on_found_substring);
+}
+
+template <class OnFoundSubstring>
+void ACTrie::FindAllSubstringsInText(
+    Text text, GroupsMask groups, OnFoundSubstring&& on_found_substring) const {
+    assert(is_ready_);
+    ScanText(text, groups, IsPrefilterActive(), on_found_substring,
+             [](VertexIndex) constexpr noexcept {});
+}
+
+template <class OnFoundSubstring>
+bool ACTrie::FindAllSubstringsInText(
+    Text text, GroupsMask groups, ScanCursor& cursor, ScanBudget budget,
+    OnFoundSubstring&& on_found_substring) const {
+    assert(is_ready_);
+    auto on_output = [&](VertexIndex terminal_node_index) {
+        on_found_substring(MakeFoundSubstringInfo(terminal_node_index,
+                                                  cursor.position - 1, text));
+    };
+    return ScanTextPart(text, groups, IsPrefilterActive(), budget, cursor,
+                        on_output, [](VertexIndex) constexpr noexcept {});
+}
+
+template <class OnFoundInLine>
+void ACTrie::FindSubstringsInLines(Text text, LineMatchMode mode,
+                                   OnFoundInLine&& on_found_in_line) const {
+    FindSubstringsInLines(text, kAllGroups, mode, on_found_in_line);
+}
+
+template <class OnFoundInLine>
+void ACTrie::FindSubstringsInLines(Text text, GroupsMask groups,
+                                   LineMatchMode mode,
+                                   OnFoundInLine&& on_found_in_line) const {
+    static_assert(LineTracker::kNewline < kAlphabetStart ||
+                      LineTracker::kNewline > kAlphabetEnd,
+                  "Substrings must not cross the lines");
+    assert(is_ready_);
+    LineTracker line_tracker(text);
+    auto report = [&](const FoundSubstringInfo& info) {
+        line_tracker.AdvanceTo(info.substring_start_index);
+        on_found_in_line(FoundInLineInfo{
+            .substring        = info,
+            .line_index       = line_tracker.LineIndex(),
+            .line_start_index = line_tracker.LineStartIndex(),
+        });
+    };
+    if (mode == LineMatchMode::kAllSubstrings) {
+        ScanText(text, groups, IsPrefilterActive(), report,
+                 [](VertexIndex) constexpr noexcept {});
+        return;
+    }
+
+    // Like WalkText(), but the scan jumps to the next line after the first
+    //  found substring
+    const bool use_prefilter       = IsPrefilterActive();
+    VertexIndex current_node_index = kRootIndex;
+    for (std::size_t i = 0; i < text.size(); i++) {
+        if (use_prefilter && current_node_index == kRootIndex &&
+            !first_symbol_prefilter_.IsCandidate(text[i])) {
+            i = first_symbol_prefilter_.FindNextCandidate(text, i);
+            if (i == text.size()) {
+                break;
+            }
+        }
+
+        VertexIndex symbol_index = SymbolToIndex(text[i]);
+        current_node_index       = symbol_index < kAlphabetLength
+                                       ? nodes_[current_node_index][symbol_index]
+                                       : kRootIndex;
+        assert(current_node_index != kNullNodeIndex);
+        bool is_found  = false;
+        auto on_output = [&](VertexIndex terminal_node_index) {
+            if (!is_found) {
+                is_found = true;
+                report(MakeFoundSubstringInfo(terminal_node_index, i, text));
+            }
+        };
+        ForEachOutput(current_node_index, groups, on_output);
+        if (is_found) {
+            // Newline leads to the root
+            i = std::min(text.find(LineTracker::kNewline, i + 1), text.size());
+            current_node_index = kRootIndex;
+        }
+    }
+}
+
+inline std::optional<ACTrie::FoundSubstringInfo> ACTrie::FindNextSubstring(
+    Text text, GroupsMask groups, ScanCursor& cursor) const {
+    const std::optional<VertexIndex> terminal_node_index =
+        FindNextOutput(text, groups, cursor);
+    if (!terminal_node_index) {
+        return std::nullopt;
+    }
+    return MakeFoundSubstringInfo(*terminal_node_index, cursor.position - 1,
+                                  text);
+}
+
+inline std::optional<ACTrie::FoundInStreamInfo> ACTrie::FindNextInStream(
+    Text part, GroupsMask groups, ScanCursor& cursor) const {
+    const std::optional<VertexIndex> terminal_node_index =
+        FindNextOutput(part, groups, cursor);
+    if (!terminal_node_index) {
+        cursor.position = 0;
+        return std::nullopt;
+    }
+    const WordLength word_index = nodes_[*terminal_node_index].word_index;
+    assert(word_index < words_lengths_.size());
+    return FoundInStreamInfo{
+        .end_index  = cursor.position,
+        .word_index = word_index,
+        .length     = words_lengths_[word_index],
+    };
+}
+
+inline std::optional<ACTrie::VertexIndex> ACTrie::FindNextOutput(
+    Text text, GroupsMask groups, ScanCursor& cursor) const {
+    assert(is_ready_);
+    std::optional<VertexIndex> found_node_index;
+    auto on_output = [&found_node_index](VertexIndex terminal_node_index) {
+        found_node_index = terminal_node_index;
+    };
+    ScanTextPart(text, groups, IsPrefilterActive(),
+                 ScanBudget{.max_found_substrings_count = 1}, cursor,
+                 on_output, [](VertexIndex) constexpr noexcept {});
+    return found_node_index;
+}
+
+/// @brief Like ScanText(), but starts from the cursor and stops when the
+///         budget is spent. on_output(terminal_node_index) is called when
+///         the cursor is just after the end of the word.
+template <class OnOutput, class OnPassingThrough>
+bool ACTrie::ScanTextPart(Text text, GroupsMask groups, bool use_prefilter,
+                          ScanBudget budget, ScanCursor& cursor,
+                          OnOutput& on_output,
+                          OnPassingThrough on_passing_through) const {
+    assert(budget.max_symbols_count != 0 &&
+           budget.max_found_substrings_count != 0);
+    assert(cursor.position <= text.size());
+    if (cursor.position == 0 && cursor.node_index == kRootIndex) {
+        on_passing_through(kRootIndex);
+    }
+
+    std::size_t found_substrings_count = 0;
+    // Returns false if the budget is spent
+    auto report_output = [&](VertexIndex terminal_node_index) {
+        on_output(terminal_node_index);
+        return ++found_substrings_count != budget.max_found_substrings_count;
+    };
+    // Rest of the output chain, like in ForEachOutput()
+    auto report_outputs = [&]() {
+        while (cursor.output_node_index != kRootIndex) {
+            const VertexIndex node_index = cursor.output_node_index;
+            assert(node_index != kNullNodeIndex);
+            const ACTNode& node = nodes_[node_index];
+            if ((node.output_groups & groups) == 0) {
+                cursor.output_node_index = kRootIndex;
+                break;
+            }
+
+            cursor.output_node_index = node.compressed_suffix_link;
+            if (node.IsTerminal() &&
+                (words_groups_[node.word_index] & groups) != 0 &&
+                !report_output(node_index)) {
+                return false;
+            }
+        }
+        return true;
+    };
+    if (!report_outputs()) {
+        return false;
+    }
+
+    const std::size_t end =
+        text.size() - cursor.position > budget.max_symbols_count
+            ? cursor.position + budget.max_symbols_count
+            : text.size();
+    const Text scanned_text        = text.substr(0, end);
+    VertexIndex current_node_index = cursor.node_index;
+    // Like WalkText()
+    for (std::size_t i = cursor.position; i < end; i++) {
+        if (use_prefilter && current_node_index == kRootIndex &&
+            !first_symbol_prefilter_.IsCandidate(text[i])) {
+            i = first_symbol_prefilter_.FindNextCandidate(scanned_text, i);
+            if (i == end) {
+                break;
+            }
+        }
+
+        VertexIndex symbol_index = SymbolToIndex(text[i]);
+        current_node_index       = symbol_index < kAlphabetLength
+                                       ? nodes_[current_node_index][symbol_index]
+                                       : kRootIndex;
+        assert(current_node_index != kNullNodeIndex);
+        on_passing_through(current_node_index);
+        if ((nodes_[current_node_index].output_groups & groups) != 0) {
+            cursor.node_index = current_node_index;
+            cursor.position   = i + 1;
+            if (current_node_index == kRootIndex) {
+                // The empty pattern ends at the root, which ends the output
+                //  chains, so the resumed scan does not report it again
+                if (!report_output(kRootIndex)) {
+                    return false;
+                }
+                continue;
+            }
+            cursor.output_node_index = current_node_index;
+            if (!report_outputs()) {
+                return false;
+            }
+        }
+    }
+    cursor.node_index = current_node_index;
+    cursor.position   = end;
+    return end == text.size();
+}
+
+/// @brief Calls on_node(node_index, position_in_text) for each symbol of
+///         the text except the ones skipped by the prefilter.
+template <class OnNode>
+void ACTrie::WalkText(Text text, bool use_prefilter, OnNode& on_node) const {
+    VertexIndex current_node_index = kRootIndex;
+    for (std::size_t i = 0; i < text.size(); i++) {
+        if (use_prefilter && current_node_index == kRootIndex &&
+            !first_symbol_prefilter_.IsCandidate(text[i])) {
+            i = first_symbol_prefilter_.FindNextCandidate(text, i);
+            if (i == text.size()) {
+                break;
+            }
+        }
+
+        VertexIndex symbol_index = SymbolToIndex(text[i]);
+        current_node_index       = symbol_index < kAlphabetLength
+                                       ? nodes_[current_node_index][symbol_index]
+                                       : kRootIndex;
+        assert(current_node_index != kNullNodeIndex);
+        on_node(current_node_index, i);
+    }
+}
+
+/// @brief Calls on_output(terminal_node_index) for the node and for each
+///         node of its output chain where a word from the groups ends.
+template <class OnOutput>
+void ACTrie::ForEachOutput(VertexIndex node_index, GroupsMask groups,
+                           OnOutput& on_output) const {
+    const ACTNode& node = nodes_[node_index];
+    if ((node.output_groups & groups) == 0) {
+        return;
+    }
+
+    if (node.IsTerminal() && (words_groups_[node.word_index] & groups) != 0) {
+        on_output(node_index);
+    }
+
+    // Outputs of the rest of the chain are included in the
+    //  output_groups of its first node.
+    for (VertexIndex terminal_node_index = node.compressed_suffix_link;
+         terminal_node_index != kRootIndex &&
+         (nodes_[terminal_node_index].output_groups & groups) != 0;
+         terminal_node_index =
+             nodes_[terminal_node_index].compressed_suffix_link) {
+        assert(terminal_node_index != kNullNodeIndex);
+        const ACTNode& terminal_node = nodes_[terminal_node_index];
+        assert(terminal_node.IsTerminal());
+        if ((words_groups_[terminal_node.word_index] & groups) != 0) {
+            on_output(terminal_node_index);
+        }
+    }
+}
+
+template <class OnFoundSubstring, class OnPassingThrough>
+void ACTrie::ScanText(Text text, GroupsMask groups, bool use_prefilter,
+                      OnFoundSubstring& on_found_substring,
+                      OnPassingThrough on_passing_through) const {
+    on_passing_through(kRootIndex);
+    auto on_node = [&](VertexIndex current_node_index, std::size_t i) {
+        on_passing_through(current_node_index);
+        auto on_output = [&](VertexIndex terminal_node_index) {
+            on_found_substring(
+                MakeFoundSubstringInfo(terminal_node_index, i, text));
+        };
+        ForEachOutput(current_node_index, groups, on_output);
+    };
+    WalkText(text, use_prefilter, on_node);
+}
+
+inline ACTrie::FoundSubstringInfo ACTrie::MakeFoundSubstringInfo(
+    VertexIndex current_node_index, std::size_t position_in_text,
+    Text text) const noexcept {
+    auto word_index = nodes_[current_node_index].word_index;
+    assert(word_index < words_lengths_.size());
+    auto word_length         = words_lengths_[word_index];
+    auto word_start_position = position_in_text + 1 - word_length;
+    return FoundSubstringInfo{
+        .found_substring       = text.substr(word_start_position, word_length),
+        .substring_start_index = word_start_position,
+        .current_vertex_index  = current_node_index,
+        .word_index            = word_index,
+    };
+}
+
+constexpr std::size_t ACTrie::BuildThreadsCount() const noexcept {
+    return build_threads_count_;
+}
+
 constexpr std::size_t ACTrie::NodesSize() const noexcept {
     return nodes_.size();
 }
@@ -156,6 +732,10 @@ constexpr std::size_t ACTrie::PatternsSize() const noexcept {
     return words_lengths_.size();
 }
 
+constexpr ACTrie::WordLength ACTrie::MaxPatternLength() const noexcept {
+    return max_word_length_;
+}
+
 constexpr ACTrie::VertexIndex ACTrie::SymbolToIndex(char symbol) noexcept {
     std::int32_t symbol_as_int = static_cast<std::uint8_t>(symbol);
     if constexpr (kIsCaseInsensitive) {
@@ -4,10 +4,24 @@ namespace AppSpace {
 
 ACTrieController::ACTrieController(ACTrieModel* host_model)
     : model_(host_model),
-      pattern_port_([this](Pattern pattern) { model_->AddPattern(pattern); }),
-      text_port_([this](Text text) { model_->FindAllSubstringsInText(text); }),
-      actrie_reset_port_([this]() { model_->ResetACTrie(); }),
-      actrie_build_port_([this]() { model_->BuildACTrie(); }) {}
+      pattern_port_([this](Pattern pattern) {
+          // Nodes of the cursor are changed by the new pattern
+          CancelTextScan();
+          model_->AddPattern(pattern);
+      }),
+      text_port_([this](Text text) {
+          pending_text_.assign(text);
+          text_cursor_ = {};
+          OnNewFrame();
+      }),
+      actrie_reset_port_([this]() {
+          CancelTextScan();
+          model_->ResetACTrie();
+      }),
+      actrie_build_port_([this]() {
+          CancelTextScan();
+          model_->BuildACTrie();
+      }) {}
 
 ACTrieController::PatternObserver*
 ACTrieController::GetPatternObserverPort() noexcept {
@@ -29,4 +43,19 @@ ACTrieController::GetACTrieBuildObserverPort() noexcept {
     return &actrie_build_port_;
 }
 
+void ACTrieController::OnNewFrame() {
+    if (pending_text_.empty()) {
+        return;
+    }
+    if (model_->FindAllSubstringsInText(pending_text_, text_cursor_,
+                                        kFrameScanBudget)) {
+        CancelTextScan();
+    }
+}
+
+void ACTrieController::CancelTextScan() noexcept {
+    pending_text_.clear();
+    text_cursor_ = {};
+}
+
 }  // namespace AppSpace
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <string>
+
 #include "ACTrie.hpp"
 #include "Observer.hpp"
 
@@ -21,9 +23,23 @@ public:
     TextObserver* GetTextObserverPort() noexcept;
     ACTrieResetObserver* GetACTrieResetObserverPort() noexcept;
     ACTrieBuildObserver* GetACTrieBuildObserverPort() noexcept;
+    /// @brief Continues the scan of the last text by one budget, so a huge
+    ///         text does not block the frame. Called once per frame.
+    void OnNewFrame();
 
 private:
+    // Budget of the text scan in one frame
+    static constexpr ACTrieModel::ScanBudget kFrameScanBudget{
+        .max_symbols_count          = 1 << 12,
+        .max_found_substrings_count = 1 << 8,
+    };
+
+    void CancelTextScan() noexcept;
+
     ACTrieModel* model_ = nullptr;
+    // Copy of the text being scanned, the text from the view is temporary
+    std::string pending_text_;
+    ACTrieModel::ScanCursor text_cursor_;
     PatternObserver pattern_port_;
     TextObserver text_port_;
     ACTrieResetObserver actrie_reset_port_;
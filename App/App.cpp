@@ -16,7 +16,11 @@ App::App() : view_(imgui_facade_.GetWindowSize()), model_controller_(&model_) {
 }
 
 void App::Run() {
-    imgui_facade_.StartRuntimeLoop([&view = view_]() { view.OnNewFrame(); });
+    imgui_facade_.StartRuntimeLoop(
+        [&view = view_, &controller = model_controller_]() {
+            controller.OnNewFrame();
+            view.OnNewFrame();
+        });
 }
 
 }  // namespace AppSpace
@@ -0,0 +1,168 @@
+#include "ApproximateMatcher.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <string_view>
+
+namespace AppSpace::ACTrieDS {
+
+static_assert(!ACTrie::kIsCaseInsensitive,
+              "ApproximateMatcher compares symbols case sensitively");
+
+ApproximateMatcher::ApproximateMatcher(std::size_t max_mismatches) noexcept
+    : max_mismatches_(max_mismatches) {}
+
+ApproximateMatcher& ApproximateMatcher::AddPattern(Pattern pattern) {
+    assert(!is_ready_);
+    if (is_ready_) {
+        ResetApproximateMatcher();
+    }
+
+    if (const std::size_t bad_symbol_index =
+            StoredPatterns::FindBadSymbol(pattern);
+        bad_symbol_index != pattern.size()) {
+        bad_input_port_.Notify({bad_symbol_index, pattern[bad_symbol_index]});
+        return *this;
+    }
+    // Each fragment must have at least one symbol
+    if (!pattern.empty() && pattern.size() <= max_mismatches_) {
+        bad_input_port_.Notify({pattern.size() - 1, pattern.back()});
+        return *this;
+    }
+
+    patterns_.Add(pattern);
+    return *this;
+}
+
+ApproximateMatcher& ApproximateMatcher::BuildApproximateMatcher() {
+    assert(!is_ready_);
+    patterns_.DedupeKeepLast();
+
+    fragments_index_.Reset();
+    for (std::size_t i = 0; i < patterns_.size(); i++) {
+        const std::string_view pattern = patterns_[i].pattern;
+        for (std::size_t f = 0; f <= max_mismatches_; f++) {
+            const std::size_t begin = FragmentBegin(pattern.size(), f);
+            const std::size_t end   = FragmentBegin(pattern.size(), f + 1);
+            const std::string_view fragment =
+                pattern.substr(begin, end - begin);
+            fragments_index_.AddUse(
+                fragment,
+                FragmentUse{
+                    .pattern_index       = static_cast<std::uint32_t>(i),
+                    .fragment_index      = static_cast<WordLength>(f),
+                    .fragment_end_offset = static_cast<WordLength>(end),
+                });
+        }
+    }
+    fragments_index_.Build();
+    is_ready_ = true;
+    return *this;
+}
+
+ApproximateMatcher& ApproximateMatcher::ResetApproximateMatcher() {
+    is_ready_ = false;
+    patterns_.Clear();
+    fragments_index_.Reset();
+    return *this;
+}
+
+ApproximateMatcher& ApproximateMatcher::FindAllSubstringsInText(Text text) {
+    if (!is_ready_) {
+        BuildApproximateMatcher();
+    }
+    if (patterns_.empty()) {
+        return *this;
+    }
+
+    pending_substrings_.Clear();
+    fragments_index_.FindAllFragmentsInText(
+        text, [this, text](const FoundSubstringInfo& fragment_info) {
+            const std::size_t fragment_end =
+                fragment_info.substring_start_index +
+                fragment_info.found_substring.size();
+            // Fragments are found by the end position, so the substrings
+            //  found later end at or after the fragment_end
+            NotifyAboutPendingSubstrings(fragment_end - 1);
+            for (const FragmentUse& use :
+                 fragments_index_.Uses(fragment_info.word_index)) {
+                VerifyCandidate(text, fragment_end, use);
+            }
+        });
+    NotifyAboutPendingSubstrings(text.size());
+    return *this;
+}
+
+ApproximateMatcher& ApproximateMatcher::AddSubscriber(
+    FoundSubstringObserver* observer) {
+    found_substrings_port_.Subscribe(observer);
+    return *this;
+}
+
+ApproximateMatcher& ApproximateMatcher::AddSubscriber(
+    FoundApproximateObserver* observer) {
+    found_approximate_port_.Subscribe(observer);
+    return *this;
+}
+
+ApproximateMatcher& ApproximateMatcher::AddSubscriber(
+    BadInputPatternObserver* observer) {
+    bad_input_port_.Subscribe(observer);
+    return *this;
+}
+
+void ApproximateMatcher::VerifyCandidate(Text text, std::size_t fragment_end,
+                                         const FragmentUse& use) {
+    if (fragment_end < use.fragment_end_offset) {
+        return;
+    }
+    const StoredPattern& stored_pattern = patterns_[use.pattern_index];
+    const std::string_view pattern      = stored_pattern.pattern;
+    const std::size_t start = fragment_end - use.fragment_end_offset;
+    if (text.size() - start < pattern.size()) {
+        return;
+    }
+
+    std::size_t mismatches_count = 0;
+    for (std::size_t f = 0; f <= max_mismatches_; f++) {
+        if (f == use.fragment_index) {
+            continue;
+        }
+        std::size_t fragment_mismatches_count = 0;
+        for (std::size_t i = FragmentBegin(pattern.size(), f);
+             i < FragmentBegin(pattern.size(), f + 1); i++) {
+            if (pattern[i] != text[start + i]) {
+                fragment_mismatches_count++;
+            }
+        }
+        // Substring is reported by its first unchanged fragment
+        if (fragment_mismatches_count == 0 && f < use.fragment_index) {
+            return;
+        }
+        mismatches_count += fragment_mismatches_count;
+        if (mismatches_count > max_mismatches_) {
+            return;
+        }
+    }
+
+    pending_substrings_.Push(FoundApproximateInfo{
+        .substring =
+            FoundSubstringInfo{
+                .found_substring       = text.substr(start, pattern.size()),
+                .substring_start_index = start,
+                .current_vertex_index  = ACTrie::kNullNodeIndex,
+                .word_index            = stored_pattern.word_index,
+            },
+        .mismatches_count = static_cast<WordLength>(mismatches_count),
+    });
+}
+
+void ApproximateMatcher::NotifyAboutPendingSubstrings(std::size_t end_bound) {
+    pending_substrings_.PopEndingBefore(
+        end_bound, [this](const FoundApproximateInfo& info) {
+            found_substrings_port_.Notify(info.substring);
+            found_approximate_port_.Notify(info);
+        });
+}
+
+}  // namespace AppSpace::ACTrieDS
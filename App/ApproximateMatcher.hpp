@@ -0,0 +1,123 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "ACTrie.hpp"
+#include "FragmentsIndex.hpp"
+#include "Observer.hpp"
+#include "PendingSubstrings.hpp"
+#include "StoredPatterns.hpp"
+
+namespace AppSpace::ACTrieDS {
+
+/// @brief Finds the substrings of the text which differ from the patterns in
+///         at most max_mismatches symbols (Hamming distance), for the
+///         inputs with typos or recognition errors.
+///
+///  Variants of the patterns are not generated (there are
+///   C(m, k) * (alphabet - 1)^k of them per pattern). By the pigeonhole
+///   principle, when the pattern is split into k + 1 fragments, a substring
+///   with at most k mismatches contains at least one of the fragments
+///   unchanged. The fragments are found exactly by one ACTrie, each found
+///   fragment gives the candidate start of the pattern, which is verified by
+///   counting the mismatches. Candidate is reported only by its first
+///   unchanged fragment, so each substring is reported once without
+///   remembering the reported ones.
+///
+///  Has the same interface for adding patterns and reporting found substrings
+///   as the ACTrie and reports substrings in the same order (by the end
+///   position, longer first). current_vertex_index of the found substring is
+///   always ACTrie::kNullNodeIndex. Number of the mismatches is reported to
+///   the subscribers of FoundApproximateInfo. Unlike the ACTrie, it never
+///   reports the empty pattern (see StoredPatterns).
+class ApproximateMatcher final {
+public:
+    using WordLength                = ACTrie::WordLength;
+    using Pattern                   = ACTrie::Pattern;
+    using Text                      = ACTrie::Text;
+    using FoundSubstringInfo        = ACTrie::FoundSubstringInfo;
+    using BadInputPatternInfo       = ACTrie::BadInputPatternInfo;
+    using FoundSubstringInfoPassBy  = ACTrie::FoundSubstringInfoPassBy;
+    using BadInputPatternInfoPassBy = ACTrie::BadInputPatternInfoPassBy;
+    using FoundSubstringObserver    = ACTrie::FoundSubstringObserver;
+    using BadInputPatternObserver   = ACTrie::BadInputPatternObserver;
+
+    struct FoundApproximateInfo {
+        FoundSubstringInfo substring;
+        // Number of the positions where the substring differs from the
+        //  pattern, at most MaxMismatches()
+        WordLength mismatches_count;
+    };
+    using FoundApproximateInfoPassBy = FoundApproximateInfo;
+    using FoundApproximateObserver =
+        Observer<FoundApproximateInfo, FoundApproximateInfoPassBy>;
+
+    static constexpr std::size_t kDefaultMaxMismatches = 1;
+
+    explicit ApproximateMatcher(
+        std::size_t max_mismatches = kDefaultMaxMismatches) noexcept;
+
+    /// @brief Adds pattern to the set. Non empty pattern not longer than
+    ///         max_mismatches would be found at each position of the text, it
+    ///         is reported as bad input at its last symbol.
+    /// @param pattern
+    ApproximateMatcher& AddPattern(Pattern pattern);
+    ApproximateMatcher& BuildApproximateMatcher();
+    ApproximateMatcher& ResetApproximateMatcher();
+    ApproximateMatcher& FindAllSubstringsInText(Text text);
+    ApproximateMatcher& AddSubscriber(FoundSubstringObserver* observer);
+    ApproximateMatcher& AddSubscriber(FoundApproximateObserver* observer);
+    ApproximateMatcher& AddSubscriber(BadInputPatternObserver* observer);
+    constexpr std::size_t MaxMismatches() const noexcept;
+    constexpr std::size_t PatternsSize() const noexcept;
+    /// @brief Number of the distinct fragments, valid after the build.
+    constexpr std::size_t FragmentsSize() const noexcept;
+
+private:
+    struct FragmentUse final {
+        std::uint32_t pattern_index;
+        // Index of the fragment in the pattern
+        WordLength fragment_index;
+        // Offset of the symbol after the fragment in the pattern
+        WordLength fragment_end_offset;
+    };
+
+    constexpr std::size_t FragmentBegin(
+        std::size_t pattern_length, std::size_t fragment_index) const noexcept;
+    void VerifyCandidate(Text text, std::size_t fragment_end,
+                         const FragmentUse& use);
+    void NotifyAboutPendingSubstrings(std::size_t end_bound);
+
+    std::size_t max_mismatches_;
+    StoredPatterns patterns_;
+    FragmentsIndex<FragmentUse> fragments_index_;
+    bool is_ready_ = false;
+    BasicPendingSubstrings<FoundApproximateInfo> pending_substrings_;
+    Observable<FoundSubstringInfo, FoundSubstringInfoPassBy>
+        found_substrings_port_;
+    Observable<FoundApproximateInfo, FoundApproximateInfoPassBy>
+        found_approximate_port_;
+    Observable<BadInputPatternInfo, BadInputPatternInfoPassBy> bad_input_port_;
+};
+
+constexpr std::size_t ApproximateMatcher::MaxMismatches() const noexcept {
+    return max_mismatches_;
+}
+
+constexpr std::size_t ApproximateMatcher::PatternsSize() const noexcept {
+    return patterns_.AddedSize();
+}
+
+constexpr std::size_t ApproximateMatcher::FragmentsSize() const noexcept {
+    return fragments_index_.FragmentsSize();
+}
+
+/// @brief Fragments of the pattern have almost equal lengths, the i-th one
+///         starts at pattern_length * i / (k + 1).
+constexpr std::size_t ApproximateMatcher::FragmentBegin(
+    std::size_t pattern_length, std::size_t fragment_index) const noexcept {
+    return pattern_length * fragment_index / (max_mismatches_ + 1);
+}
+
+}  // namespace AppSpace::ACTrieDS
@@ -0,0 +1,202 @@
+#include "AutoMatcher.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <limits>
+
+namespace AppSpace::ACTrieDS {
+
+AutoMatcher::AutoMatcher()
+    : found_substrings_relay_([this](FoundSubstringInfoPassBy info) {
+          found_substrings_port_.Notify(info);
+      }) {}
+
+AutoMatcher& AutoMatcher::AddPattern(Pattern pattern) {
+    assert(!is_ready_);
+    if (is_ready_) {
+        ResetAutoMatcher();
+    }
+
+    for (std::size_t i = 0; i < pattern.size(); i++) {
+        const char symbol = pattern[i];
+        if (ACTrie::SymbolToIndex(symbol) >= ACTrie::kAlphabetLength) {
+            bad_input_port_.Notify({i, symbol});
+            return *this;
+        }
+    }
+
+    patterns_.emplace_back(pattern);
+    return *this;
+}
+
+AutoMatcher& AutoMatcher::BuildAutoMatcher() {
+    assert(!is_ready_);
+    statistics_    = ComputeStatistics(patterns_);
+    chosen_engine_ = ChooseEngine(statistics_);
+    switch (chosen_engine_) {
+        case Engine::kACTrie:
+        case Engine::kACTrieWithPrefilter:
+            BuildEngine<ACTrie>();
+            std::get<ACTrie>(engine_)
+                .SetPrefilterEnabled(chosen_engine_ ==
+                                     Engine::kACTrieWithPrefilter)
+                .BuildACTrie();
+            break;
+        case Engine::kTeddy:
+            BuildEngine<TeddyMatcher>();
+            std::get<TeddyMatcher>(engine_).BuildTeddyMatcher();
+            break;
+        case Engine::kShiftAnd:
+            BuildEngine<ShiftAndMatcher>();
+            std::get<ShiftAndMatcher>(engine_).BuildShiftAndMatcher();
+            break;
+        case Engine::kWuManber:
+            BuildEngine<WuManberMatcher>();
+            std::get<WuManberMatcher>(engine_).BuildWuManberMatcher();
+            break;
+    }
+
+    is_ready_ = true;
+    return *this;
+}
+
+AutoMatcher& AutoMatcher::ResetAutoMatcher() {
+    is_ready_ = false;
+    patterns_.clear();
+    statistics_ = PatternsStatistics{};
+    engine_.emplace<std::monostate>();
+    return *this;
+}
+
+AutoMatcher& AutoMatcher::FindAllSubstringsInText(Text text) {
+    if (!is_ready_) {
+        BuildAutoMatcher();
+    }
+
+    std::visit(
+        [text]<class Matcher>(Matcher& matcher) {
+            if constexpr (!std::is_same_v<Matcher, std::monostate>) {
+                matcher.FindAllSubstringsInText(text);
+            }
+        },
+        engine_);
+    return *this;
+}
+
+AutoMatcher& AutoMatcher::AddSubscriber(FoundSubstringObserver* observer) {
+    found_substrings_port_.Subscribe(observer);
+    return *this;
+}
+
+AutoMatcher& AutoMatcher::AddSubscriber(BadInputPatternObserver* observer) {
+    bad_input_port_.Subscribe(observer);
+    return *this;
+}
+
+AutoMatcher::PatternsStatistics AutoMatcher::ComputeStatistics(
+    const std::vector<std::string>& patterns) {
+    PatternsStatistics statistics{
+        .patterns_size         = patterns.size(),
+        .min_pattern_length    = patterns.empty()
+                                     ? 0
+                                     : std::numeric_limits<std::size_t>::max(),
+        .max_pattern_length    = 0,
+        .patterns_total_length = 0,
+        .used_symbols_size     = 0,
+        .first_symbols_size    = 0,
+        .trie_nodes_size       = 0,
+    };
+
+    std::array<bool, ACTrie::kAlphabetLength> used_symbols{};
+    std::array<bool, ACTrie::kAlphabetLength> first_symbols{};
+    for (const std::string& pattern : patterns) {
+        statistics.min_pattern_length =
+            std::min(statistics.min_pattern_length, pattern.size());
+        statistics.max_pattern_length =
+            std::max(statistics.max_pattern_length, pattern.size());
+        statistics.patterns_total_length += pattern.size();
+        for (char symbol : pattern) {
+            used_symbols[ACTrie::SymbolToIndex(symbol)] = true;
+        }
+        if (!pattern.empty()) {
+            first_symbols[ACTrie::SymbolToIndex(pattern.front())] = true;
+        }
+    }
+    statistics.used_symbols_size = static_cast<std::size_t>(
+        std::count(used_symbols.begin(), used_symbols.end(), true));
+    statistics.first_symbols_size = static_cast<std::size_t>(
+        std::count(first_symbols.begin(), first_symbols.end(), true));
+
+    // Each pattern adds to the trie as many nodes as the number of its
+    //  symbols not shared with the previous pattern in the sorted order.
+    std::vector<std::string_view> sorted_patterns(patterns.begin(),
+                                                  patterns.end());
+    std::sort(sorted_patterns.begin(), sorted_patterns.end());
+    std::string_view previous_pattern;
+    for (std::string_view pattern : sorted_patterns) {
+        const auto [pattern_iter, previous_iter] =
+            std::mismatch(pattern.begin(), pattern.end(),
+                          previous_pattern.begin(), previous_pattern.end());
+        statistics.trie_nodes_size +=
+            static_cast<std::size_t>(pattern.end() - pattern_iter);
+        previous_pattern = pattern;
+    }
+
+    return statistics;
+}
+
+AutoMatcher::Engine AutoMatcher::ChooseEngine(
+    const PatternsStatistics& statistics) noexcept {
+    // Only the ACTrie reports empty patterns
+    if (statistics.patterns_size == 0 || statistics.min_pattern_length == 0) {
+        return Engine::kACTrie;
+    }
+    if (statistics.min_pattern_length >= kTeddyMinPatternLength &&
+        (statistics.patterns_size <= kTeddySmallPatternsSize ||
+         (statistics.patterns_size <= kTeddyMaxPatternsSize &&
+          statistics.min_pattern_length < kWuManberLongPatternLength))) {
+        return Engine::kTeddy;
+    }
+    if (statistics.min_pattern_length >= kWuManberMinPatternLength ||
+        (statistics.trie_nodes_size >= kWuManberLargeTrieNodesSize &&
+         statistics.min_pattern_length >=
+             kWuManberLargeTrieMinPatternLength)) {
+        return Engine::kWuManber;
+    }
+    if (statistics.first_symbols_size <= kPrefilterMaxFirstSymbols) {
+        return Engine::kACTrieWithPrefilter;
+    }
+    if (statistics.patterns_total_length <=
+        ShiftAndMatcher::kMaxPatternsTotalLength) {
+        return Engine::kShiftAnd;
+    }
+    return Engine::kACTrie;
+}
+
+std::string_view AutoMatcher::EngineName(Engine engine) noexcept {
+    switch (engine) {
+        case Engine::kACTrie:
+            return "ACTrie";
+        case Engine::kACTrieWithPrefilter:
+            return "ACTrie with prefilter";
+        case Engine::kTeddy:
+            return "TeddyMatcher";
+        case Engine::kShiftAnd:
+            return "ShiftAndMatcher";
+        case Engine::kWuManber:
+            return "WuManberMatcher";
+    }
+    return "";
+}
+
+template <class Matcher>
+void AutoMatcher::BuildEngine() {
+    Matcher& matcher = engine_.emplace<Matcher>();
+    matcher.AddSubscriber(&found_substrings_relay_);
+    for (std::string_view pattern : patterns_) {
+        matcher.AddPattern(pattern);
+    }
+}
+
+}  // namespace AppSpace::ACTrieDS
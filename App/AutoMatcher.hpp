@@ -0,0 +1,129 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <variant>
+#include <vector>
+
+#include "ACTrie.hpp"
+#include "Observer.hpp"
+#include "ShiftAndMatcher.hpp"
+#include "TeddyMatcher.hpp"
+#include "WuManberMatcher.hpp"
+
+namespace AppSpace::ACTrieDS {
+
+/// @brief Facade over the ACTrie and the other matchers which chooses the
+///         matcher by the statistics of the added patterns when it is built.
+///
+///  Has the same interface for adding patterns and reporting found substrings
+///   as the ACTrie, found substrings do not depend on the chosen matcher
+///   (except for current_vertex_index, which is set only by the ACTrie).
+///  Thresholds are calibrated by the "engine selection" benchmark in the
+///   Tests/benchmarks.cpp and should be updated together with it.
+class AutoMatcher final {
+public:
+    using WordLength                = ACTrie::WordLength;
+    using Pattern                   = ACTrie::Pattern;
+    using Text                      = ACTrie::Text;
+    using FoundSubstringInfo        = ACTrie::FoundSubstringInfo;
+    using BadInputPatternInfo       = ACTrie::BadInputPatternInfo;
+    using FoundSubstringInfoPassBy  = ACTrie::FoundSubstringInfoPassBy;
+    using BadInputPatternInfoPassBy = ACTrie::BadInputPatternInfoPassBy;
+    using FoundSubstringObserver    = ACTrie::FoundSubstringObserver;
+    using BadInputPatternObserver   = ACTrie::BadInputPatternObserver;
+
+    enum class Engine {
+        // Dense transitions table of the ACTrie
+        kACTrie,
+        // ACTrie which skips symbols that can not start a pattern
+        kACTrieWithPrefilter,
+        // Packed SIMD matcher
+        kTeddy,
+        // Bit-parallel matcher
+        kShiftAnd,
+        // Block-shift matcher
+        kWuManber,
+    };
+
+    struct PatternsStatistics final {
+        std::size_t patterns_size         = 0;
+        std::size_t min_pattern_length    = 0;
+        std::size_t max_pattern_length    = 0;
+        std::size_t patterns_total_length = 0;
+        // Number of distinct symbols used in the patterns
+        std::size_t used_symbols_size = 0;
+        // Number of distinct first symbols of the patterns
+        std::size_t first_symbols_size = 0;
+        // Number of the nodes of the trie of the patterns (without the
+        //  service nodes of the ACTrie)
+        std::size_t trie_nodes_size = 0;
+    };
+
+    // Teddy fingerprint of 1 symbol gives too many false candidates
+    static constexpr std::size_t kTeddyMinPatternLength = 2;
+    // Up to that many patterns Teddy wins regardless of the pattern lengths
+    static constexpr std::size_t kTeddySmallPatternsSize = 16;
+    // Up to that many patterns Teddy wins unless Wu-Manber shifts are long
+    static constexpr std::size_t kTeddyMaxPatternsSize      = 32;
+    static constexpr std::size_t kWuManberLongPatternLength = 16;
+    // Wu-Manber wins when the average shift is large enough
+    static constexpr std::size_t kWuManberMinPatternLength = 6;
+    // With many patterns the trie stops fitting into the L1 cache
+    //  and Wu-Manber wins with the shorter patterns too
+    static constexpr std::size_t kWuManberLargeTrieNodesSize       = 256;
+    static constexpr std::size_t kWuManberLargeTrieMinPatternLength = 4;
+    // At most that many distinct first symbols let the prefilter of the
+    //  ACTrie skip most of the text
+    static constexpr std::size_t kPrefilterMaxFirstSymbols =
+        FirstSymbolPrefilter::kMaxSymbols;
+
+    AutoMatcher();
+    AutoMatcher& AddPattern(Pattern pattern);
+    AutoMatcher& BuildAutoMatcher();
+    AutoMatcher& ResetAutoMatcher();
+    AutoMatcher& FindAllSubstringsInText(Text text);
+    AutoMatcher& AddSubscriber(FoundSubstringObserver* observer);
+    AutoMatcher& AddSubscriber(BadInputPatternObserver* observer);
+    constexpr std::size_t PatternsSize() const noexcept;
+    /// @brief Matcher chosen on the last build. Valid only after the build.
+    constexpr Engine ChosenEngine() const noexcept;
+    constexpr const PatternsStatistics& Statistics() const noexcept;
+    static PatternsStatistics ComputeStatistics(
+        const std::vector<std::string>& patterns);
+    static Engine ChooseEngine(const PatternsStatistics& statistics) noexcept;
+    static std::string_view EngineName(Engine engine) noexcept;
+
+private:
+    template <class Matcher>
+    void BuildEngine();
+
+    std::vector<std::string> patterns_;
+    PatternsStatistics statistics_;
+    Engine chosen_engine_ = Engine::kACTrie;
+    bool is_ready_        = false;
+    std::variant<std::monostate, ACTrie, TeddyMatcher, ShiftAndMatcher,
+                 WuManberMatcher>
+        engine_;
+    FoundSubstringObserver found_substrings_relay_;
+    Observable<FoundSubstringInfo, FoundSubstringInfoPassBy>
+        found_substrings_port_;
+    Observable<BadInputPatternInfo, BadInputPatternInfoPassBy> bad_input_port_;
+};
+
+constexpr std::size_t AutoMatcher::PatternsSize() const noexcept {
+    return patterns_.size();
+}
+
+constexpr AutoMatcher::Engine AutoMatcher::ChosenEngine() const noexcept {
+    return chosen_engine_;
+}
+
+constexpr const AutoMatcher::PatternsStatistics& AutoMatcher::Statistics()
+    const noexcept {
+    return statistics_;
+}
+
+}  // namespace AppSpace::ACTrieDS
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+
+namespace AppSpace::ACTrieDS {
+
+/// @brief Lock-free queue of the fixed capacity for several producers and
+///         several consumers (the array of cells with the sequence numbers
+///         by D. Vyukov). TryPush() and TryPop() never block and never
+///         allocate.
+template <class T>
+class BoundedQueue final {
+    static_assert(std::is_nothrow_copy_assignable_v<T>);
+
+public:
+    /// @param capacity is rounded up to the power of two
+    explicit BoundedQueue(std::size_t capacity);
+    BoundedQueue(const BoundedQueue&)            = delete;
+    BoundedQueue& operator=(const BoundedQueue&) = delete;
+
+    /// @brief Returns false if the cell at the push position still holds
+    ///         the value pushed one lap ago. It happens when the queue is
+    ///         full, but also for a while when it is not: a consumer that
+    ///         claimed the cell may be preempted before it frees the cell, so
+    ///         the caller expecting the room should retry.
+    bool TryPush(const T& value) noexcept;
+    bool TryPop(T& value) noexcept;
+    /// @brief Number of the values in the queue at some moment during the
+    ///         call, exact only if nobody pushes or pops at the same time.
+    std::size_t ApproximateSize() const noexcept;
+    constexpr std::size_t Capacity() const noexcept;
+
+private:
+    static constexpr std::size_t kCacheLineSize = 64;
+
+    struct Cell final {
+        // Equals position if the cell is free for the push at position,
+        //  position + 1 if it holds the value pushed at position
+        std::atomic<std::size_t> sequence;
+        T value;
+    };
+
+    std::unique_ptr<Cell[]> cells_;
+    std::size_t capacity_mask_;
+    // Producers and consumers do not share cache lines
+    alignas(kCacheLineSize) std::atomic<std::size_t> push_position_{0};
+    alignas(kCacheLineSize) std::atomic<std::size_t> pop_position_{0};
+};
+
+template <class T>
+BoundedQueue<T>::BoundedQueue(std::size_t capacity)
+    : capacity_mask_(std::bit_ceil(std::max(capacity, std::size_t{1})) - 1) {
+    cells_ = std::make_unique<Cell[]>(capacity_mask_ + 1);
+    for (std::size_t i = 0; i <= capacity_mask_; i++) {
+        cells_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+}
+
+template <class T>
+bool BoundedQueue<T>::TryPush(const T& value) noexcept {
+    std::size_t position = push_position_.load(std::memory_order_relaxed);
+    while (true) {
+        Cell& cell = cells_[position & capacity_mask_];
+        const std::size_t sequence =
+            cell.sequence.load(std::memory_order_acquire);
+        if (sequence == position) {
+            if (push_position_.compare_exchange_weak(
+                    position, position + 1, std::memory_order_relaxed)) {
+                cell.value = value;
+                cell.sequence.store(position + 1, std::memory_order_release);
+                return true;
+            }
+        } else if (sequence < position) {
+            // Cell still holds the value pushed one lap ago
+            return false;
+        } else {
+            position = push_position_.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+template <class T>
+bool BoundedQueue<T>::TryPop(T& value) noexcept {
+    std::size_t position = pop_position_.load(std::memory_order_relaxed);
+    while (true) {
+        Cell& cell = cells_[position & capacity_mask_];
+        const std::size_t sequence =
+            cell.sequence.load(std::memory_order_acquire);
+        if (sequence == position + 1) {
+            if (pop_position_.compare_exchange_weak(
+                    position, position + 1, std::memory_order_relaxed)) {
+                value = cell.value;
+                cell.sequence.store(position + capacity_mask_ + 1,
+                                    std::memory_order_release);
+                return true;
+            }
+        } else if (sequence < position + 1) {
+            // Value for this position is not pushed yet
+            return false;
+        } else {
+            position = pop_position_.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+template <class T>
+std::size_t BoundedQueue<T>::ApproximateSize() const noexcept {
+    const std::size_t pop_position =
+        pop_position_.load(std::memory_order_relaxed);
+    const std::size_t push_position =
+        push_position_.load(std::memory_order_relaxed);
+    return push_position > pop_position ? push_position - pop_position : 0;
+}
+
+template <class T>
+constexpr std::size_t BoundedQueue<T>::Capacity() const noexcept {
+    return capacity_mask_ + 1;
+}
+
+}  // namespace AppSpace::ACTrieDS
@@ -0,0 +1,361 @@
+#include "ClassPatternMatcher.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+namespace AppSpace::ACTrieDS {
+
+ClassPatternMatcher::ClassPatternMatcher(std::size_t max_states_size) noexcept
+    : max_states_size_(max_states_size), nodes_(1) {
+    assert(max_states_size_ >= 2);
+}
+
+ClassPatternMatcher& ClassPatternMatcher::AddPattern(Pattern pattern) {
+    assert(!is_ready_);
+    if (is_ready_) {
+        ResetClassPatternMatcher();
+    }
+
+    std::vector<std::uint32_t> sets;
+    if (!ParsePattern(pattern, sets)) {
+        return *this;
+    }
+
+    NodeIndex current_node_index = kRootIndex;
+    for (std::uint32_t set_index : sets) {
+        auto& children = nodes_[current_node_index].children;
+        auto iter      = std::ranges::find(
+            children, set_index, &std::pair<std::uint32_t, NodeIndex>::first);
+        if (iter != children.end()) {
+            current_node_index = iter->second;
+            continue;
+        }
+
+        const auto new_node_index = static_cast<NodeIndex>(nodes_.size());
+        children.emplace_back(set_index, new_node_index);
+        const WordLength depth = nodes_[current_node_index].depth + 1;
+        nodes_.emplace_back().depth = depth;
+        current_node_index          = new_node_index;
+    }
+
+    // Later addition of the same sequence of the sets overwrites the word
+    //  index of its node. Empty pattern ends at the root, which gets no
+    //  word index, so it only takes its index and is never reported.
+    const auto word_index = static_cast<WordLength>(patterns_size_++);
+    if (current_node_index != kRootIndex) {
+        nodes_[current_node_index].word_index = word_index;
+    }
+    return *this;
+}
+
+ClassPatternMatcher& ClassPatternMatcher::BuildClassPatternMatcher() {
+    assert(!is_ready_);
+    ComputeSymbolsClasses();
+    ClearStates();
+    states_flushes_count_ = 0;
+    // States are numbered in the BFS order, the states that do not fit are
+    //  built by the scans
+    is_fully_compiled_ = true;
+    for (StateIndex state = kStartState;
+         state < StatesSize() && is_fully_compiled_; state++) {
+        for (std::size_t c = 0; c < SymbolsClassesSize(); c++) {
+            if (ComputeTransition(state, static_cast<SymbolClass>(c),
+                                  false) == kUnknownState) {
+                is_fully_compiled_ = false;
+                break;
+            }
+        }
+    }
+    is_ready_ = true;
+    return *this;
+}
+
+ClassPatternMatcher& ClassPatternMatcher::ResetClassPatternMatcher() {
+    is_ready_ = false;
+    sets_.clear();
+    sets_indexes_.clear();
+    nodes_.assign(1, Node{});
+    classes_representatives_.clear();
+    transitions_.clear();
+    states_nodes_offsets_.clear();
+    states_nodes_.clear();
+    outputs_offsets_.clear();
+    outputs_.clear();
+    states_indexes_.clear();
+    states_flushes_count_ = 0;
+    patterns_size_        = 0;
+    is_fully_compiled_    = false;
+    return *this;
+}
+
+ClassPatternMatcher& ClassPatternMatcher::FindAllSubstringsInText(Text text) {
+    if (!is_ready_) {
+        BuildClassPatternMatcher();
+    }
+
+    const std::size_t classes_size = SymbolsClassesSize();
+    StateIndex state               = kStartState;
+    for (std::size_t i = 0; i < text.size(); i++) {
+        const SymbolClass symbol_class =
+            symbols_classes_[static_cast<std::uint8_t>(text[i])];
+        StateIndex next_state =
+            transitions_[std::size_t{state} * classes_size + symbol_class];
+        if (next_state == kUnknownState) [[unlikely]] {
+            next_state = ComputeTransition(state, symbol_class, true);
+        }
+        state = next_state;
+        if (outputs_offsets_[state] != outputs_offsets_[state + 1]) {
+            NotifyAboutFoundSubstrings(text, i + 1, state);
+        }
+    }
+    return *this;
+}
+
+ClassPatternMatcher& ClassPatternMatcher::AddSubscriber(
+    FoundSubstringObserver* observer) {
+    found_substrings_port_.Subscribe(observer);
+    return *this;
+}
+
+ClassPatternMatcher& ClassPatternMatcher::AddSubscriber(
+    BadInputPatternObserver* observer) {
+    bad_input_port_.Subscribe(observer);
+    return *this;
+}
+
+std::size_t ClassPatternMatcher::NodesHash::operator()(
+    const std::vector<NodeIndex>& nodes) const noexcept {
+    // FNV-1a over the node indexes
+    std::size_t hash = 14695981039346656037ULL;
+    for (NodeIndex node_index : nodes) {
+        hash = (hash ^ node_index) * 1099511628211ULL;
+    }
+    return hash;
+}
+
+bool ClassPatternMatcher::ParsePattern(Pattern pattern,
+                                       std::vector<std::uint32_t>& sets) {
+    bool is_bad_input     = false;
+    auto report_bad_input = [&](std::size_t symbol_index) {
+        bad_input_port_.Notify({symbol_index, pattern[symbol_index]});
+        is_bad_input = true;
+    };
+    // Reads the symbol at i (escaped if it is kEscape) and moves i to it
+    auto read_symbol = [&](std::size_t& i) {
+        if (pattern[i] == kEscape) {
+            if (i + 1 == pattern.size()) {
+                report_bad_input(i);
+                return '\0';
+            }
+            i++;
+        }
+        return pattern[i];
+    };
+
+    SymbolsSet set;
+    for (std::size_t i = 0; i < pattern.size(); i++) {
+        set.reset();
+        switch (pattern[i]) {
+            case kAnySymbol:
+                set.set();
+                break;
+            case kClassEnd:
+                report_bad_input(i);
+                return false;
+            case kClassBegin: {
+                const std::size_t class_begin = i++;
+                const bool is_negated =
+                    i < pattern.size() && pattern[i] == kClassNegation;
+                i += is_negated ? 1 : 0;
+                for (; i < pattern.size() && pattern[i] != kClassEnd; i++) {
+                    const auto first =
+                        static_cast<std::uint8_t>(read_symbol(i));
+                    if (is_bad_input) {
+                        return false;
+                    }
+                    // kClassRange before kClassEnd is a symbol
+                    if (i + 2 < pattern.size() &&
+                        pattern[i + 1] == kClassRange &&
+                        pattern[i + 2] != kClassEnd) {
+                        i += 2;
+                        const auto last =
+                            static_cast<std::uint8_t>(read_symbol(i));
+                        if (is_bad_input) {
+                            return false;
+                        }
+                        if (last < first) {
+                            report_bad_input(i);
+                            return false;
+                        }
+                        for (std::size_t symbol = first; symbol <= last;
+                             symbol++) {
+                            set.set(symbol);
+                        }
+                    } else {
+                        set.set(first);
+                    }
+                }
+                if (i == pattern.size()) {
+                    report_bad_input(class_begin);
+                    return false;
+                }
+                if (is_negated) {
+                    set.flip();
+                }
+                if (set.none()) {
+                    report_bad_input(i);
+                    return false;
+                }
+                break;
+            }
+            default:
+                set.set(static_cast<std::uint8_t>(read_symbol(i)));
+                if (is_bad_input) {
+                    return false;
+                }
+                break;
+        }
+        sets.push_back(AddSymbolsSet(set));
+    }
+    return true;
+}
+
+std::uint32_t ClassPatternMatcher::AddSymbolsSet(const SymbolsSet& set) {
+    auto [iter, inserted] = sets_indexes_.try_emplace(
+        set, static_cast<std::uint32_t>(sets_.size()));
+    if (inserted) {
+        sets_.push_back(set);
+    }
+    return iter->second;
+}
+
+void ClassPatternMatcher::ComputeSymbolsClasses() {
+    // Partition refinement: symbols stay in one class while each set either
+    //  contains all of them or none of them
+    symbols_classes_.fill(0);
+    std::size_t classes_size = 1;
+    for (const SymbolsSet& set : sets_) {
+        std::array<std::int16_t, 2 * kSymbolsCount> refined_classes;
+        refined_classes.fill(-1);
+        std::size_t refined_classes_size = 0;
+        for (std::size_t symbol = 0; symbol < kSymbolsCount; symbol++) {
+            const std::size_t key =
+                2 * std::size_t{symbols_classes_[symbol]} +
+                (set.test(symbol) ? 1 : 0);
+            if (refined_classes[key] < 0) {
+                refined_classes[key] =
+                    static_cast<std::int16_t>(refined_classes_size++);
+            }
+            symbols_classes_[symbol] =
+                static_cast<SymbolClass>(refined_classes[key]);
+        }
+        classes_size = refined_classes_size;
+    }
+
+    classes_representatives_.assign(classes_size, 0);
+    for (std::size_t symbol = 0; symbol < kSymbolsCount; symbol++) {
+        classes_representatives_[symbols_classes_[symbol]] =
+            static_cast<std::uint8_t>(symbol);
+    }
+}
+
+void ClassPatternMatcher::ClearStates() {
+    transitions_.clear();
+    states_nodes_offsets_.assign(1, 0);
+    states_nodes_.clear();
+    outputs_offsets_.assign(1, 0);
+    outputs_.clear();
+    states_indexes_.clear();
+    // Only the root matches the empty suffix
+    [[maybe_unused]] const StateIndex start_state = AddState({});
+    assert(start_state == kStartState);
+}
+
+ClassPatternMatcher::StateIndex ClassPatternMatcher::AddState(
+    const std::vector<NodeIndex>& nodes) {
+    const auto state = static_cast<StateIndex>(StatesSize());
+    states_nodes_.insert(states_nodes_.end(), nodes.begin(), nodes.end());
+    states_nodes_offsets_.push_back(states_nodes_.size());
+
+    const std::size_t outputs_begin = outputs_.size();
+    for (NodeIndex node_index : nodes) {
+        const Node& node = nodes_[node_index];
+        if (node.word_index != kNoWord) {
+            outputs_.push_back(Output{
+                .length     = node.depth,
+                .word_index = node.word_index,
+            });
+        }
+    }
+    // Different patterns of the same length may end at the same position,
+    //  they are reported in the order of the word indexes
+    std::sort(outputs_.begin() + std::ptrdiff_t(outputs_begin), outputs_.end(),
+              [](const Output& lhs, const Output& rhs) {
+                  return lhs.length != rhs.length
+                             ? lhs.length > rhs.length
+                             : lhs.word_index < rhs.word_index;
+              });
+    outputs_offsets_.push_back(outputs_.size());
+
+    transitions_.resize(transitions_.size() + SymbolsClassesSize(),
+                        kUnknownState);
+    states_indexes_.emplace(nodes, state);
+    return state;
+}
+
+ClassPatternMatcher::StateIndex ClassPatternMatcher::ComputeTransition(
+    StateIndex state, SymbolClass symbol_class, bool allow_flush) {
+    const std::uint8_t symbol = classes_representatives_[symbol_class];
+    next_nodes_.clear();
+    auto add_children = [this, symbol](NodeIndex node_index) {
+        for (const auto& [set_index, child_index] :
+             nodes_[node_index].children) {
+            if (sets_[set_index].test(symbol)) {
+                next_nodes_.push_back(child_index);
+            }
+        }
+    };
+    add_children(kRootIndex);
+    for (std::size_t i = states_nodes_offsets_[state];
+         i < states_nodes_offsets_[state + 1]; i++) {
+        add_children(states_nodes_[i]);
+    }
+    std::ranges::sort(next_nodes_);
+
+    StateIndex next_state = kUnknownState;
+    if (auto iter = states_indexes_.find(next_nodes_);
+        iter != states_indexes_.end()) {
+        next_state = iter->second;
+    } else if (StatesSize() < max_states_size_) {
+        next_state = AddState(next_nodes_);
+    } else if (!allow_flush) {
+        return kUnknownState;
+    } else {
+        // State the transition is from is dropped too
+        ClearStates();
+        states_flushes_count_++;
+        is_fully_compiled_ = false;
+        return AddState(next_nodes_);
+    }
+    transitions_[std::size_t{state} * SymbolsClassesSize() + symbol_class] =
+        next_state;
+    return next_state;
+}
+
+void ClassPatternMatcher::NotifyAboutFoundSubstrings(Text text,
+                                                     std::size_t end,
+                                                     StateIndex state) {
+    for (std::size_t i = outputs_offsets_[state];
+         i < outputs_offsets_[state + 1]; i++) {
+        const Output output     = outputs_[i];
+        const std::size_t start = end - output.length;
+        found_substrings_port_.Notify(FoundSubstringInfo{
+            .found_substring       = text.substr(start, output.length),
+            .substring_start_index = start,
+            .current_vertex_index  = ACTrie::kNullNodeIndex,
+            .word_index            = output.word_index,
+        });
+    }
+}
+
+}  // namespace AppSpace::ACTrieDS
@@ -0,0 +1,192 @@
+#pragma once
+
+#include <array>
+#include <bitset>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "ACTrie.hpp"
+#include "Observer.hpp"
+
+namespace AppSpace::ACTrieDS {
+
+/// @brief Matcher of the patterns with the classes of the symbols: each
+///         position of the pattern is a symbol, kAnySymbol (any byte) or a
+///         bracket class like [0-9], [A-Fa-f] or [^,] (ranges, negation).
+///         kEscape makes the next symbol literal, also inside the brackets.
+///
+///  Patterns are added to the trie whose edges are the sets of the symbols,
+///   patterns with the same prefix of the classes share the nodes. The trie
+///   is compiled into the DFA by the subset construction: state of the DFA
+///   is the set of the trie nodes whose paths match the suffixes of the read
+///   text. The bytes which are in the same sets are merged into one
+///   equivalence class, so the transitions table has a column per class
+///   instead of per byte. The text is scanned in one pass, one table lookup
+///   per byte, like the ACTrie.
+///
+///  Number of the states may grow exponentially with the number of the
+///   overlapping classes, so at most max_states_size states are kept. The
+///   states that do not fit at the build are constructed during the scan
+///   when they are reached; when the limit is hit there, all states are
+///   dropped and built again from the current one.
+///
+///  Has the same interface for adding patterns and reporting found substrings
+///   as the ACTrie and reports substrings in the same order (by the end
+///   position, longer first). Different patterns of the same length found
+///   at the same position are reported by the ascending word index.
+///   Patterns with the same sequence of the sets are repeated patterns,
+///   reported once with the index of the last addition. Empty pattern takes
+///   its index but, unlike in the ACTrie, is never reported.
+///   current_vertex_index of the found substring is always
+///   ACTrie::kNullNodeIndex.
+class ClassPatternMatcher final {
+public:
+    using WordLength                = ACTrie::WordLength;
+    using Pattern                   = ACTrie::Pattern;
+    using Text                      = ACTrie::Text;
+    using FoundSubstringInfo        = ACTrie::FoundSubstringInfo;
+    using BadInputPatternInfo       = ACTrie::BadInputPatternInfo;
+    using FoundSubstringInfoPassBy  = ACTrie::FoundSubstringInfoPassBy;
+    using BadInputPatternInfoPassBy = ACTrie::BadInputPatternInfoPassBy;
+    using FoundSubstringObserver    = ACTrie::FoundSubstringObserver;
+    using BadInputPatternObserver   = ACTrie::BadInputPatternObserver;
+
+    static constexpr std::size_t kSymbolsCount =
+        std::numeric_limits<std::uint8_t>::max() + 1;
+    using SymbolsSet = std::bitset<kSymbolsCount>;
+
+    static constexpr char kAnySymbol     = '.';
+    static constexpr char kClassBegin    = '[';
+    static constexpr char kClassEnd      = ']';
+    static constexpr char kClassNegation = '^';
+    static constexpr char kClassRange    = '-';
+    static constexpr char kEscape        = '\\';
+    static constexpr std::size_t kDefaultMaxStatesSize = std::size_t{1} << 16;
+
+    /// @param max_states_size at least 2
+    explicit ClassPatternMatcher(
+        std::size_t max_states_size = kDefaultMaxStatesSize) noexcept;
+
+    /// @brief Adds pattern to the set. Unclosed or empty class, reversed
+    ///         range, unmatched kClassEnd and trailing kEscape are reported as
+    ///         bad input.
+    /// @param pattern
+    ClassPatternMatcher& AddPattern(Pattern pattern);
+    ClassPatternMatcher& BuildClassPatternMatcher();
+    ClassPatternMatcher& ResetClassPatternMatcher();
+    ClassPatternMatcher& FindAllSubstringsInText(Text text);
+    ClassPatternMatcher& AddSubscriber(FoundSubstringObserver* observer);
+    ClassPatternMatcher& AddSubscriber(BadInputPatternObserver* observer);
+    constexpr std::size_t PatternsSize() const noexcept;
+    constexpr std::size_t NodesSize() const noexcept;
+    /// @brief Number of the equivalence classes of the bytes, valid after
+    ///         the build.
+    constexpr std::size_t SymbolsClassesSize() const noexcept;
+    constexpr std::size_t StatesSize() const noexcept;
+    /// @brief Returns true if all states were built by the build, so the
+    ///         scans do not change the DFA.
+    constexpr bool IsFullyCompiled() const noexcept;
+    /// @brief How many times the states were dropped since the build.
+    constexpr std::size_t StatesFlushesCount() const noexcept;
+
+private:
+    using NodeIndex   = std::uint32_t;
+    using StateIndex  = std::uint32_t;
+    using SymbolClass = std::uint8_t;
+
+    static constexpr NodeIndex kRootIndex     = 0;
+    static constexpr StateIndex kStartState   = 0;
+    static constexpr StateIndex kUnknownState =
+        std::numeric_limits<StateIndex>::max();
+    static constexpr WordLength kNoWord =
+        std::numeric_limits<WordLength>::max();
+
+    struct Node final {
+        // Indexes of the edge sets in the sets_ and the children
+        std::vector<std::pair<std::uint32_t, NodeIndex>> children;
+        WordLength depth      = 0;
+        WordLength word_index = kNoWord;
+    };
+    struct Output final {
+        WordLength length;
+        WordLength word_index;
+    };
+    struct NodesHash final {
+        std::size_t operator()(
+            const std::vector<NodeIndex>& nodes) const noexcept;
+    };
+
+    bool ParsePattern(Pattern pattern, std::vector<std::uint32_t>& sets);
+    std::uint32_t AddSymbolsSet(const SymbolsSet& set);
+    void ComputeSymbolsClasses();
+    void ClearStates();
+    StateIndex AddState(const std::vector<NodeIndex>& nodes);
+    /// @brief Returns kUnknownState if the new state is needed, but the
+    ///         limit is hit and dropping the states is not allowed.
+    StateIndex ComputeTransition(StateIndex state, SymbolClass symbol_class,
+                                 bool allow_flush);
+    void NotifyAboutFoundSubstrings(Text text, std::size_t end,
+                                    StateIndex state);
+
+    std::size_t max_states_size_;
+    std::vector<SymbolsSet> sets_;
+    std::unordered_map<SymbolsSet, std::uint32_t> sets_indexes_;
+    std::vector<Node> nodes_;
+    std::array<SymbolClass, kSymbolsCount> symbols_classes_{};
+    // Any symbol of each class
+    std::vector<std::uint8_t> classes_representatives_;
+    // Next state of the state s by the class c is
+    //  transitions_[s * SymbolsClassesSize() + c]
+    std::vector<StateIndex> transitions_;
+    // Trie nodes of the state s (except the root, which is in each state)
+    //  are states_nodes_[states_nodes_offsets_[s]:states_nodes_offsets_[s+1]]
+    std::vector<std::size_t> states_nodes_offsets_;
+    std::vector<NodeIndex> states_nodes_;
+    // Found patterns of the state, longer first, then by the word index, in
+    //  the same layout
+    std::vector<std::size_t> outputs_offsets_;
+    std::vector<Output> outputs_;
+    std::unordered_map<std::vector<NodeIndex>, StateIndex, NodesHash>
+        states_indexes_;
+    std::vector<NodeIndex> next_nodes_;
+    std::size_t states_flushes_count_ = 0;
+    std::size_t patterns_size_        = 0;
+    bool is_fully_compiled_           = false;
+    bool is_ready_                    = false;
+    Observable<FoundSubstringInfo, FoundSubstringInfoPassBy>
+        found_substrings_port_;
+    Observable<BadInputPatternInfo, BadInputPatternInfoPassBy> bad_input_port_;
+};
+
+constexpr std::size_t ClassPatternMatcher::PatternsSize() const noexcept {
+    return patterns_size_;
+}
+
+constexpr std::size_t ClassPatternMatcher::NodesSize() const noexcept {
+    return nodes_.size();
+}
+
+constexpr std::size_t ClassPatternMatcher::SymbolsClassesSize()
+    const noexcept {
+    return classes_representatives_.size();
+}
+
+constexpr std::size_t ClassPatternMatcher::StatesSize() const noexcept {
+    return states_nodes_offsets_.empty() ? 0
+                                         : states_nodes_offsets_.size() - 1;
+}
+
+constexpr bool ClassPatternMatcher::IsFullyCompiled() const noexcept {
+    return is_fully_compiled_;
+}
+
+constexpr std::size_t ClassPatternMatcher::StatesFlushesCount()
+    const noexcept {
+    return states_flushes_count_;
+}
+
+}  // namespace AppSpace::ACTrieDS
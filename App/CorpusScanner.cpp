@@ -0,0 +1,245 @@
+#include "CorpusScanner.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <deque>
+#include <mutex>
+#include <numeric>
+#include <optional>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "MappedFile.hpp"
+#include "Workers.hpp"
+
+namespace AppSpace::ACTrieDS {
+
+namespace {
+
+using FoundSubstringInfo = ACTrie::FoundSubstringInfo;
+
+struct Task final {
+    std::size_t document_index;
+    std::size_t chunk_index;
+};
+
+/// @brief Deque of the tasks of one thread. Owner pushes and pops at the
+///         back, other threads steal from the front.
+class alignas(64) TasksDeque final {
+public:
+    void PushBack(Task task) {
+        std::lock_guard lock(mutex_);
+        tasks_.push_back(task);
+    }
+
+    std::optional<Task> PopBack() {
+        std::lock_guard lock(mutex_);
+        if (tasks_.empty()) {
+            return std::nullopt;
+        }
+        Task task = tasks_.back();
+        tasks_.pop_back();
+        return task;
+    }
+
+    std::optional<Task> StealFront() {
+        std::lock_guard lock(mutex_);
+        if (tasks_.empty()) {
+            return std::nullopt;
+        }
+        Task task = tasks_.front();
+        tasks_.pop_front();
+        return task;
+    }
+
+private:
+    std::mutex mutex_;
+    std::deque<Task> tasks_;
+};
+
+struct DocumentState final {
+    // Guards the fields below after the document is opened
+    std::mutex mutex;
+    std::optional<MappedFile> file;
+    CorpusScanner::Text text;
+    std::size_t chunks_count = 0;
+    // Chunks before it are already given to the sink
+    std::size_t next_delivered_chunk_index = 0;
+    // Results of the scanned chunks that wait for the previous ones
+    std::vector<std::optional<std::vector<FoundSubstringInfo>>> chunks_results;
+};
+
+std::size_t DocumentSizeHint(const CorpusScanner::Document& document) {
+    using Text = CorpusScanner::Text;
+    if (const auto* text = std::get_if<Text>(&document.source)) {
+        return text->size();
+    }
+    std::error_code error;
+    const auto size = std::filesystem::file_size(
+        std::get<std::filesystem::path>(document.source), error);
+    return error ? 0 : static_cast<std::size_t>(size);
+}
+
+}  // namespace
+
+CorpusScanner::CorpusScanner(const ACTrie& actrie, std::size_t threads_count)
+    : actrie_(actrie),
+      threads_count_(threads_count != 0 ? threads_count
+                                        : Workers::HardwareThreadsCount()) {
+    assert(actrie_.IsReady());
+}
+
+CorpusScanner& CorpusScanner::SetChunkSize(std::size_t chunk_size) noexcept {
+    assert(chunk_size != 0);
+    chunk_size_ = chunk_size;
+    return *this;
+}
+
+void CorpusScanner::Scan(std::span<const Document> documents) {
+    stolen_tasks_count_.store(0, std::memory_order_relaxed);
+    if (documents.empty()) {
+        return;
+    }
+
+    // Even one document keeps all threads busy if it is split into chunks
+    const std::size_t threads_count = threads_count_;
+    std::vector<TasksDeque> deques(threads_count);
+    std::vector<DocumentState> states(documents.size());
+
+    // Each thread starts with its largest document (it is at the back),
+    //  so the longest scans begin first.
+    std::vector<std::size_t> documents_order(documents.size());
+    std::iota(documents_order.begin(), documents_order.end(), std::size_t{0});
+    std::vector<std::size_t> sizes_hints(documents.size());
+    std::ranges::transform(documents, sizes_hints.begin(), DocumentSizeHint);
+    std::ranges::stable_sort(documents_order, std::ranges::greater{},
+                             [&sizes_hints](std::size_t document_index) {
+                                 return sizes_hints[document_index];
+                             });
+    for (std::size_t i = documents_order.size(); i-- > 0;) {
+        deques[i % threads_count].PushBack(Task{
+            .document_index = documents_order[i],
+            .chunk_index    = 0,
+        });
+    }
+    std::atomic<std::size_t> pending_tasks_count{documents.size()};
+
+    auto open_document = [&](std::size_t document_index) {
+        const Document& document = documents[document_index];
+        DocumentState& state     = states[document_index];
+        if (const auto* path =
+                std::get_if<std::filesystem::path>(&document.source)) {
+            state.file.emplace(*path);
+            state.text = state.file->Contents();
+        } else {
+            state.text = std::get<Text>(document.source);
+        }
+        state.chunks_count =
+            std::max((state.text.size() + chunk_size_ - 1) / chunk_size_,
+                     std::size_t{1});
+        state.chunks_results.resize(state.chunks_count);
+    };
+
+    auto scan_chunk = [&](const DocumentState& state, std::size_t chunk_index) {
+        const std::size_t chunk_start = chunk_index * chunk_size_;
+        const std::size_t chunk_end =
+            std::min(chunk_start + chunk_size_, state.text.size());
+        const std::size_t overlap = std::min(
+            chunk_start, std::max(std::size_t{actrie_.MaxPatternLength()},
+                                  std::size_t{1}) -
+                             1);
+        const std::size_t scan_start = chunk_start - overlap;
+        std::vector<FoundSubstringInfo> results;
+        // Substrings ending in the overlap belong to the previous chunk
+        actrie_.FindAllSubstringsInText(
+            state.text.substr(scan_start, chunk_end - scan_start),
+            [&](FoundSubstringInfo info) {
+                info.substring_start_index += scan_start;
+                if (info.substring_start_index + info.found_substring.size() >
+                    chunk_start) {
+                    results.push_back(info);
+                }
+            });
+        return results;
+    };
+
+    auto deliver_chunk = [&](std::size_t document_index,
+                             std::size_t chunk_index,
+                             std::vector<FoundSubstringInfo> results) {
+        DocumentState& state = states[document_index];
+        DocumentSink* sink   = documents[document_index].sink;
+        std::lock_guard lock(state.mutex);
+        state.chunks_results[chunk_index] = std::move(results);
+        while (state.next_delivered_chunk_index < state.chunks_count &&
+               state.chunks_results[state.next_delivered_chunk_index]) {
+            auto& chunk_results =
+                state.chunks_results[state.next_delivered_chunk_index++];
+            if (!chunk_results->empty()) {
+                sink->OnFoundSubstrings(*chunk_results);
+            }
+            chunk_results.reset();
+        }
+        if (state.next_delivered_chunk_index == state.chunks_count) {
+            sink->OnDocumentScanned({});
+            state.file.reset();
+        }
+    };
+
+    auto run_task = [&](Task task, TasksDeque& own_deque) {
+        if (task.chunk_index == 0) {
+            try {
+                open_document(task.document_index);
+            } catch (const std::system_error& ex) {
+                documents[task.document_index].sink->OnDocumentScanned(
+                    ex.code());
+                return;
+            }
+        }
+
+        // Next chunk is exposed before this one is scanned, so an idle
+        //  thread can steal it. Chunks are taken nearly in order, and few
+        //  results wait for the previous chunks.
+        const DocumentState& state = states[task.document_index];
+        if (task.chunk_index + 1 < state.chunks_count) {
+            pending_tasks_count.fetch_add(1, std::memory_order_relaxed);
+            own_deque.PushBack(Task{
+                .document_index = task.document_index,
+                .chunk_index    = task.chunk_index + 1,
+            });
+        }
+        deliver_chunk(task.document_index, task.chunk_index,
+                      scan_chunk(state, task.chunk_index));
+    };
+
+    auto worker = [&](std::size_t thread_index) {
+        TasksDeque& own_deque = deques[thread_index];
+        while (true) {
+            std::optional<Task> task = own_deque.PopBack();
+            for (std::size_t i = 1; !task && i < threads_count; i++) {
+                task = deques[(thread_index + i) % threads_count].StealFront();
+                if (task) {
+                    stolen_tasks_count_.fetch_add(1, std::memory_order_relaxed);
+                }
+            }
+
+            if (task) {
+                run_task(*task, own_deque);
+                pending_tasks_count.fetch_sub(1, std::memory_order_acq_rel);
+            } else if (pending_tasks_count.load(std::memory_order_acquire) ==
+                       0) {
+                break;
+            } else {
+                // Running tasks may still push the next chunks
+                std::this_thread::yield();
+            }
+        }
+    };
+    Workers::Run(threads_count, worker);
+}
+
+std::size_t CorpusScanner::StolenTasksCount() const noexcept {
+    return stolen_tasks_count_.load(std::memory_order_relaxed);
+}
+
+}  // namespace AppSpace::ACTrieDS
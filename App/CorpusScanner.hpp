@@ -0,0 +1,84 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <filesystem>
+#include <span>
+#include <system_error>
+#include <variant>
+
+#include "ACTrie.hpp"
+
+namespace AppSpace::ACTrieDS {
+
+/// @brief Scans many documents (files or texts in memory) with one built
+///         ACTrie on a work-stealing pool of threads.
+///
+///  Each thread has its own deque of tasks: it takes the tasks from the
+///   back, and the idle threads steal from the front of the others. A
+///   document longer than the chunk size is split into chunks, which are
+///   pushed to the deque of the thread that opened the document and are
+///   stolen by the others, so one 50 GB file is scanned by all threads.
+///   Chunk is scanned from MaxPatternLength() - 1 symbols before its start,
+///   so the patterns crossing the chunk boundaries are found exactly once.
+class CorpusScanner final {
+public:
+    using Text = ACTrie::Text;
+
+    /// @brief Receiver of the results of one document. It is never called
+    ///         by two threads at once, and it gets the found substrings in
+    ///         the same order as ACTrie::FindAllSubstringsInText() of the
+    ///         whole document gives them.
+    class DocumentSink {
+    public:
+        virtual ~DocumentSink() = default;
+        /// @brief Views of the found substrings point into the document and
+        ///         are valid only during the call.
+        virtual void OnFoundSubstrings(
+            std::span<const ACTrie::FoundSubstringInfo> infos) = 0;
+        /// @brief Called once after the last found substring.
+        /// @param error empty if the document was scanned completely, else
+        ///         the reason why it could not be read.
+        virtual void OnDocumentScanned(std::error_code error) = 0;
+    };
+
+    struct Document final {
+        std::variant<Text, std::filesystem::path> source;
+        DocumentSink* sink;
+    };
+
+    static constexpr std::size_t kDefaultChunkSize = std::size_t{16} << 20;
+
+    /// @param actrie must be built and must outlive the scanner
+    /// @param threads_count 0 means the number of hardware threads
+    explicit CorpusScanner(const ACTrie& actrie,
+                           std::size_t threads_count = 0);
+    /// @brief Documents longer than chunk_size are split into chunks.
+    /// @param chunk_size
+    CorpusScanner& SetChunkSize(std::size_t chunk_size) noexcept;
+    /// @brief Scans all documents and returns when all their sinks
+    ///         got OnDocumentScanned().
+    /// @param documents
+    void Scan(std::span<const Document> documents);
+    constexpr std::size_t ThreadsCount() const noexcept;
+    constexpr std::size_t ChunkSize() const noexcept;
+    /// @brief Number of the tasks taken by the threads from the deques of
+    ///         the other threads during the last Scan().
+    std::size_t StolenTasksCount() const noexcept;
+
+private:
+    const ACTrie& actrie_;
+    std::size_t threads_count_;
+    std::size_t chunk_size_ = kDefaultChunkSize;
+    std::atomic<std::size_t> stolen_tasks_count_{0};
+};
+
+constexpr std::size_t CorpusScanner::ThreadsCount() const noexcept {
+    return threads_count_;
+}
+
+constexpr std::size_t CorpusScanner::ChunkSize() const noexcept {
+    return chunk_size_;
+}
+
+}  // namespace AppSpace::ACTrieDS
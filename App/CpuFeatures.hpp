@@ -0,0 +1,77 @@
+#pragma once
+
+// SSE2 is a part of the x86-64 baseline, so it can be used unconditionally.
+#if defined(__x86_64__) || defined(_M_X64)
+#define ACTRIE_X86_SIMD 1
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+#include <immintrin.h>
+#else
+#define ACTRIE_X86_SIMD 0
+#endif
+
+// Functions marked with these attributes may use SSSE3 or AVX2 instructions
+//  even if the whole translation unit is compiled for the baseline
+//  x86-64 (SSE2 only). They must be called only after the
+//  CpuFeatures::HasSsse3() or CpuFeatures::HasAvx2() check.
+#if ACTRIE_X86_SIMD && (defined(__GNUC__) || defined(__clang__))
+#define ACTRIE_TARGET_SSSE3 __attribute__((target("ssse3")))
+#define ACTRIE_TARGET_AVX2  __attribute__((target("avx2")))
+#else
+#define ACTRIE_TARGET_SSSE3
+#define ACTRIE_TARGET_AVX2
+#endif
+
+namespace AppSpace::ACTrieDS::CpuFeatures {
+
+/// @brief Checks whether SSSE3 instructions (pshufb in particular) can be
+///         used on the current cpu. The result is computed once and then
+///         cached.
+inline bool HasSsse3() noexcept {
+#if ACTRIE_X86_SIMD && (defined(__GNUC__) || defined(__clang__))
+    static const bool kHasSsse3 = __builtin_cpu_supports("ssse3") != 0;
+    return kHasSsse3;
+#elif ACTRIE_X86_SIMD && defined(_MSC_VER)
+    static const bool kHasSsse3 = []() noexcept {
+        int cpu_info[4]{};
+        __cpuid(cpu_info, 1);
+        constexpr int kSsse3Bit = 1 << 9;
+        return (cpu_info[2] & kSsse3Bit) != 0;
+    }();
+    return kHasSsse3;
+#else
+    return false;
+#endif
+}
+
+/// @brief Checks whether AVX2 instructions can be used on the current cpu.
+///        The result is computed once and then cached.
+inline bool HasAvx2() noexcept {
+#if ACTRIE_X86_SIMD && (defined(__GNUC__) || defined(__clang__))
+    static const bool kHasAvx2 = __builtin_cpu_supports("avx2") != 0;
+    return kHasAvx2;
+#elif ACTRIE_X86_SIMD && defined(_MSC_VER)
+    static const bool kHasAvx2 = []() noexcept {
+        int cpu_info[4]{};
+        __cpuid(cpu_info, 0);
+        if (cpu_info[0] < 7) {
+            return false;
+        }
+        // The OS must save ymm registers on context switches.
+        __cpuid(cpu_info, 1);
+        constexpr int kOsXSaveBit = 1 << 27;
+        if ((cpu_info[2] & kOsXSaveBit) == 0 || (_xgetbv(0) & 0x6) != 0x6) {
+            return false;
+        }
+        __cpuidex(cpu_info, 7, 0);
+        constexpr int kAvx2Bit = 1 << 5;
+        return (cpu_info[1] & kAvx2Bit) != 0;
+    }();
+    return kHasAvx2;
+#else
+    return false;
+#endif
+}
+
+}  // namespace AppSpace::ACTrieDS::CpuFeatures
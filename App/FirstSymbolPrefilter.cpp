@@ -0,0 +1,118 @@
+#include "FirstSymbolPrefilter.hpp"
+
+#include <bit>
+#include <cassert>
+#include <cstdint>
+
+#include "CpuFeatures.hpp"
+
+namespace AppSpace::ACTrieDS {
+
+namespace {
+
+using Symbols = std::array<char, FirstSymbolPrefilter::kMaxSymbols>;
+
+std::size_t FindNextCandidateScalar(const char* data, std::size_t size,
+                                    std::size_t position,
+                                    const Symbols& symbols) noexcept {
+    for (; position < size; position++) {
+        const char symbol = data[position];
+        if (symbol == symbols[0] || symbol == symbols[1] ||
+            symbol == symbols[2] || symbol == symbols[3]) {
+            break;
+        }
+    }
+    return position;
+}
+
+#if ACTRIE_X86_SIMD
+
+std::size_t FindNextCandidateSse2(const char* data, std::size_t size,
+                                  std::size_t position,
+                                  const Symbols& symbols) noexcept {
+    constexpr std::size_t kBlockSize = sizeof(__m128i);
+    const __m128i symbol0            = _mm_set1_epi8(symbols[0]);
+    const __m128i symbol1            = _mm_set1_epi8(symbols[1]);
+    const __m128i symbol2            = _mm_set1_epi8(symbols[2]);
+    const __m128i symbol3            = _mm_set1_epi8(symbols[3]);
+    for (; position + kBlockSize <= size; position += kBlockSize) {
+        const __m128i block = _mm_loadu_si128(
+            reinterpret_cast<const __m128i*>(data + position));
+        const __m128i eq01 = _mm_or_si128(_mm_cmpeq_epi8(block, symbol0),
+                                          _mm_cmpeq_epi8(block, symbol1));
+        const __m128i eq23 = _mm_or_si128(_mm_cmpeq_epi8(block, symbol2),
+                                          _mm_cmpeq_epi8(block, symbol3));
+        const auto mask    = static_cast<std::uint32_t>(
+            _mm_movemask_epi8(_mm_or_si128(eq01, eq23)));
+        if (mask != 0) {
+            return position + static_cast<std::size_t>(std::countr_zero(mask));
+        }
+    }
+    return FindNextCandidateScalar(data, size, position, symbols);
+}
+
+ACTRIE_TARGET_AVX2
+std::size_t FindNextCandidateAvx2(const char* data, std::size_t size,
+                                  std::size_t position,
+                                  const Symbols& symbols) noexcept {
+    constexpr std::size_t kBlockSize = sizeof(__m256i);
+    const __m256i symbol0            = _mm256_set1_epi8(symbols[0]);
+    const __m256i symbol1            = _mm256_set1_epi8(symbols[1]);
+    const __m256i symbol2            = _mm256_set1_epi8(symbols[2]);
+    const __m256i symbol3            = _mm256_set1_epi8(symbols[3]);
+    for (; position + kBlockSize <= size; position += kBlockSize) {
+        const __m256i block = _mm256_loadu_si256(
+            reinterpret_cast<const __m256i*>(data + position));
+        const __m256i eq01 = _mm256_or_si256(_mm256_cmpeq_epi8(block, symbol0),
+                                             _mm256_cmpeq_epi8(block, symbol1));
+        const __m256i eq23 = _mm256_or_si256(_mm256_cmpeq_epi8(block, symbol2),
+                                             _mm256_cmpeq_epi8(block, symbol3));
+        const auto mask    = static_cast<std::uint32_t>(
+            _mm256_movemask_epi8(_mm256_or_si256(eq01, eq23)));
+        if (mask != 0) {
+            return position + static_cast<std::size_t>(std::countr_zero(mask));
+        }
+    }
+    return FindNextCandidateSse2(data, size, position, symbols);
+}
+
+#endif
+
+}  // namespace
+
+bool FirstSymbolPrefilter::Setup(std::string_view symbols) noexcept {
+    Reset();
+    if (symbols.empty() || symbols.size() > kMaxSymbols) {
+        return false;
+    }
+
+    symbols_.fill(symbols.front());
+    for (std::size_t i = 0; i < symbols.size(); i++) {
+        symbols_[i] = symbols[i];
+    }
+    symbols_count_ = symbols.size();
+    return true;
+}
+
+void FirstSymbolPrefilter::Reset() noexcept {
+    symbols_.fill('\0');
+    symbols_count_ = 0;
+}
+
+std::size_t FirstSymbolPrefilter::FindNextCandidate(
+    std::string_view text, std::size_t position) const noexcept {
+    assert(IsEnabled());
+    assert(position <= text.size());
+#if ACTRIE_X86_SIMD
+    if (CpuFeatures::HasAvx2()) {
+        return FindNextCandidateAvx2(text.data(), text.size(), position,
+                                     symbols_);
+    }
+    return FindNextCandidateSse2(text.data(), text.size(), position, symbols_);
+#else
+    return FindNextCandidateScalar(text.data(), text.size(), position,
+                                   symbols_);
+#endif
+}
+
+}  // namespace AppSpace::ACTrieDS
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <string_view>
+
+namespace AppSpace::ACTrieDS {
+
+/// @brief Finds positions in the text where some pattern can start.
+///
+///  When the automaton is in the root, every symbol that is not the first
+///   symbol of some pattern leads back to the root. If there are only a few
+///   such first symbols, we can skip the whole region before the next one
+///   with a vectorized search (like memchr does) instead of walking it
+///   symbol by symbol.
+class FirstSymbolPrefilter final {
+public:
+    /// @brief Maximum number of distinct first symbols the prefilter
+    ///         can search for. Each symbol costs one vector comparison
+    ///         per block, so the prefilter stops paying off quickly.
+    static constexpr std::size_t kMaxSymbols = 4;
+    static_assert(kMaxSymbols == 4, "IsCandidate() should be updated");
+
+    /// @brief Tries to setup the prefilter for the given first symbols.
+    /// @param symbols
+    /// @return true if prefilter is enabled after the call, false if there
+    ///          are too many (or zero) symbols.
+    bool Setup(std::string_view symbols) noexcept;
+    void Reset() noexcept;
+    constexpr bool IsEnabled() const noexcept;
+    constexpr bool IsCandidate(char symbol) const noexcept;
+    /// @brief Returns index of the first symbol in the text[position:] that
+    ///         can start a pattern or text.size() if there is no such symbol.
+    /// @param text
+    /// @param position
+    std::size_t FindNextCandidate(std::string_view text,
+                                  std::size_t position) const noexcept;
+
+private:
+    // Unused slots are filled with copies of the first symbol,
+    //  so the search may always compare with all kMaxSymbols symbols.
+    std::array<char, kMaxSymbols> symbols_{};
+    std::size_t symbols_count_ = 0;
+};
+
+constexpr bool FirstSymbolPrefilter::IsEnabled() const noexcept {
+    return symbols_count_ != 0;
+}
+
+constexpr bool FirstSymbolPrefilter::IsCandidate(char symbol) const noexcept {
+    return symbol == symbols_[0] || symbol == symbols_[1] ||
+           symbol == symbols_[2] || symbol == symbols_[3];
+}
+
+}  // namespace AppSpace::ACTrieDS
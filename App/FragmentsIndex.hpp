@@ -0,0 +1,104 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "ACTrie.hpp"
+
+namespace AppSpace::ACTrieDS {
+
+/// @brief Fragments of the patterns found by one ACTrie with the uses of each
+///         fragment, for the matchers which find the patterns by their
+///         fragments (like WildcardMatcher or ApproximateMatcher).
+///
+///  Fragment is added to the ACTrie once, its word index is the index of the
+///   fragment. Uses of all fragments are kept in one array grouped by the
+///   fragment after the build.
+/// @tparam TFragmentUse where the fragment is used, copied as is
+template <class TFragmentUse>
+class FragmentsIndex final {
+public:
+    using WordLength = ACTrie::WordLength;
+    using Text       = ACTrie::Text;
+
+    /// @brief Adds the fragment to the ACTrie if it was not added since the
+    ///         last build and records its use. Fragment must stay valid
+    ///         until Build().
+    /// @param fragment
+    /// @param use
+    void AddUse(std::string_view fragment, const TFragmentUse& use) {
+        auto [iter, inserted] = fragments_indexes_.try_emplace(
+            fragment, static_cast<WordLength>(fragments_indexes_.size()));
+        if (inserted) {
+            fragments_actrie_.AddPattern(fragment);
+        }
+        added_uses_.emplace_back(iter->second, use);
+    }
+
+    void Build() {
+        fragments_size_ = fragments_indexes_.size();
+        fragments_indexes_.clear();
+        fragments_actrie_.BuildACTrie();
+
+        uses_offsets_.assign(fragments_size_ + 1, 0);
+        for (const auto& [fragment_index, use] : added_uses_) {
+            uses_offsets_[fragment_index + 1]++;
+        }
+        for (std::size_t f = 0; f < fragments_size_; f++) {
+            uses_offsets_[f + 1] += uses_offsets_[f];
+        }
+        uses_.resize(added_uses_.size());
+        std::vector<std::uint32_t> next_use_indexes(uses_offsets_.begin(),
+                                                    uses_offsets_.end() - 1);
+        for (const auto& [fragment_index, use] : added_uses_) {
+            uses_[next_use_indexes[fragment_index]++] = use;
+        }
+        added_uses_.clear();
+    }
+
+    void Reset() {
+        fragments_actrie_.ResetACTrie();
+        fragments_indexes_.clear();
+        added_uses_.clear();
+        uses_offsets_.clear();
+        uses_.clear();
+        fragments_size_ = 0;
+    }
+
+    /// @brief Passes each fragment found in the text to the on_fragment, in
+    ///         the order of the ACTrie, the word index of the found
+    ///         substring is the index of the fragment.
+    template <class OnFragment>
+    void FindAllFragmentsInText(Text text, OnFragment on_fragment) {
+        fragments_actrie_.FindAllSubstringsInText(text, on_fragment);
+    }
+
+    std::span<const TFragmentUse> Uses(
+        WordLength fragment_index) const noexcept {
+        return std::span<const TFragmentUse>(uses_).subspan(
+            uses_offsets_[fragment_index],
+            uses_offsets_[fragment_index + 1] - uses_offsets_[fragment_index]);
+    }
+
+    /// @brief Number of the distinct fragments, valid after the build.
+    constexpr std::size_t FragmentsSize() const noexcept {
+        return fragments_size_;
+    }
+
+private:
+    ACTrie fragments_actrie_;
+    std::unordered_map<std::string_view, WordLength> fragments_indexes_;
+    std::vector<std::pair<WordLength, TFragmentUse>> added_uses_;
+    // Uses of the fragment with the index f are
+    //  uses_[uses_offsets_[f]:uses_offsets_[f + 1]]
+    std::vector<std::uint32_t> uses_offsets_;
+    std::vector<TFragmentUse> uses_;
+    std::size_t fragments_size_ = 0;
+};
+
+}  // namespace AppSpace::ACTrieDS
@@ -0,0 +1,135 @@
+#include "HugePagesMemoryResource.hpp"
+
+#include <cassert>
+#include <cstdint>
+#include <new>
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
+
+namespace AppSpace::ACTrieDS {
+
+namespace {
+
+#if defined(__linux__)
+
+void* MapExplicitHugePages(std::size_t size) noexcept {
+    void* address = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                         MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    return address != MAP_FAILED ? address : nullptr;
+}
+
+/// @brief Maps size + one huge page and unmaps the parts before and after
+///         the huge page aligned region, so that the kernel can back the
+///         whole region with the huge pages.
+void* MapTransparentHugePages(std::size_t size) noexcept {
+    constexpr std::size_t kHugePageSize =
+        HugePagesMemoryResource::kHugePageSize;
+    const std::size_t raw_size = size + kHugePageSize;
+    void* raw_address = mmap(nullptr, raw_size, PROT_READ | PROT_WRITE,
+                             MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (raw_address == MAP_FAILED) {
+        return nullptr;
+    }
+
+    const auto raw_start = reinterpret_cast<std::uintptr_t>(raw_address);
+    const std::uintptr_t start =
+        (raw_start + kHugePageSize - 1) & ~std::uintptr_t{kHugePageSize - 1};
+    const std::size_t head_size = start - raw_start;
+    const std::size_t tail_size = raw_size - head_size - size;
+    if (head_size != 0) {
+        munmap(raw_address, head_size);
+    }
+    if (tail_size != 0) {
+        munmap(reinterpret_cast<void*>(start + size), tail_size);
+    }
+
+    auto* address = reinterpret_cast<void*>(start);
+    // Failure only means that the transparent huge pages are disabled,
+    //  memory is usable anyway.
+    madvise(address, size, MADV_HUGEPAGE);
+    return address;
+}
+
+#endif
+
+}  // namespace
+
+HugePagesMemoryResource::HugePagesMemoryResource(
+    Mode mode, std::pmr::memory_resource* upstream) noexcept
+    : upstream_(upstream), mode_(mode) {
+    assert(upstream_ != nullptr);
+}
+
+std::size_t HugePagesMemoryResource::MappedBytes() const noexcept {
+    return mapped_bytes_.load(std::memory_order_relaxed);
+}
+
+std::size_t HugePagesMemoryResource::ExplicitHugePagesFallbacks()
+    const noexcept {
+    return explicit_huge_pages_fallbacks_.load(std::memory_order_relaxed);
+}
+
+void* HugePagesMemoryResource::do_allocate(std::size_t bytes,
+                                           std::size_t alignment) {
+    if (!IsMapped(bytes, alignment)) {
+        return upstream_->allocate(bytes, alignment);
+    }
+
+#if defined(__linux__)
+    const std::size_t size = MappedSize(bytes);
+    void* address          = nullptr;
+    if (mode_ == Mode::kExplicit) {
+        address = MapExplicitHugePages(size);
+        if (address == nullptr) {
+            explicit_huge_pages_fallbacks_.fetch_add(
+                1, std::memory_order_relaxed);
+        }
+    }
+    if (address == nullptr) {
+        address = MapTransparentHugePages(size);
+    }
+    if (address == nullptr) {
+        throw std::bad_alloc();
+    }
+
+    mapped_bytes_.fetch_add(size, std::memory_order_relaxed);
+    return address;
+#else
+    return upstream_->allocate(bytes, alignment);
+#endif
+}
+
+void HugePagesMemoryResource::do_deallocate(void* pointer, std::size_t bytes,
+                                            std::size_t alignment) {
+    if (!IsMapped(bytes, alignment)) {
+        upstream_->deallocate(pointer, bytes, alignment);
+        return;
+    }
+
+#if defined(__linux__)
+    const std::size_t size = MappedSize(bytes);
+    munmap(pointer, size);
+    mapped_bytes_.fetch_sub(size, std::memory_order_relaxed);
+#else
+    upstream_->deallocate(pointer, bytes, alignment);
+#endif
+}
+
+bool HugePagesMemoryResource::do_is_equal(
+    const std::pmr::memory_resource& other) const noexcept {
+    return this == &other;
+}
+
+constexpr bool HugePagesMemoryResource::IsMapped(
+    std::size_t bytes, std::size_t alignment) noexcept {
+    return bytes >= kMinMappedSize && alignment <= kHugePageSize;
+}
+
+constexpr std::size_t HugePagesMemoryResource::MappedSize(
+    std::size_t bytes) noexcept {
+    return (bytes + kHugePageSize - 1) & ~(kHugePageSize - 1);
+}
+
+}  // namespace AppSpace::ACTrieDS
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory_resource>
+
+namespace AppSpace::ACTrieDS {
+
+/// @brief Memory resource which backs large allocations (like the nodes of
+///         a big ACTrie) with 2 MB pages, so that the scan over a multi-GB
+///         automaton does not miss the TLB on almost every symbol.
+///
+///  On Linux every large allocation gets its own mapping. In the kExplicit
+///   mode MAP_HUGETLB pages are tried first (they must be reserved in the
+///   /proc/sys/vm/nr_hugepages). If there are not enough of them, or in the
+///   kTransparent mode, the mapping is aligned to 2 MB and advised for the
+///   transparent huge pages, which the kernel may or may not give. Small
+///   allocations, and all allocations on the other systems, are passed to
+///   the upstream resource.
+class HugePagesMemoryResource final : public std::pmr::memory_resource {
+public:
+    enum class Mode {
+        // madvise(MADV_HUGEPAGE) on the 2 MB aligned mapping
+        kTransparent,
+        // MAP_HUGETLB, kTransparent if there are no free huge pages
+        kExplicit,
+    };
+
+    static constexpr std::size_t kHugePageSize = std::size_t{2} << 20;
+    // Smaller allocations would leave most of the huge page unused
+    static constexpr std::size_t kMinMappedSize = kHugePageSize / 2;
+
+    explicit HugePagesMemoryResource(
+        Mode mode                           = Mode::kTransparent,
+        std::pmr::memory_resource* upstream = std::pmr::get_default_resource())
+        noexcept;
+    constexpr Mode GetMode() const noexcept;
+    /// @brief Total size of the mappings currently owned by the resource.
+    std::size_t MappedBytes() const noexcept;
+    /// @brief Number of the allocations for which MAP_HUGETLB failed and the
+    ///         transparent huge pages were used instead.
+    std::size_t ExplicitHugePagesFallbacks() const noexcept;
+
+private:
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override;
+    void do_deallocate(void* pointer, std::size_t bytes,
+                       std::size_t alignment) override;
+    bool do_is_equal(
+        const std::pmr::memory_resource& other) const noexcept override;
+    static constexpr bool IsMapped(std::size_t bytes,
+                                   std::size_t alignment) noexcept;
+    static constexpr std::size_t MappedSize(std::size_t bytes) noexcept;
+
+    std::pmr::memory_resource* upstream_;
+    Mode mode_;
+    std::atomic<std::size_t> mapped_bytes_{0};
+    std::atomic<std::size_t> explicit_huge_pages_fallbacks_{0};
+};
+
+constexpr HugePagesMemoryResource::Mode HugePagesMemoryResource::GetMode()
+    const noexcept {
+    return mode_;
+}
+
+}  // namespace AppSpace::ACTrieDS
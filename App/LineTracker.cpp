@@ -0,0 +1,89 @@
+#include "LineTracker.hpp"
+
+#include <algorithm>
+#include <cstdint>
+
+#include "CpuFeatures.hpp"
+
+namespace AppSpace::ACTrieDS {
+
+namespace {
+
+std::size_t CountNewlinesScalar(const char* data, std::size_t size) noexcept {
+    return static_cast<std::size_t>(
+        std::count(data, data + size, LineTracker::kNewline));
+}
+
+#if ACTRIE_X86_SIMD
+
+// Byte counters of the equal symbols overflow after 255 blocks
+constexpr std::size_t kMaxBlocksInByteCounters = 255;
+
+std::size_t CountNewlinesSse2(const char* data, std::size_t size) noexcept {
+    constexpr std::size_t kBlockSize = sizeof(__m128i);
+    const __m128i newline            = _mm_set1_epi8(LineTracker::kNewline);
+    const __m128i zero               = _mm_setzero_si128();
+    std::size_t count                = 0;
+    std::size_t position             = 0;
+    while (position + kBlockSize <= size) {
+        const std::size_t blocks_count = std::min(
+            (size - position) / kBlockSize, kMaxBlocksInByteCounters);
+        // Equal symbols are -1 after the comparison
+        __m128i counters = zero;
+        for (std::size_t i = 0; i < blocks_count; i++) {
+            const __m128i block = _mm_loadu_si128(
+                reinterpret_cast<const __m128i*>(data + position));
+            counters = _mm_sub_epi8(counters, _mm_cmpeq_epi8(block, newline));
+            position += kBlockSize;
+        }
+        const __m128i sums = _mm_sad_epu8(counters, zero);
+        count += static_cast<std::size_t>(_mm_cvtsi128_si64(sums)) +
+                 static_cast<std::size_t>(
+                     _mm_cvtsi128_si64(_mm_unpackhi_epi64(sums, sums)));
+    }
+    return count + CountNewlinesScalar(data + position, size - position);
+}
+
+ACTRIE_TARGET_AVX2
+std::size_t CountNewlinesAvx2(const char* data, std::size_t size) noexcept {
+    constexpr std::size_t kBlockSize = sizeof(__m256i);
+    const __m256i newline = _mm256_set1_epi8(LineTracker::kNewline);
+    const __m256i zero    = _mm256_setzero_si256();
+    std::size_t count     = 0;
+    std::size_t position  = 0;
+    while (position + kBlockSize <= size) {
+        const std::size_t blocks_count = std::min(
+            (size - position) / kBlockSize, kMaxBlocksInByteCounters);
+        __m256i counters = zero;
+        for (std::size_t i = 0; i < blocks_count; i++) {
+            const __m256i block = _mm256_loadu_si256(
+                reinterpret_cast<const __m256i*>(data + position));
+            counters =
+                _mm256_sub_epi8(counters, _mm256_cmpeq_epi8(block, newline));
+            position += kBlockSize;
+        }
+        const __m256i sums = _mm256_sad_epu8(counters, zero);
+        count += static_cast<std::size_t>(_mm256_extract_epi64(sums, 0)) +
+                 static_cast<std::size_t>(_mm256_extract_epi64(sums, 1)) +
+                 static_cast<std::size_t>(_mm256_extract_epi64(sums, 2)) +
+                 static_cast<std::size_t>(_mm256_extract_epi64(sums, 3));
+    }
+    return count + CountNewlinesSse2(data + position, size - position);
+}
+
+#endif
+
+}  // namespace
+
+std::size_t LineTracker::CountNewlines(std::string_view text) noexcept {
+#if ACTRIE_X86_SIMD
+    if (CpuFeatures::HasAvx2()) {
+        return CountNewlinesAvx2(text.data(), text.size());
+    }
+    return CountNewlinesSse2(text.data(), text.size());
+#else
+    return CountNewlinesScalar(text.data(), text.size());
+#endif
+}
+
+}  // namespace AppSpace::ACTrieDS
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstddef>
+#include <string_view>
+
+namespace AppSpace::ACTrieDS {
+
+/// @brief Line of the positions of the text asked in order, found without
+///         the second pass over the text: newlines between the asked
+///         positions are counted by the vector comparisons, and only the
+///         line start is found by the search back from the position.
+class LineTracker final {
+public:
+    static constexpr char kNewline = '\n';
+
+    /// @brief Number of the newlines in the text by 16 or 32 symbols at a
+    ///         time (SSE2 or AVX2).
+    static std::size_t CountNewlines(std::string_view text) noexcept;
+
+    explicit LineTracker(std::string_view text) noexcept;
+    /// @brief Moves to the line of the position. Positions before the
+    ///         previous one are taken as the previous one, so they must be
+    ///         in its line.
+    /// @param position
+    void AdvanceTo(std::size_t position) noexcept;
+    /// @brief Index of the current line, lines are counted from 0.
+    constexpr std::size_t LineIndex() const noexcept;
+    /// @brief Index of the first symbol of the current line in the text.
+    constexpr std::size_t LineStartIndex() const noexcept;
+
+private:
+    std::string_view text_;
+    std::size_t position_         = 0;
+    std::size_t line_index_       = 0;
+    std::size_t line_start_index_ = 0;
+};
+
+inline LineTracker::LineTracker(std::string_view text) noexcept
+    : text_(text) {}
+
+inline void LineTracker::AdvanceTo(std::size_t position) noexcept {
+    if (position <= position_) {
+        return;
+    }
+
+    const std::size_t newlines_count =
+        CountNewlines(text_.substr(position_, position - position_));
+    if (newlines_count != 0) {
+        line_index_ += newlines_count;
+        line_start_index_ = text_.rfind(kNewline, position - 1) + 1;
+    }
+    position_ = position;
+}
+
+constexpr std::size_t LineTracker::LineIndex() const noexcept {
+    return line_index_;
+}
+
+constexpr std::size_t LineTracker::LineStartIndex() const noexcept {
+    return line_start_index_;
+}
+
+}  // namespace AppSpace::ACTrieDS
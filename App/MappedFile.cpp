@@ -0,0 +1,114 @@
+#include "MappedFile.hpp"
+
+#include <cerrno>
+#include <system_error>
+#include <utility>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define ACTRIE_MAPPED_FILE_MMAP 1
+#else
+#include <fstream>
+#include <iterator>
+#define ACTRIE_MAPPED_FILE_MMAP 0
+#endif
+
+namespace AppSpace::ACTrieDS {
+
+namespace {
+
+[[noreturn]] void ThrowFileError(int error_code,
+                                 const std::filesystem::path& path) {
+    throw std::system_error(error_code, std::generic_category(),
+                            path.string());
+}
+
+}  // namespace
+
+#if ACTRIE_MAPPED_FILE_MMAP
+
+MappedFile::MappedFile(const std::filesystem::path& path) {
+    const int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        ThrowFileError(errno, path);
+    }
+
+    struct stat file_stat {};
+    if (fstat(fd, &file_stat) != 0) {
+        const int error_code = errno;
+        close(fd);
+        ThrowFileError(error_code, path);
+    }
+
+    // Empty file can not be mapped, and it does not need to be
+    const auto size = static_cast<std::size_t>(file_stat.st_size);
+    if (size != 0) {
+        void* address = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (address == MAP_FAILED) {
+            const int error_code = errno;
+            close(fd);
+            ThrowFileError(error_code, path);
+        }
+        // Failure is not an error, the advice only speeds up the read ahead
+        madvise(address, size, MADV_SEQUENTIAL);
+        contents_ = std::string_view(static_cast<const char*>(address), size);
+    }
+    // Mapping keeps the file referenced
+    close(fd);
+}
+
+void MappedFile::Release() noexcept {
+    if (!contents_.empty()) {
+        munmap(const_cast<char*>(contents_.data()), contents_.size());
+    }
+    contents_ = {};
+}
+
+#else
+
+MappedFile::MappedFile(const std::filesystem::path& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        ThrowFileError(ENOENT, path);
+    }
+    buffer_.assign(std::istreambuf_iterator<char>(file),
+                   std::istreambuf_iterator<char>());
+    if (file.bad()) {
+        ThrowFileError(EIO, path);
+    }
+    contents_ = buffer_;
+}
+
+void MappedFile::Release() noexcept {
+    buffer_.clear();
+    contents_ = {};
+}
+
+#endif
+
+MappedFile::MappedFile(MappedFile&& other) noexcept {
+    *this = std::move(other);
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+    if (this != &other) {
+        Release();
+#if ACTRIE_MAPPED_FILE_MMAP
+        contents_ = std::exchange(other.contents_, {});
+#else
+        buffer_         = std::move(other.buffer_);
+        contents_       = buffer_;
+        other.contents_ = {};
+#endif
+    }
+    return *this;
+}
+
+MappedFile::~MappedFile() {
+    Release();
+}
+
+}  // namespace AppSpace::ACTrieDS
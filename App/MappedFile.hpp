@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <string>
+#include <string_view>
+
+namespace AppSpace::ACTrieDS {
+
+/// @brief Read-only contents of the whole file.
+///
+///  On the POSIX systems the file is mapped into memory (and advised for
+///   the sequential access), so a file larger than the memory can be
+///   scanned. On the other systems it is read into a buffer.
+class MappedFile final {
+public:
+    /// @brief Throws std::system_error if the file can not be read.
+    /// @param path
+    explicit MappedFile(const std::filesystem::path& path);
+    MappedFile(const MappedFile&)            = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+    ~MappedFile();
+
+    constexpr std::string_view Contents() const noexcept;
+
+private:
+    void Release() noexcept;
+
+    std::string_view contents_;
+#if !defined(__unix__) && !defined(__APPLE__)
+    std::string buffer_;
+#endif
+};
+
+constexpr std::string_view MappedFile::Contents() const noexcept {
+    return contents_;
+}
+
+}  // namespace AppSpace::ACTrieDS
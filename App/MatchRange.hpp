@@ -0,0 +1,128 @@
+#pragma once
+
+#include <cstddef>
+#include <iterator>
+#include <optional>
+#include <ranges>
+
+#include "ACTrie.hpp"
+
+namespace AppSpace::ACTrieDS {
+
+/// @brief Found substrings of the text pulled one by one: each increment of
+///         the iterator resumes the scan from the saved ACTrie::ScanCursor
+///         up to the next substring, so only the consumed substrings are
+///         searched for. Single pass view, works with the ranges algorithms
+///         and adaptors:
+///
+///  for (const auto& info : MatchRange(actrie, text) | std::views::take(3))
+///
+///  Iterators point to the range, so they are invalidated when it is moved.
+///   Adaptors copy the range given to them, so its Cursor() is advanced
+///   only if it is given as std::ranges::ref_view.
+class MatchRange final : public std::ranges::view_interface<MatchRange> {
+public:
+    class Iterator final {
+    public:
+        using iterator_concept = std::input_iterator_tag;
+        using value_type       = ACTrie::FoundSubstringInfo;
+        using difference_type  = std::ptrdiff_t;
+
+        Iterator() noexcept = default;
+
+        const value_type& operator*() const noexcept;
+        const value_type* operator->() const noexcept;
+        Iterator& operator++();
+        void operator++(int);
+        friend bool operator==(const Iterator& iterator,
+                               std::default_sentinel_t) noexcept {
+            return iterator.IsEnd();
+        }
+
+    private:
+        friend class MatchRange;
+
+        explicit Iterator(MatchRange& range) noexcept : range_(&range) {}
+        bool IsEnd() const noexcept;
+
+        MatchRange* range_ = nullptr;
+    };
+
+    MatchRange() noexcept = default;
+    /// @param actrie must be built and must outlive the range
+    /// @param text must outlive the range
+    /// @param groups
+    MatchRange(const ACTrie& actrie, ACTrie::Text text,
+               ACTrie::GroupsMask groups = ACTrie::kAllGroups) noexcept;
+
+    /// @brief Finds the first substring on the first call, next calls
+    ///         continue from the last found one.
+    Iterator begin();
+    constexpr std::default_sentinel_t end() const noexcept;
+    /// @brief State of the scan, the text is scanned up to its position.
+    constexpr const ACTrie::ScanCursor& Cursor() const noexcept;
+
+private:
+    void FindNext();
+
+    const ACTrie* actrie_ = nullptr;
+    ACTrie::Text text_;
+    ACTrie::GroupsMask groups_ = ACTrie::kAllGroups;
+    ACTrie::ScanCursor cursor_;
+    std::optional<ACTrie::FoundSubstringInfo> current_;
+    bool is_started_ = false;
+};
+
+static_assert(std::ranges::view<MatchRange> &&
+              std::ranges::input_range<MatchRange>);
+
+inline MatchRange::MatchRange(const ACTrie& actrie, ACTrie::Text text,
+                              ACTrie::GroupsMask groups) noexcept
+    : actrie_(&actrie), text_(text), groups_(groups) {}
+
+inline MatchRange::Iterator MatchRange::begin() {
+    if (!is_started_) {
+        is_started_ = true;
+        FindNext();
+    }
+    return Iterator(*this);
+}
+
+constexpr std::default_sentinel_t MatchRange::end() const noexcept {
+    return std::default_sentinel;
+}
+
+constexpr const ACTrie::ScanCursor& MatchRange::Cursor() const noexcept {
+    return cursor_;
+}
+
+inline void MatchRange::FindNext() {
+    current_ = actrie_ != nullptr
+                   ? actrie_->FindNextSubstring(text_, groups_, cursor_)
+                   : std::nullopt;
+}
+
+inline const MatchRange::Iterator::value_type&
+MatchRange::Iterator::operator*() const noexcept {
+    return *range_->current_;
+}
+
+inline const MatchRange::Iterator::value_type*
+MatchRange::Iterator::operator->() const noexcept {
+    return &*range_->current_;
+}
+
+inline bool MatchRange::Iterator::IsEnd() const noexcept {
+    return !range_->current_.has_value();
+}
+
+inline MatchRange::Iterator& MatchRange::Iterator::operator++() {
+    range_->FindNext();
+    return *this;
+}
+
+inline void MatchRange::Iterator::operator++(int) {
+    ++*this;
+}
+
+}  // namespace AppSpace::ACTrieDS
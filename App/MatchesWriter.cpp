@@ -0,0 +1,187 @@
+#include "MatchesWriter.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <charconv>
+#include <cstring>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+
+namespace AppSpace::ACTrieDS {
+
+namespace {
+
+static_assert(sizeof(BinaryMatchesWriter::BinaryMatchesHeader) <=
+              BinaryMatchesWriter::kHeaderSize);
+
+template <class Number>
+void AppendNumbers(std::string& line, std::string_view name,
+                   std::span<const Number> numbers) {
+    line += '"';
+    line += name;
+    line += "\":[";
+    for (std::size_t i = 0; i < numbers.size(); i++) {
+        if (i != 0) {
+            line += ',';
+        }
+        char digits[24];
+        const auto result =
+            std::to_chars(std::begin(digits), std::end(digits), numbers[i]);
+        line.append(digits, result.ptr);
+    }
+    line += ']';
+}
+
+}  // namespace
+
+MatchesWriter::MatchesWriter(std::FILE* file, std::size_t block_capacity)
+    : file_(file), block_capacity_(block_capacity) {
+    assert(file_ != nullptr);
+    assert(block_capacity_ != 0);
+    offsets_.reserve(block_capacity_);
+    word_indexes_.reserve(block_capacity_);
+    lengths_.reserve(block_capacity_);
+}
+
+void MatchesWriter::Finish() {
+    if (!offsets_.empty()) {
+        WriteCollectedBlock();
+    }
+    if (std::fflush(file_) != 0) {
+        throw std::system_error(errno != 0 ? errno : EIO,
+                                std::generic_category(), "matches writer");
+    }
+}
+
+void MatchesWriter::Write(const void* data, std::size_t size) {
+    if (std::fwrite(data, 1, size, file_) != size) {
+        throw std::system_error(errno != 0 ? errno : EIO,
+                                std::generic_category(), "matches writer");
+    }
+}
+
+void MatchesWriter::WriteCollectedBlock() {
+    WriteBlock(MatchesBlock{
+        .offsets      = offsets_,
+        .word_indexes = word_indexes_,
+        .lengths      = lengths_,
+    });
+    written_matches_count_ += offsets_.size();
+    offsets_.clear();
+    word_indexes_.clear();
+    lengths_.clear();
+}
+
+BinaryMatchesWriter::BinaryMatchesWriter(std::FILE* file,
+                                         std::size_t block_capacity)
+    : MatchesWriter(file, block_capacity),
+      zeros_(std::max(kHeaderSize,
+                      block_capacity * sizeof(std::uint64_t))) {
+    BinaryMatchesHeader header{
+        .magic          = {},
+        .version        = kVersion,
+        .byte_order     = kByteOrder,
+        .block_capacity = block_capacity,
+    };
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    Write(&header, sizeof(header));
+    Write(zeros_.data(), kHeaderSize - sizeof(header));
+}
+
+void BinaryMatchesWriter::WriteBlock(const MatchesBlock& block) {
+    // Blocks have the same size, so the block i is found without an index
+    const std::size_t matches_count = block.offsets.size();
+    const std::size_t unused_count  = BlockCapacity() - matches_count;
+    const std::uint64_t count       = matches_count;
+    Write(&count, sizeof(count));
+    Write(block.offsets.data(), block.offsets.size_bytes());
+    Write(zeros_.data(), unused_count * sizeof(std::uint64_t));
+    Write(block.word_indexes.data(), block.word_indexes.size_bytes());
+    Write(zeros_.data(), unused_count * sizeof(ACTrie::WordLength));
+    Write(block.lengths.data(), block.lengths.size_bytes());
+    Write(zeros_.data(), unused_count * sizeof(ACTrie::WordLength));
+}
+
+BinaryMatchesReader::BinaryMatchesReader(const std::filesystem::path& path)
+    : file_(path), path_(path), block_capacity_(0) {
+    using Header = BinaryMatchesWriter::BinaryMatchesHeader;
+
+    const std::string_view contents = file_.Contents();
+    Header header{};
+    if (contents.size() >= BinaryMatchesWriter::kHeaderSize) {
+        std::memcpy(&header, contents.data(), sizeof(header));
+    }
+    const bool is_correct =
+        contents.size() >= BinaryMatchesWriter::kHeaderSize &&
+        std::memcmp(header.magic, BinaryMatchesWriter::kMagic,
+                    sizeof(header.magic)) == 0 &&
+        header.version == BinaryMatchesWriter::kVersion &&
+        header.byte_order == BinaryMatchesWriter::kByteOrder &&
+        header.block_capacity != 0 &&
+        header.block_capacity <= BinaryMatchesWriter::kMaxBlockCapacity &&
+        (contents.size() - BinaryMatchesWriter::kHeaderSize) %
+                BinaryMatchesWriter::BlockSize(header.block_capacity) ==
+            0;
+    if (!is_correct) {
+        throw std::runtime_error(path.string() +
+                                 ": not a binary matches file");
+    }
+    block_capacity_ = static_cast<std::size_t>(header.block_capacity);
+    for (std::size_t i = 0; i < BlocksCount(); i++) {
+        Block(i);
+    }
+}
+
+std::size_t BinaryMatchesReader::BlocksCount() const noexcept {
+    return (file_.Contents().size() - BinaryMatchesWriter::kHeaderSize) /
+           BinaryMatchesWriter::BlockSize(block_capacity_);
+}
+
+MatchesBlock BinaryMatchesReader::Block(std::size_t block_index) const {
+    assert(block_index < BlocksCount());
+    // Header and blocks sizes are multiples of 8, the mapping is aligned
+    const char* block = file_.Contents().data() +
+                        BinaryMatchesWriter::kHeaderSize +
+                        block_index *
+                            BinaryMatchesWriter::BlockSize(block_capacity_);
+    std::uint64_t matches_count = 0;
+    std::memcpy(&matches_count, block, sizeof(matches_count));
+    if (matches_count > block_capacity_) {
+        throw std::runtime_error(path_.string() + ": block " +
+                                 std::to_string(block_index) +
+                                 " has more matches than its capacity");
+    }
+    const auto* offsets = reinterpret_cast<const std::uint64_t*>(
+        block + sizeof(std::uint64_t));
+    const auto* word_indexes = reinterpret_cast<const ACTrie::WordLength*>(
+        offsets + block_capacity_);
+    const auto* lengths = word_indexes + block_capacity_;
+    const auto size     = static_cast<std::size_t>(matches_count);
+    return {
+        .offsets      = {offsets, size},
+        .word_indexes = {word_indexes, size},
+        .lengths      = {lengths, size},
+    };
+}
+
+NdjsonMatchesWriter::NdjsonMatchesWriter(std::FILE* file,
+                                         std::size_t block_capacity)
+    : MatchesWriter(file, block_capacity) {}
+
+void NdjsonMatchesWriter::WriteBlock(const MatchesBlock& block) {
+    line_.clear();
+    line_ += '{';
+    AppendNumbers(line_, "offsets", block.offsets);
+    line_ += ',';
+    AppendNumbers(line_, "word_indexes", block.word_indexes);
+    line_ += ',';
+    AppendNumbers(line_, "lengths", block.lengths);
+    line_ += "}\n";
+    Write(line_.data(), line_.size());
+}
+
+}  // namespace AppSpace::ACTrieDS
@@ -0,0 +1,177 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <limits>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "ACTrie.hpp"
+#include "MappedFile.hpp"
+
+namespace AppSpace::ACTrieDS {
+
+/// @brief Columns of the matches: i-th match is described by the i-th
+///         element of each column.
+struct MatchesBlock final {
+    // Offsets of the first symbols of the matches
+    std::span<const std::uint64_t> offsets;
+    std::span<const ACTrie::WordLength> word_indexes;
+    std::span<const ACTrie::WordLength> lengths;
+};
+
+/// @brief Collects the matches into the columns of a block of the fixed
+///         capacity and writes the full blocks to the file (or the pipe) by
+///         large sequential writes, so emitting a match costs three stores
+///         instead of a formatted write.
+///
+///  Finish() must be called after the last match, else the last incomplete
+///   block is lost. Write errors are thrown as std::system_error.
+class MatchesWriter {
+public:
+    static constexpr std::size_t kDefaultBlockCapacity = std::size_t{1} << 16;
+
+    virtual ~MatchesWriter() = default;
+    MatchesWriter(const MatchesWriter&)            = delete;
+    MatchesWriter& operator=(const MatchesWriter&) = delete;
+
+    void Add(std::uint64_t offset, ACTrie::WordLength word_index,
+             ACTrie::WordLength length);
+    void Add(const ACTrie::FoundSubstringInfo& info);
+    /// @brief Writes the incomplete block and flushes the file.
+    void Finish();
+    constexpr std::size_t BlockCapacity() const noexcept;
+    constexpr std::uint64_t WrittenMatchesCount() const noexcept;
+
+protected:
+    /// @param file is not closed by the writer
+    /// @param block_capacity
+    MatchesWriter(std::FILE* file, std::size_t block_capacity);
+    /// @brief Called with a non empty block.
+    virtual void WriteBlock(const MatchesBlock& block) = 0;
+    void Write(const void* data, std::size_t size);
+
+private:
+    void WriteCollectedBlock();
+
+    std::FILE* file_;
+    std::size_t block_capacity_;
+    std::uint64_t written_matches_count_ = 0;
+    std::vector<std::uint64_t> offsets_;
+    std::vector<ACTrie::WordLength> word_indexes_;
+    std::vector<ACTrie::WordLength> lengths_;
+};
+
+/// @brief Raw layout for the readers that map the file into memory:
+///         kHeaderSize bytes of BinaryMatchesHeader, then the blocks of
+///         BlockSize(block_capacity) bytes. Block is the uint64 number of
+///         the matches, then block_capacity offsets (uint64), word indexes
+///         (uint32) and lengths (uint32), the unused tails are zeroed.
+///         Numbers are in the byte order of the writer (see byte_order).
+class BinaryMatchesWriter final : public MatchesWriter {
+public:
+    static constexpr char kMagic[8]           = {'A', 'C', 'T', 'R',
+                                                 'I', 'E', 'M', 'B'};
+    static constexpr std::uint32_t kVersion   = 1;
+    static constexpr std::uint32_t kByteOrder = 0x01020304;
+    static constexpr std::size_t kHeaderSize  = 64;
+    // Largest block_capacity with the BlockSize() fitting into std::size_t
+    static constexpr std::size_t kMaxBlockCapacity =
+        (std::numeric_limits<std::size_t>::max() - sizeof(std::uint64_t)) /
+        (sizeof(std::uint64_t) + 2 * sizeof(ACTrie::WordLength));
+
+    struct BinaryMatchesHeader final {
+        char magic[8];
+        std::uint32_t version;
+        // kByteOrder as written by the writer
+        std::uint32_t byte_order;
+        std::uint64_t block_capacity;
+    };
+
+    static constexpr std::size_t BlockSize(std::size_t block_capacity) noexcept;
+
+    /// @brief Writes the header at once.
+    explicit BinaryMatchesWriter(
+        std::FILE* file, std::size_t block_capacity = kDefaultBlockCapacity);
+
+private:
+    void WriteBlock(const MatchesBlock& block) override;
+
+    std::vector<char> zeros_;
+};
+
+/// @brief Reads the file written by BinaryMatchesWriter in place.
+class BinaryMatchesReader final {
+public:
+    /// @brief Throws std::system_error if the file can not be read and
+    ///         std::runtime_error if it is not written by
+    ///         BinaryMatchesWriter on the machine with the same byte order
+    ///         or any of its blocks is corrupted.
+    /// @param path
+    explicit BinaryMatchesReader(const std::filesystem::path& path);
+
+    std::size_t BlocksCount() const noexcept;
+    /// @brief Throws std::runtime_error if the block has more matches than
+    ///         the capacity (the file was changed after the opening).
+    /// @param block_index
+    MatchesBlock Block(std::size_t block_index) const;
+    constexpr std::size_t BlockCapacity() const noexcept;
+
+private:
+    MappedFile file_;
+    std::filesystem::path path_;
+    std::size_t block_capacity_;
+};
+
+/// @brief One JSON object per line for each block:
+///         {"offsets":[...],"word_indexes":[...],"lengths":[...]}
+class NdjsonMatchesWriter final : public MatchesWriter {
+public:
+    explicit NdjsonMatchesWriter(
+        std::FILE* file, std::size_t block_capacity = kDefaultBlockCapacity);
+
+private:
+    void WriteBlock(const MatchesBlock& block) override;
+
+    std::string line_;
+};
+
+inline void MatchesWriter::Add(std::uint64_t offset,
+                               ACTrie::WordLength word_index,
+                               ACTrie::WordLength length) {
+    offsets_.push_back(offset);
+    word_indexes_.push_back(word_index);
+    lengths_.push_back(length);
+    if (offsets_.size() == block_capacity_) {
+        WriteCollectedBlock();
+    }
+}
+
+inline void MatchesWriter::Add(const ACTrie::FoundSubstringInfo& info) {
+    Add(info.substring_start_index, info.word_index,
+        static_cast<ACTrie::WordLength>(info.found_substring.size()));
+}
+
+constexpr std::size_t MatchesWriter::BlockCapacity() const noexcept {
+    return block_capacity_;
+}
+
+constexpr std::uint64_t MatchesWriter::WrittenMatchesCount() const noexcept {
+    return written_matches_count_;
+}
+
+constexpr std::size_t BinaryMatchesWriter::BlockSize(
+    std::size_t block_capacity) noexcept {
+    return sizeof(std::uint64_t) +
+           block_capacity * (sizeof(std::uint64_t) +
+                             2 * sizeof(ACTrie::WordLength));
+}
+
+constexpr std::size_t BinaryMatchesReader::BlockCapacity() const noexcept {
+    return block_capacity_;
+}
+
+}  // namespace AppSpace::ACTrieDS
@@ -122,6 +122,9 @@ public:
             listener_ = nullptr;
         }
     }
+    constexpr bool HasSubscriber() const noexcept {
+        return listener_ != nullptr;
+    }
     template <class UniTData = TData>
     void Notify(UniTData&& data) {
         if (listener_ != nullptr) {
@@ -171,6 +174,9 @@ public:
             listener_ = nullptr;
         }
     }
+    constexpr bool HasSubscriber() const noexcept {
+        return listener_ != nullptr;
+    }
     void Notify() {
         if (listener_ != nullptr) {
             listener_->on_notify_();
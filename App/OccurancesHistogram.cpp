@@ -0,0 +1,82 @@
+#include "OccurancesHistogram.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <memory>
+#include <new>
+
+#include "Workers.hpp"
+
+namespace AppSpace::ACTrieDS {
+
+OccurancesHistogram::OccurancesHistogram(const ACTrie& actrie,
+                                         std::size_t threads_count)
+    : actrie_(actrie),
+      threads_count_(threads_count != 0 ? threads_count
+                                        : Workers::HardwareThreadsCount()),
+      counts_(actrie.PatternsSize()) {
+    assert(actrie_.IsReady());
+}
+
+OccurancesHistogram& OccurancesHistogram::CountInTexts(
+    std::span<const ACTrie::Text> texts) {
+    const std::size_t threads_count =
+        std::max(std::min(threads_count_, texts.size()), std::size_t{1});
+    // Counters of the thread i are [i * stride, i * stride + counts_.size())
+    const std::size_t stride =
+        (counts_.size() + kCacheLineCountsSize - 1) / kCacheLineCountsSize *
+        kCacheLineCountsSize;
+    const AlignedCounts threads_counts =
+        MakeAlignedCounts(threads_count * stride);
+    auto thread_counts = [&](std::size_t thread_index) {
+        return std::span<Count>(threads_counts.get() + thread_index * stride,
+                                counts_.size());
+    };
+
+    std::atomic<std::size_t> next_text_index{0};
+    auto count_texts = [&](std::size_t thread_index) {
+        const std::span<Count> words_counts = thread_counts(thread_index);
+        for (std::size_t text_index = next_text_index.fetch_add(1);
+             text_index < texts.size();
+             text_index = next_text_index.fetch_add(1)) {
+            actrie_.CountOccurances(texts[text_index], words_counts);
+        }
+    };
+    Workers::Run(threads_count, count_texts);
+
+    for (std::size_t thread_index = 0; thread_index < threads_count;
+         thread_index++) {
+        const std::span<const Count> words_counts =
+            thread_counts(thread_index);
+        for (std::size_t i = 0; i < counts_.size(); i++) {
+            counts_[i] += words_counts[i];
+        }
+    }
+    return *this;
+}
+
+OccurancesHistogram& OccurancesHistogram::Reset() noexcept {
+    std::fill(counts_.begin(), counts_.end(), Count{0});
+    return *this;
+}
+
+void OccurancesHistogram::AlignedCountsDeleter::operator()(
+    Count* counts) const noexcept {
+    ::operator delete[](counts, std::align_val_t{kCacheLineSize});
+}
+
+OccurancesHistogram::AlignedCounts OccurancesHistogram::MakeAlignedCounts(
+    std::size_t size) {
+    auto* counts = static_cast<Count*>(::operator new[](
+        size * sizeof(Count), std::align_val_t{kCacheLineSize}));
+    std::uninitialized_fill_n(counts, size, Count{0});
+    return AlignedCounts(counts);
+}
+
+std::span<const OccurancesHistogram::Count> OccurancesHistogram::Counts()
+    const noexcept {
+    return counts_;
+}
+
+}  // namespace AppSpace::ACTrieDS
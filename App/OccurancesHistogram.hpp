@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <span>
+#include <vector>
+
+#include "ACTrie.hpp"
+
+namespace AppSpace::ACTrieDS {
+
+/// @brief Number of the occurances of each pattern of the built ACTrie in
+///         a corpus of texts, counted by several threads.
+///
+///  Texts are taken by the threads one by one. Each thread counts into its
+///   own array of counters (no atomics in the scan) and the arrays are
+///   summed when all texts are scanned. Arrays start at the cache line
+///   boundaries and take whole cache lines, so threads never write to the
+///   same line. Text is the unit of work: one huge text is scanned by one
+///   thread.
+class OccurancesHistogram final {
+public:
+    using Count = ACTrie::OccurancesCount;
+
+    /// @param actrie must be built and must outlive the histogram
+    /// @param threads_count 0 means the number of hardware threads
+    explicit OccurancesHistogram(const ACTrie& actrie,
+                                 std::size_t threads_count = 0);
+    /// @brief Adds the occurances in the texts to the counts.
+    /// @param texts
+    OccurancesHistogram& CountInTexts(std::span<const ACTrie::Text> texts);
+    OccurancesHistogram& Reset() noexcept;
+    /// @brief Counts indexed by the word_index of the patterns.
+    std::span<const Count> Counts() const noexcept;
+    constexpr std::size_t ThreadsCount() const noexcept;
+
+private:
+    static constexpr std::size_t kCacheLineSize      = 64;
+    static constexpr std::size_t kCacheLineCountsSize =
+        kCacheLineSize / sizeof(Count);
+
+    struct AlignedCountsDeleter final {
+        void operator()(Count* counts) const noexcept;
+    };
+    using AlignedCounts = std::unique_ptr<Count[], AlignedCountsDeleter>;
+
+    static AlignedCounts MakeAlignedCounts(std::size_t size);
+
+    const ACTrie& actrie_;
+    std::size_t threads_count_;
+    std::vector<Count> counts_;
+};
+
+constexpr std::size_t OccurancesHistogram::ThreadsCount() const noexcept {
+    return threads_count_;
+}
+
+}  // namespace AppSpace::ACTrieDS
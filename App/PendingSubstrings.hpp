@@ -0,0 +1,77 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <type_traits>
+#include <vector>
+
+#include "ACTrie.hpp"
+
+namespace AppSpace::ACTrieDS {
+
+/// @brief Reorders substrings found by the start position (by matchers that
+///         verify candidates, like TeddyMatcher or WuManberMatcher) into the
+///         order of the ACTrie: by the end position, longer first.
+/// @tparam TInfo FoundSubstringInfo or the info with the FoundSubstringInfo
+///          substring member
+template <class TInfo>
+class BasicPendingSubstrings final {
+public:
+    using FoundSubstringInfo = ACTrie::FoundSubstringInfo;
+
+    void Clear() noexcept {
+        heap_.clear();
+    }
+
+    void Push(const TInfo& info) {
+        heap_.push_back(info);
+        std::push_heap(heap_.begin(), heap_.end(), IsReportedLater);
+    }
+
+    /// @brief Passes to the on_substring all substrings ending before the
+    ///         end_bound. Caller guarantees that all substrings pushed later
+    ///         end after the end_bound.
+    template <class OnSubstring>
+    void PopEndingBefore(std::size_t end_bound, OnSubstring on_substring) {
+        while (!heap_.empty()) {
+            const FoundSubstringInfo& top = Substring(heap_.front());
+            if (top.substring_start_index + top.found_substring.size() >
+                end_bound) {
+                break;
+            }
+            on_substring(heap_.front());
+            std::pop_heap(heap_.begin(), heap_.end(), IsReportedLater);
+            heap_.pop_back();
+        }
+    }
+
+private:
+    static const FoundSubstringInfo& Substring(const TInfo& info) noexcept {
+        if constexpr (std::is_same_v<TInfo, FoundSubstringInfo>) {
+            return info;
+        } else {
+            return info.substring;
+        }
+    }
+
+    /// @brief Order of the heap: substring which ends earlier
+    ///         (and longer one if ends are equal) is on the top.
+    static bool IsReportedLater(const TInfo& lhs_info,
+                                const TInfo& rhs_info) noexcept {
+        const FoundSubstringInfo& lhs = Substring(lhs_info);
+        const FoundSubstringInfo& rhs = Substring(rhs_info);
+        const std::size_t lhs_end =
+            lhs.substring_start_index + lhs.found_substring.size();
+        const std::size_t rhs_end =
+            rhs.substring_start_index + rhs.found_substring.size();
+        return lhs_end != rhs_end
+                   ? lhs_end > rhs_end
+                   : lhs.found_substring.size() < rhs.found_substring.size();
+    }
+
+    std::vector<TInfo> heap_;
+};
+
+using PendingSubstrings = BasicPendingSubstrings<ACTrie::FoundSubstringInfo>;
+
+}  // namespace AppSpace::ACTrieDS
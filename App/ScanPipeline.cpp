@@ -0,0 +1,358 @@
+#include "ScanPipeline.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <cstring>
+#include <exception>
+#include <limits>
+#include <mutex>
+#include <string>
+#include <system_error>
+#include <thread>
+
+#include "BoundedQueue.hpp"
+#include "Workers.hpp"
+
+namespace AppSpace::ACTrieDS {
+
+namespace {
+
+// Index of a buffer or of a batch passed through the queues
+using ItemIndex = std::uint32_t;
+// Tells the consumer that the previous stage is finished
+constexpr ItemIndex kEndOfItems = std::numeric_limits<ItemIndex>::max();
+
+struct Buffer final {
+    std::vector<char> data;
+    // Bytes of data, including the overlap
+    std::size_t size = 0;
+    // Bytes copied from the end of the previous buffer of the source
+    std::size_t overlap_size = 0;
+    std::size_t source_index = 0;
+    // Offset of data[0] in the source
+    std::uint64_t offset = 0;
+};
+
+/// @brief Pops the item, waiting while the queue is empty. Each wait is
+///         counted as one stall.
+ItemIndex PopWaiting(BoundedQueue<ItemIndex>& queue,
+                     std::atomic<std::uint64_t>& stalls_count) {
+    ItemIndex item = kEndOfItems;
+    if (queue.TryPop(item)) {
+        return item;
+    }
+
+    stalls_count.fetch_add(1, std::memory_order_relaxed);
+    while (!queue.TryPop(item)) {
+        std::this_thread::yield();
+    }
+    return item;
+}
+
+/// @brief Pushes the item to the queue which has room for all buffers or
+///         batches and all end markers. Push may still fail for a while if
+///         a thread that popped from the cell one lap ago is preempted
+///         before it frees the cell.
+void Push(BoundedQueue<ItemIndex>& queue, ItemIndex item) noexcept {
+    while (!queue.TryPush(item)) {
+        std::this_thread::yield();
+    }
+}
+
+}  // namespace
+
+FileByteSource::FileByteSource(std::FILE* file) noexcept : file_(file) {
+    assert(file_ != nullptr);
+}
+
+std::size_t FileByteSource::Read(std::span<char> buffer) {
+    const std::size_t read_size =
+        std::fread(buffer.data(), 1, buffer.size(), file_);
+    if (read_size < buffer.size() && std::ferror(file_) != 0) {
+        throw std::system_error(errno != 0 ? errno : EIO,
+                                std::generic_category(), "fread");
+    }
+    return read_size;
+}
+
+TextByteSource::TextByteSource(std::string_view text,
+                               std::size_t max_read_size) noexcept
+    : text_(text), max_read_size_(max_read_size) {
+    assert(max_read_size_ != 0);
+}
+
+std::size_t TextByteSource::Read(std::span<char> buffer) {
+    const std::size_t read_size =
+        std::min({buffer.size(), max_read_size_, text_.size()});
+    std::memcpy(buffer.data(), text_.data(), read_size);
+    text_.remove_prefix(read_size);
+    return read_size;
+}
+
+ScanPipeline::ScanPipeline(const ACTrie& actrie) : actrie_(actrie) {
+    assert(actrie_.IsReady());
+}
+
+ScanPipeline& ScanPipeline::SetThreadsCounts(
+    std::size_t reader_threads_count, std::size_t scanner_threads_count,
+    std::size_t sink_threads_count) noexcept {
+    reader_threads_count_  = std::max(reader_threads_count, std::size_t{1});
+    scanner_threads_count_ = scanner_threads_count;
+    sink_threads_count_    = std::max(sink_threads_count, std::size_t{1});
+    return *this;
+}
+
+ScanPipeline& ScanPipeline::SetBuffers(std::size_t buffer_size,
+                                       std::size_t buffers_count,
+                                       std::size_t batch_capacity,
+                                       std::size_t batches_count) noexcept {
+    assert(buffer_size != 0 && batch_capacity != 0);
+    buffer_size_    = buffer_size;
+    buffers_count_  = buffers_count;
+    batch_capacity_ = batch_capacity;
+    batches_count_  = batches_count;
+    return *this;
+}
+
+void ScanPipeline::Run(std::span<ByteSource* const> sources,
+                       MatchesSink& sink) {
+    readers_counters_.Reset();
+    scanners_counters_.Reset();
+    sinks_counters_.Reset();
+    if (sources.empty()) {
+        return;
+    }
+
+    const std::size_t reader_threads_count =
+        std::min(reader_threads_count_, sources.size());
+    const std::size_t scanner_threads_count =
+        scanner_threads_count_ != 0 ? scanner_threads_count_
+                                    : Workers::HardwareThreadsCount();
+    const std::size_t readers_and_scanners_count =
+        reader_threads_count + scanner_threads_count;
+    const std::size_t buffers_count =
+        buffers_count_ != 0 ? buffers_count_ : 2 * readers_and_scanners_count;
+    const std::size_t batches_count =
+        batches_count_ != 0 ? batches_count_
+                            : 2 * (scanner_threads_count + sink_threads_count_);
+    assert(buffers_count < kEndOfItems && batches_count < kEndOfItems);
+    const std::size_t overlap_size =
+        std::max(std::size_t{actrie_.MaxPatternLength()}, std::size_t{1}) - 1;
+
+    std::vector<Buffer> buffers(buffers_count);
+    BoundedQueue<ItemIndex> free_buffers(buffers_count);
+    for (std::size_t i = 0; i < buffers_count; i++) {
+        buffers[i].data.resize(overlap_size + buffer_size_);
+        Push(free_buffers, ItemIndex(i));
+    }
+    std::vector<MatchesBatch> batches(batches_count);
+    BoundedQueue<ItemIndex> free_batches(batches_count);
+    for (std::size_t i = 0; i < batches_count; i++) {
+        batches[i].matches.reserve(batch_capacity_);
+        Push(free_batches, ItemIndex(i));
+    }
+    BoundedQueue<ItemIndex> scan_queue(buffers_count + scanner_threads_count);
+    BoundedQueue<ItemIndex> sink_queue(batches_count + sink_threads_count_);
+
+    std::mutex first_error_mutex;
+    std::exception_ptr first_error;
+    auto save_error = [&]() {
+        std::lock_guard lock(first_error_mutex);
+        if (!first_error) {
+            first_error = std::current_exception();
+        }
+    };
+
+    std::atomic<std::size_t> next_source_index{0};
+    std::atomic<std::size_t> running_readers_count{reader_threads_count};
+    auto read_source = [&](std::size_t source_index) {
+        ByteSource& source   = *sources[source_index];
+        std::uint64_t offset = 0;
+        // End of the previous buffer, copied to the start of the next one
+        std::string tail;
+        for (bool finished = false; !finished;) {
+            const ItemIndex buffer_index = PopWaiting(
+                free_buffers, readers_counters_.output_stalls_count);
+            Buffer& buffer              = buffers[buffer_index];
+            const std::size_t tail_size = tail.size();
+            std::memcpy(buffer.data.data(), tail.data(), tail_size);
+            std::size_t read_size = 0;
+            try {
+                while (tail_size + read_size < buffer.data.size()) {
+                    const std::size_t size = source.Read(
+                        std::span(buffer.data).subspan(tail_size + read_size));
+                    if (size == 0) {
+                        finished = true;
+                        break;
+                    }
+                    read_size += size;
+                }
+            } catch (...) {
+                save_error();
+                finished = true;
+            }
+            if (read_size == 0) {
+                Push(free_buffers, buffer_index);
+                break;
+            }
+
+            buffer.size         = tail_size + read_size;
+            buffer.overlap_size = tail_size;
+            buffer.source_index = source_index;
+            buffer.offset       = offset - tail_size;
+            offset += read_size;
+            const std::size_t next_tail_size =
+                std::min(overlap_size, buffer.size);
+            tail.assign(buffer.data.data() + buffer.size - next_tail_size,
+                        next_tail_size);
+            readers_counters_.processed_items_count.fetch_add(
+                1, std::memory_order_relaxed);
+            Push(scan_queue, buffer_index);
+        }
+    };
+    auto reader = [&]() {
+        for (std::size_t source_index = next_source_index.fetch_add(1);
+             source_index < sources.size();
+             source_index = next_source_index.fetch_add(1)) {
+            read_source(source_index);
+        }
+        if (running_readers_count.fetch_sub(1) == 1) {
+            for (std::size_t i = 0; i < scanner_threads_count; i++) {
+                Push(scan_queue, kEndOfItems);
+            }
+        }
+    };
+
+    std::atomic<std::size_t> running_scanners_count{scanner_threads_count};
+    auto scanner = [&]() {
+        ItemIndex batch_index = kEndOfItems;
+        auto push_batch       = [&]() {
+            Push(sink_queue, batch_index);
+            batch_index = kEndOfItems;
+        };
+        while (true) {
+            const ItemIndex buffer_index =
+                PopWaiting(scan_queue, scanners_counters_.input_stalls_count);
+            if (buffer_index == kEndOfItems) {
+                break;
+            }
+            scanners_counters_.input_occupancy_sum.fetch_add(
+                scan_queue.ApproximateSize() + 1, std::memory_order_relaxed);
+
+            const Buffer& buffer = buffers[buffer_index];
+            // Substrings ending in the overlap were found in the previous
+            //  buffer
+            auto on_found = [&](const ACTrie::FoundSubstringInfo& info) {
+                const std::size_t length = info.found_substring.size();
+                if (info.substring_start_index + length <=
+                    buffer.overlap_size) {
+                    return;
+                }
+                if (batch_index == kEndOfItems) {
+                    batch_index = PopWaiting(
+                        free_batches, scanners_counters_.output_stalls_count);
+                    batches[batch_index].source_index = buffer.source_index;
+                    batches[batch_index].matches.clear();
+                }
+                std::vector<Match>& matches = batches[batch_index].matches;
+                matches.push_back(Match{
+                    .offset     = buffer.offset + info.substring_start_index,
+                    .word_index = info.word_index,
+                    .length     = ACTrie::WordLength(length),
+                });
+                if (matches.size() == batch_capacity_) {
+                    push_batch();
+                }
+            };
+            actrie_.FindAllSubstringsInText(
+                std::string_view(buffer.data.data(), buffer.size), on_found);
+            Push(free_buffers, buffer_index);
+            if (batch_index != kEndOfItems) {
+                push_batch();
+            }
+            scanners_counters_.processed_items_count.fetch_add(
+                1, std::memory_order_relaxed);
+        }
+        if (running_scanners_count.fetch_sub(1) == 1) {
+            for (std::size_t i = 0; i < sink_threads_count_; i++) {
+                Push(sink_queue, kEndOfItems);
+            }
+        }
+    };
+
+    auto sinker = [&]() {
+        while (true) {
+            const ItemIndex batch_index =
+                PopWaiting(sink_queue, sinks_counters_.input_stalls_count);
+            if (batch_index == kEndOfItems) {
+                break;
+            }
+            sinks_counters_.input_occupancy_sum.fetch_add(
+                sink_queue.ApproximateSize() + 1, std::memory_order_relaxed);
+
+            try {
+                sink.OnMatches(batches[batch_index]);
+            } catch (...) {
+                save_error();
+            }
+            Push(free_batches, batch_index);
+            sinks_counters_.processed_items_count.fetch_add(
+                1, std::memory_order_relaxed);
+        }
+    };
+
+    auto worker = [&](std::size_t thread_index) {
+        if (thread_index < reader_threads_count) {
+            reader();
+        } else if (thread_index < readers_and_scanners_count) {
+            scanner();
+        } else {
+            sinker();
+        }
+    };
+    Workers::Run(readers_and_scanners_count + sink_threads_count_, worker);
+    if (first_error) {
+        std::rethrow_exception(first_error);
+    }
+}
+
+ScanPipeline::Stats ScanPipeline::GetStats() const noexcept {
+    auto average_occupancy = [](const StageCounters& counters) {
+        const auto items_count =
+            counters.processed_items_count.load(std::memory_order_relaxed);
+        return items_count != 0
+                   ? double(counters.input_occupancy_sum.load(
+                         std::memory_order_relaxed)) /
+                         double(items_count)
+                   : 0.0;
+    };
+    return Stats{
+        .readers              = readers_counters_.GetStats(),
+        .scanners             = scanners_counters_.GetStats(),
+        .sinks                = sinks_counters_.GetStats(),
+        .scan_queue_occupancy = average_occupancy(scanners_counters_),
+        .sink_queue_occupancy = average_occupancy(sinks_counters_),
+    };
+}
+
+void ScanPipeline::StageCounters::Reset() noexcept {
+    processed_items_count.store(0, std::memory_order_relaxed);
+    input_stalls_count.store(0, std::memory_order_relaxed);
+    output_stalls_count.store(0, std::memory_order_relaxed);
+    input_occupancy_sum.store(0, std::memory_order_relaxed);
+}
+
+ScanPipeline::StageStats ScanPipeline::StageCounters::GetStats()
+    const noexcept {
+    return StageStats{
+        .processed_items_count =
+            processed_items_count.load(std::memory_order_relaxed),
+        .input_stalls_count =
+            input_stalls_count.load(std::memory_order_relaxed),
+        .output_stalls_count =
+            output_stalls_count.load(std::memory_order_relaxed),
+    };
+}
+
+}  // namespace AppSpace::ACTrieDS
@@ -0,0 +1,161 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <span>
+#include <string_view>
+#include <vector>
+
+#include "ACTrie.hpp"
+
+namespace AppSpace::ACTrieDS {
+
+/// @brief Source of the bytes read by the reader threads of ScanPipeline.
+class ByteSource {
+public:
+    virtual ~ByteSource() = default;
+    /// @brief Fills the beginning of the buffer. Throws std::system_error
+    ///         if the source can not be read.
+    /// @param buffer
+    /// @return Number of the read bytes, 0 only at the end of the source.
+    virtual std::size_t Read(std::span<char> buffer) = 0;
+};
+
+/// @brief Reads the std::FILE (a file, a pipe or stdin).
+class FileByteSource final : public ByteSource {
+public:
+    /// @param file is not closed by the source
+    explicit FileByteSource(std::FILE* file) noexcept;
+    std::size_t Read(std::span<char> buffer) override;
+
+private:
+    std::FILE* file_;
+};
+
+/// @brief Gives the text in memory by parts of at most max_read_size bytes.
+class TextByteSource final : public ByteSource {
+public:
+    explicit TextByteSource(std::string_view text,
+                            std::size_t max_read_size = SIZE_MAX) noexcept;
+    std::size_t Read(std::span<char> buffer) override;
+
+private:
+    std::string_view text_;
+    std::size_t max_read_size_;
+};
+
+/// @brief Scans the streams of any length in the constant memory by three
+///         stages of threads connected by the bounded lock-free queues:
+///         readers fill the buffers, scanners walk the ACTrie over them
+///         and put the matches into the batches, sinks give the batches to
+///         the MatchesSink.
+///
+///  Buffers and batches are allocated once and recycled through the queues
+///   of the free ones. Reader waits for a free buffer while all buffers
+///   are queued or scanned, and scanner waits for a free batch while all
+///   batches are queued for the sinks, so the slowest stage holds back the
+///   others. Each buffer starts with the last MaxPatternLength() - 1 bytes
+///   of the previous buffer of the same source, so the buffers are scanned
+///   independently and the patterns crossing their boundaries are found
+///   once. Every time a thread has to wait for a queue, the stall counter
+///   of its stage is incremented: the stage with many input stalls waits
+///   for the previous one, with many output stalls for the next one.
+class ScanPipeline final {
+public:
+    struct Match final {
+        // Offset of the first symbol of the match in the source
+        std::uint64_t offset;
+        ACTrie::WordLength word_index;
+        ACTrie::WordLength length;
+    };
+
+    /// @brief Matches of the part of one source, ordered like
+    ///         ACTrie::FindAllSubstringsInText() gives them. Batches come to
+    ///         the sink in any order.
+    struct MatchesBatch final {
+        std::size_t source_index;
+        std::vector<Match> matches;
+    };
+
+    class MatchesSink {
+    public:
+        virtual ~MatchesSink() = default;
+        /// @brief Called by the sink threads, at once by several of them
+        ///         only if the sink threads count is greater than 1.
+        virtual void OnMatches(const MatchesBatch& batch) = 0;
+    };
+
+    struct StageStats final {
+        // Buffers for the readers and the scanners, batches for the sinks
+        std::uint64_t processed_items_count;
+        // Waits for the queue from the previous stage
+        std::uint64_t input_stalls_count;
+        // Waits for the free buffers or batches
+        std::uint64_t output_stalls_count;
+    };
+
+    struct Stats final {
+        StageStats readers;
+        StageStats scanners;
+        StageStats sinks;
+        // Average number of the items in the queue seen by the consumers
+        double scan_queue_occupancy;
+        double sink_queue_occupancy;
+    };
+
+    static constexpr std::size_t kDefaultBufferSize    = std::size_t{1} << 20;
+    static constexpr std::size_t kDefaultBatchCapacity = std::size_t{1} << 12;
+
+    /// @param actrie must be built and must outlive the pipeline
+    explicit ScanPipeline(const ACTrie& actrie);
+    /// @brief 0 scanner threads means the number of hardware threads.
+    ScanPipeline& SetThreadsCounts(std::size_t reader_threads_count,
+                                   std::size_t scanner_threads_count,
+                                   std::size_t sink_threads_count) noexcept;
+    /// @brief 0 buffers or batches means twice the number of the threads
+    ///         of the stages using them.
+    /// @param buffer_size bytes read into one buffer
+    /// @param buffers_count
+    /// @param batch_capacity matches in one batch
+    /// @param batches_count
+    ScanPipeline& SetBuffers(std::size_t buffer_size, std::size_t buffers_count,
+                             std::size_t batch_capacity,
+                             std::size_t batches_count) noexcept;
+    /// @brief Scans all sources (one reader at a time reads each source)
+    ///         and returns when the sink got all batches. First exception
+    ///         thrown by a source or by the sink is rethrown after that, the
+    ///         rest of the failed source is skipped.
+    /// @param sources
+    /// @param sink
+    void Run(std::span<ByteSource* const> sources, MatchesSink& sink);
+    /// @brief Counters of the current or the last Run(), may be read
+    ///         during the Run() from another thread.
+    Stats GetStats() const noexcept;
+
+private:
+    struct alignas(64) StageCounters final {
+        std::atomic<std::uint64_t> processed_items_count{0};
+        std::atomic<std::uint64_t> input_stalls_count{0};
+        std::atomic<std::uint64_t> output_stalls_count{0};
+        std::atomic<std::uint64_t> input_occupancy_sum{0};
+
+        void Reset() noexcept;
+        StageStats GetStats() const noexcept;
+    };
+
+    const ACTrie& actrie_;
+    std::size_t reader_threads_count_  = 1;
+    std::size_t scanner_threads_count_ = 0;
+    std::size_t sink_threads_count_    = 1;
+    std::size_t buffer_size_           = kDefaultBufferSize;
+    std::size_t buffers_count_         = 0;
+    std::size_t batch_capacity_        = kDefaultBatchCapacity;
+    std::size_t batches_count_         = 0;
+    StageCounters readers_counters_;
+    StageCounters scanners_counters_;
+    StageCounters sinks_counters_;
+};
+
+}  // namespace AppSpace::ACTrieDS
@@ -0,0 +1,158 @@
+#include "ShiftAndMatcher.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+
+namespace AppSpace::ACTrieDS {
+
+static_assert(!ACTrie::kIsCaseInsensitive,
+              "ShiftAndMatcher compares symbols case sensitively");
+
+ShiftAndMatcher& ShiftAndMatcher::AddPattern(Pattern pattern) {
+    assert(!is_ready_);
+    if (is_ready_) {
+        ResetShiftAndMatcher();
+    }
+
+    if (const std::size_t bad_symbol_index =
+            StoredPatterns::FindBadSymbol(pattern);
+        bad_symbol_index != pattern.size()) {
+        bad_input_port_.Notify({bad_symbol_index, pattern[bad_symbol_index]});
+        return *this;
+    }
+
+    // Repeated pattern takes no more bits
+    const bool is_repeated = patterns_.Contains(pattern);
+    if (!is_repeated &&
+        pattern.size() > kMaxPatternsTotalLength - patterns_total_length_) {
+        const std::size_t first_not_fitting_symbol_index =
+            kMaxPatternsTotalLength - patterns_total_length_;
+        bad_input_port_.Notify({first_not_fitting_symbol_index,
+                                pattern[first_not_fitting_symbol_index]});
+        return *this;
+    }
+
+    patterns_.Add(pattern);
+    if (!is_repeated) {
+        patterns_total_length_ += pattern.size();
+    }
+    return *this;
+}
+
+ShiftAndMatcher& ShiftAndMatcher::BuildShiftAndMatcher() {
+    assert(!is_ready_);
+    patterns_.DedupeKeepLast();
+    // Longer patterns occupy lower bits, so that iterating over the
+    //  found bits from the lowest one reports longer substrings first.
+    std::stable_sort(patterns_.begin(), patterns_.end(),
+                     [](const StoredPattern& lhs, const StoredPattern& rhs) {
+                         return lhs.pattern.size() > rhs.pattern.size();
+                     });
+
+    symbols_masks_.fill(BitVector{});
+    start_bits_ = BitVector{};
+    final_bits_ = BitVector{};
+    std::size_t bit_index = 0;
+    for (std::size_t i = 0; i < patterns_.size(); i++) {
+        const std::string& pattern = patterns_[i].pattern;
+        assert(!pattern.empty());
+        start_bits_[bit_index / kBitWordSize] |= BitWord{1}
+                                                 << (bit_index % kBitWordSize);
+        for (char symbol : pattern) {
+            symbols_masks_[static_cast<std::uint8_t>(symbol)]
+                          [bit_index / kBitWordSize] |=
+                BitWord{1} << (bit_index % kBitWordSize);
+            bit_index++;
+        }
+        const std::size_t final_bit_index = bit_index - 1;
+        final_bits_[final_bit_index / kBitWordSize] |=
+            BitWord{1} << (final_bit_index % kBitWordSize);
+        final_bit_patterns_[final_bit_index] = static_cast<std::uint32_t>(i);
+    }
+    assert(bit_index == patterns_total_length_);
+
+    is_ready_ = true;
+    return *this;
+}
+
+ShiftAndMatcher& ShiftAndMatcher::ResetShiftAndMatcher() {
+    is_ready_ = false;
+    patterns_.Clear();
+    patterns_total_length_ = 0;
+    return *this;
+}
+
+ShiftAndMatcher& ShiftAndMatcher::FindAllSubstringsInText(Text text) {
+    if (!is_ready_) {
+        BuildShiftAndMatcher();
+    }
+
+    if (patterns_total_length_ <= kBitWordSize) {
+        FindAllSubstringsInTextImpl<1>(text);
+    } else {
+        FindAllSubstringsInTextImpl<2>(text);
+    }
+    return *this;
+}
+
+ShiftAndMatcher& ShiftAndMatcher::AddSubscriber(
+    FoundSubstringObserver* observer) {
+    found_substrings_port_.Subscribe(observer);
+    return *this;
+}
+
+ShiftAndMatcher& ShiftAndMatcher::AddSubscriber(
+    BadInputPatternObserver* observer) {
+    bad_input_port_.Subscribe(observer);
+    return *this;
+}
+
+template <std::size_t BitWordsCount>
+void ShiftAndMatcher::FindAllSubstringsInTextImpl(Text text) {
+    static_assert(0 < BitWordsCount && BitWordsCount <= kMaxBitWordsCount);
+    std::array<BitWord, BitWordsCount> state{};
+    for (std::size_t i = 0; i < text.size(); i++) {
+        const BitVector& symbol_mask =
+            symbols_masks_[static_cast<std::uint8_t>(text[i])];
+        BitWord carry = 0;
+        BitWord found = 0;
+        for (std::size_t w = 0; w < BitWordsCount; w++) {
+            const BitWord next_carry = state[w] >> (kBitWordSize - 1);
+            state[w] = ((state[w] << 1) | carry | start_bits_[w]) &
+                       symbol_mask[w];
+            carry = next_carry;
+            found |= state[w] & final_bits_[w];
+        }
+
+        if (found != 0) [[unlikely]] {
+            for (std::size_t w = 0; w < BitWordsCount; w++) {
+                NotifyAboutFoundSubstrings(text, i, w,
+                                           state[w] & final_bits_[w]);
+            }
+        }
+    }
+}
+
+void ShiftAndMatcher::NotifyAboutFoundSubstrings(Text text,
+                                                 std::size_t position_in_text,
+                                                 std::size_t bit_word_index,
+                                                 BitWord found_bits) {
+    for (; found_bits != 0; found_bits &= found_bits - 1) {
+        const std::size_t bit_index =
+            bit_word_index * kBitWordSize +
+            static_cast<std::size_t>(std::countr_zero(found_bits));
+        const StoredPattern& stored_pattern =
+            patterns_[final_bit_patterns_[bit_index]];
+        const std::size_t length         = stored_pattern.pattern.size();
+        const std::size_t start_position = position_in_text + 1 - length;
+        found_substrings_port_.Notify(FoundSubstringInfo{
+            .found_substring       = text.substr(start_position, length),
+            .substring_start_index = start_position,
+            .current_vertex_index  = ACTrie::kNullNodeIndex,
+            .word_index            = stored_pattern.word_index,
+        });
+    }
+}
+
+}  // namespace AppSpace::ACTrieDS
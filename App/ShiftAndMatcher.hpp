@@ -0,0 +1,99 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <string_view>
+
+#include "ACTrie.hpp"
+#include "Observer.hpp"
+#include "StoredPatterns.hpp"
+
+namespace AppSpace::ACTrieDS {
+
+/// @brief Bit-parallel matcher (Shift-And, the dual form of the Shift-Or)
+///         for small sets of short patterns.
+///
+///  All patterns are concatenated into one bit vector of at most
+///   kMaxPatternsTotalLength bits. i-th bit of the state is set if the
+///   symbols of the concatenation from the start of the pattern containing
+///   i-th position up to i-th position match the last read symbols of the
+///   text. One text symbol costs a shift, an or and an and of the state
+///   words, there are no nodes and no data dependent branches except for
+///   the reporting of the found substrings.
+///
+///  Has the same interface for adding patterns and reporting found substrings
+///   as the ACTrie and reports substrings in the same order (by the end
+///   position, longer first). current_vertex_index of the found substring is
+///   always ACTrie::kNullNodeIndex. The empty pattern takes no bits and is
+///   never reported, unlike in the ACTrie (see StoredPatterns).
+class ShiftAndMatcher final {
+public:
+    using WordLength                = ACTrie::WordLength;
+    using Pattern                   = ACTrie::Pattern;
+    using Text                      = ACTrie::Text;
+    using FoundSubstringInfo        = ACTrie::FoundSubstringInfo;
+    using BadInputPatternInfo       = ACTrie::BadInputPatternInfo;
+    using FoundSubstringInfoPassBy  = ACTrie::FoundSubstringInfoPassBy;
+    using BadInputPatternInfoPassBy = ACTrie::BadInputPatternInfoPassBy;
+    using FoundSubstringObserver    = ACTrie::FoundSubstringObserver;
+    using BadInputPatternObserver   = ACTrie::BadInputPatternObserver;
+
+    using BitWord                                  = std::uint64_t;
+    static constexpr std::size_t kBitWordSize      = 64;
+    static constexpr std::size_t kMaxBitWordsCount = 2;
+    static constexpr std::size_t kMaxPatternsTotalLength =
+        kBitWordSize * kMaxBitWordsCount;
+
+    /// @brief Adds pattern to the set. If the pattern does not fit into the
+    ///         kMaxPatternsTotalLength bits with the previously added
+    ///         patterns, bad input is reported with the index of the first
+    ///         symbol that does not fit.
+    /// @param pattern
+    ShiftAndMatcher& AddPattern(Pattern pattern);
+    ShiftAndMatcher& BuildShiftAndMatcher();
+    ShiftAndMatcher& ResetShiftAndMatcher();
+    ShiftAndMatcher& FindAllSubstringsInText(Text text);
+    ShiftAndMatcher& AddSubscriber(FoundSubstringObserver* observer);
+    ShiftAndMatcher& AddSubscriber(BadInputPatternObserver* observer);
+    constexpr std::size_t PatternsSize() const noexcept;
+    constexpr std::size_t PatternsTotalLength() const noexcept;
+
+private:
+    using BitVector = std::array<BitWord, kMaxBitWordsCount>;
+    static constexpr std::size_t kSymbolsCount =
+        std::numeric_limits<std::uint8_t>::max() + 1;
+
+    template <std::size_t BitWordsCount>
+    void FindAllSubstringsInTextImpl(Text text);
+    void NotifyAboutFoundSubstrings(Text text, std::size_t position_in_text,
+                                    std::size_t bit_word_index,
+                                    BitWord found_bits);
+
+    StoredPatterns patterns_;
+    // symbols_masks_[c] has i-th bit set iff i-th symbol of the
+    //  concatenation of the patterns is c
+    std::array<BitVector, kSymbolsCount> symbols_masks_{};
+    // Bits of the first symbols of the patterns
+    BitVector start_bits_{};
+    // Bits of the last symbols of the patterns
+    BitVector final_bits_{};
+    // Index in patterns_ of the pattern ending on the i-th bit
+    std::array<std::uint32_t, kMaxPatternsTotalLength> final_bit_patterns_{};
+    std::size_t patterns_total_length_ = 0;
+    bool is_ready_                     = false;
+    Observable<FoundSubstringInfo, FoundSubstringInfoPassBy>
+        found_substrings_port_;
+    Observable<BadInputPatternInfo, BadInputPatternInfoPassBy> bad_input_port_;
+};
+
+constexpr std::size_t ShiftAndMatcher::PatternsSize() const noexcept {
+    return patterns_.AddedSize();
+}
+
+constexpr std::size_t ShiftAndMatcher::PatternsTotalLength() const noexcept {
+    return patterns_total_length_;
+}
+
+}  // namespace AppSpace::ACTrieDS
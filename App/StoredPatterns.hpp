@@ -0,0 +1,128 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "ACTrie.hpp"
+
+namespace AppSpace::ACTrieDS {
+
+/// @brief Pattern kept as the string with its word index.
+struct StoredPattern {
+    std::string pattern;
+    ACTrie::WordLength word_index;
+};
+
+/// @brief Patterns of the matchers which keep them as the strings until the
+///         build, in the order of the addition.
+///
+///  Each added pattern takes the next word index, like in the ACTrie. Empty
+///   pattern takes its index too, but it is not stored, so the matchers
+///   built from the stored patterns never report it. The ACTrie does: its
+///   terminal root is reported each time its walk returns to the root,
+///   which depends on its automaton and can not be reproduced from the
+///   patterns by the other matchers.
+///
+///  Repeated patterns are stored until DedupeKeepLast().
+/// @tparam TStoredPattern aggregate with the std::string pattern and the
+///          WordLength word_index as the first members, other members have
+///          the default initializers
+template <class TStoredPattern = StoredPattern>
+class BasicStoredPatterns final {
+public:
+    using WordLength = ACTrie::WordLength;
+    using Pattern    = ACTrie::Pattern;
+
+    /// @brief Returns the index of the first symbol of the pattern which is
+    ///         out of the ACTrie alphabet and is not one of the
+    ///         extra_symbols, pattern.size() if there are none.
+    static constexpr std::size_t FindBadSymbol(
+        Pattern pattern, std::string_view extra_symbols = {}) noexcept {
+        for (std::size_t i = 0; i < pattern.size(); i++) {
+            if (ACTrie::SymbolToIndex(pattern[i]) >= ACTrie::kAlphabetLength &&
+                extra_symbols.find(pattern[i]) == std::string_view::npos) {
+                return i;
+            }
+        }
+        return pattern.size();
+    }
+
+    void Add(Pattern pattern) {
+        const auto word_index = static_cast<WordLength>(added_size_++);
+        if (!pattern.empty()) {
+            patterns_.push_back(TStoredPattern{
+                .pattern    = std::string(pattern),
+                .word_index = word_index,
+            });
+        }
+    }
+
+    /// @brief Leaves one pattern of the repeated ones with the index of the
+    ///         last addition, as the ACTrie reports it. Patterns are sorted
+    ///         after the call.
+    void DedupeKeepLast() {
+        std::stable_sort(
+            patterns_.begin(), patterns_.end(),
+            [](const TStoredPattern& lhs, const TStoredPattern& rhs) {
+                return lhs.pattern < rhs.pattern;
+            });
+        auto reversed_unique_end = std::unique(
+            patterns_.rbegin(), patterns_.rend(),
+            [](const TStoredPattern& lhs, const TStoredPattern& rhs) {
+                return lhs.pattern == rhs.pattern;
+            });
+        patterns_.erase(patterns_.begin(), reversed_unique_end.base());
+    }
+
+    bool Contains(Pattern pattern) const noexcept {
+        return std::ranges::find(patterns_, pattern,
+                                 &TStoredPattern::pattern) != patterns_.end();
+    }
+
+    void Clear() noexcept {
+        patterns_.clear();
+        added_size_ = 0;
+    }
+
+    /// @brief Number of the Add() calls, with the empty and the repeated
+    ///         patterns.
+    constexpr std::size_t AddedSize() const noexcept {
+        return added_size_;
+    }
+
+    auto begin() noexcept {
+        return patterns_.begin();
+    }
+    auto begin() const noexcept {
+        return patterns_.begin();
+    }
+    auto end() noexcept {
+        return patterns_.end();
+    }
+    auto end() const noexcept {
+        return patterns_.end();
+    }
+    std::size_t size() const noexcept {
+        return patterns_.size();
+    }
+    bool empty() const noexcept {
+        return patterns_.empty();
+    }
+    TStoredPattern& operator[](std::size_t index) noexcept {
+        return patterns_[index];
+    }
+    const TStoredPattern& operator[](std::size_t index) const noexcept {
+        return patterns_[index];
+    }
+
+private:
+    std::vector<TStoredPattern> patterns_;
+    std::size_t added_size_ = 0;
+};
+
+using StoredPatterns = BasicStoredPatterns<>;
+
+}  // namespace AppSpace::ACTrieDS
@@ -0,0 +1,315 @@
+#include "StreamScheduler.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cerrno>
+#include <cstring>
+#include <limits>
+#include <mutex>
+#include <system_error>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "BoundedQueue.hpp"
+#include "Workers.hpp"
+
+namespace AppSpace::ACTrieDS {
+
+namespace {
+
+using TaskIndex = std::uint32_t;
+
+}  // namespace
+
+MemoryStreamSource::MemoryStreamSource(std::string_view text,
+                                       std::size_t max_read_size,
+                                       std::size_t not_ready_period) noexcept
+    : text_(text),
+      max_read_size_(max_read_size),
+      not_ready_period_(not_ready_period) {
+    assert(max_read_size_ != 0 && not_ready_period_ != 1);
+}
+
+StreamSource::ReadResult MemoryStreamSource::TryRead(std::span<char> buffer) {
+    reads_count_++;
+    if (not_ready_period_ != 0 && reads_count_ % not_ready_period_ == 0) {
+        return {.status = ReadStatus::kNotReady, .size = 0};
+    }
+    if (text_.empty()) {
+        return {.status = ReadStatus::kEnd, .size = 0};
+    }
+
+    const std::size_t read_size =
+        std::min({buffer.size(), max_read_size_, text_.size()});
+    std::memcpy(buffer.data(), text_.data(), read_size);
+    text_.remove_prefix(read_size);
+    return {.status = ReadStatus::kRead, .size = read_size};
+}
+
+FileStreamSource::FileStreamSource(std::FILE* file) noexcept : file_(file) {
+    assert(file_ != nullptr);
+}
+
+StreamSource::ReadResult FileStreamSource::TryRead(std::span<char> buffer) {
+    const std::size_t read_size =
+        std::fread(buffer.data(), 1, buffer.size(), file_);
+    if (read_size < buffer.size() && std::ferror(file_) != 0) {
+        throw std::system_error(errno != 0 ? errno : EIO,
+                                std::generic_category(), "fread");
+    }
+    return {.status = read_size != 0 ? ReadStatus::kRead : ReadStatus::kEnd,
+            .size   = read_size};
+}
+
+ScanTask::ReadAwaiter::ReadAwaiter(StreamSource& source,
+                                   std::span<char> buffer) noexcept
+    : source_(source), buffer_(buffer) {
+    assert(!buffer_.empty());
+}
+
+bool ScanTask::ReadAwaiter::await_ready() {
+    return TryRead();
+}
+
+void ScanTask::ReadAwaiter::await_suspend(Handle handle) noexcept {
+    handle.promise().pending_read_ = this;
+}
+
+std::size_t ScanTask::ReadAwaiter::await_resume() const noexcept {
+    return read_size_;
+}
+
+bool ScanTask::ReadAwaiter::TryRead() {
+    const StreamSource::ReadResult result = source_.TryRead(buffer_);
+    read_size_                            = result.size;
+    return result.status != StreamSource::ReadStatus::kNotReady;
+}
+
+ScanTask ScanTask::promise_type::get_return_object() noexcept {
+    return ScanTask(Handle::from_promise(*this));
+}
+
+std::suspend_always ScanTask::promise_type::initial_suspend() const noexcept {
+    return {};
+}
+
+std::suspend_always ScanTask::promise_type::final_suspend() const noexcept {
+    return {};
+}
+
+std::suspend_always ScanTask::promise_type::yield_value(
+    const ScanPipeline::MatchesBatch& batch) noexcept {
+    yielded_batch_ = &batch;
+    return {};
+}
+
+void ScanTask::promise_type::return_void() const noexcept {}
+
+void ScanTask::promise_type::unhandled_exception() noexcept {
+    error_ = std::current_exception();
+}
+
+ScanTask::ReadAwaiter ScanTask::Read(StreamSource& source,
+                                     std::span<char> buffer) noexcept {
+    return ReadAwaiter(source, buffer);
+}
+
+ScanTask::ScanTask(Handle handle) noexcept : handle_(handle) {}
+
+ScanTask::ScanTask(ScanTask&& other) noexcept
+    : handle_(std::exchange(other.handle_, nullptr)) {}
+
+ScanTask& ScanTask::operator=(ScanTask&& other) noexcept {
+    if (this != &other) {
+        if (handle_) {
+            handle_.destroy();
+        }
+        handle_ = std::exchange(other.handle_, nullptr);
+    }
+    return *this;
+}
+
+ScanTask::~ScanTask() {
+    if (handle_) {
+        handle_.destroy();
+    }
+}
+
+ScanTask::State ScanTask::Resume() {
+    assert(handle_ && !handle_.done());
+    promise_type& promise  = handle_.promise();
+    promise.yielded_batch_ = nullptr;
+    if (promise.pending_read_ != nullptr) {
+        if (!promise.pending_read_->TryRead()) {
+            return State::kWaitsForSource;
+        }
+        promise.pending_read_ = nullptr;
+    }
+
+    handle_.resume();
+    if (handle_.done()) {
+        if (promise.error_) {
+            std::rethrow_exception(std::exchange(promise.error_, nullptr));
+        }
+        return State::kDone;
+    }
+    return promise.yielded_batch_ != nullptr ? State::kYieldedBatch
+                                             : State::kWaitsForSource;
+}
+
+const ScanPipeline::MatchesBatch& ScanTask::YieldedBatch() const noexcept {
+    assert(handle_ && handle_.promise().yielded_batch_ != nullptr);
+    return *handle_.promise().yielded_batch_;
+}
+
+bool ScanTask::IsDone() const noexcept {
+    return !handle_ || handle_.done();
+}
+
+ScanTask ScanStream(const ACTrie& actrie, StreamSource& source,
+                    std::size_t source_index, std::size_t buffer_size,
+                    std::size_t batch_capacity) {
+    assert(actrie.IsReady() && buffer_size != 0 && batch_capacity != 0);
+    std::vector<char> buffer(buffer_size);
+    ScanPipeline::MatchesBatch batch{
+        .source_index = source_index,
+        .matches      = {},
+    };
+    batch.matches.reserve(batch_capacity);
+    ACTrie::ScanCursor cursor;
+    // Offset of the current part in the source
+    std::uint64_t offset = 0;
+    while (const std::size_t read_size =
+               co_await ScanTask::Read(source, buffer)) {
+        const ACTrie::Text part(buffer.data(), read_size);
+        while (const std::optional<ACTrie::FoundInStreamInfo> info =
+                   actrie.FindNextInStream(part, ACTrie::kAllGroups, cursor)) {
+            batch.matches.push_back(ScanPipeline::Match{
+                .offset     = offset + info->end_index - info->length,
+                .word_index = info->word_index,
+                .length     = info->length,
+            });
+            if (batch.matches.size() == batch_capacity) {
+                co_yield batch;
+                batch.matches.clear();
+            }
+        }
+        offset += read_size;
+    }
+    if (!batch.matches.empty()) {
+        co_yield batch;
+    }
+}
+
+StreamScheduler::StreamScheduler(const ACTrie& actrie,
+                                 std::size_t threads_count)
+    : actrie_(actrie),
+      threads_count_(threads_count != 0 ? threads_count
+                                        : Workers::HardwareThreadsCount()) {
+    assert(actrie_.IsReady());
+}
+
+StreamScheduler& StreamScheduler::SetBuffers(
+    std::size_t buffer_size, std::size_t batch_capacity) noexcept {
+    assert(buffer_size != 0 && batch_capacity != 0);
+    buffer_size_    = buffer_size;
+    batch_capacity_ = batch_capacity;
+    return *this;
+}
+
+void StreamScheduler::Run(std::span<StreamSource* const> sources,
+                          ScanPipeline::MatchesSink& sink) {
+    std::vector<ScanTask> tasks;
+    tasks.reserve(sources.size());
+    for (std::size_t i = 0; i < sources.size(); i++) {
+        tasks.push_back(
+            ScanStream(actrie_, *sources[i], i, buffer_size_, batch_capacity_));
+    }
+    Run(tasks, sink);
+}
+
+void StreamScheduler::Run(std::span<ScanTask> tasks,
+                          ScanPipeline::MatchesSink& sink) {
+    stats_ = Stats{};
+    assert(tasks.size() < std::numeric_limits<TaskIndex>::max());
+    const auto tasks_count = std::size_t(std::ranges::count_if(
+        tasks, [](const ScanTask& task) { return !task.IsDone(); }));
+    // Task is resumed by one thread at a time, more threads would only wait
+    const std::size_t threads_count =
+        std::clamp(tasks_count, std::size_t{1}, threads_count_);
+    // Each task is in the queue at most once. Push may still fail for a
+    //  while if a thread that popped from the cell one lap ago is preempted
+    //  before it frees the cell.
+    BoundedQueue<TaskIndex> ready_tasks(tasks_count);
+    auto push = [&ready_tasks](TaskIndex task_index) noexcept {
+        while (!ready_tasks.TryPush(task_index)) {
+            std::this_thread::yield();
+        }
+    };
+    for (std::size_t i = 0; i < tasks.size(); i++) {
+        if (!tasks[i].IsDone()) {
+            push(TaskIndex(i));
+        }
+    }
+
+    std::atomic<std::size_t> running_tasks_count{tasks_count};
+    std::atomic<std::uint64_t> resumes_count{0};
+    std::atomic<std::uint64_t> not_ready_count{0};
+    std::atomic<std::uint64_t> batches_count{0};
+    std::mutex first_error_mutex;
+    std::exception_ptr first_error;
+    auto worker = [&](std::size_t) {
+        while (running_tasks_count.load(std::memory_order_acquire) != 0) {
+            TaskIndex task_index = 0;
+            if (!ready_tasks.TryPop(task_index)) {
+                // Other threads run the rest of the tasks
+                std::this_thread::yield();
+                continue;
+            }
+
+            ScanTask& task = tasks[task_index];
+            resumes_count.fetch_add(1, std::memory_order_relaxed);
+            try {
+                switch (task.Resume()) {
+                    case ScanTask::State::kWaitsForSource:
+                        not_ready_count.fetch_add(1,
+                                                  std::memory_order_relaxed);
+                        break;
+                    case ScanTask::State::kYieldedBatch:
+                        batches_count.fetch_add(1, std::memory_order_relaxed);
+                        sink.OnMatches(task.YieldedBatch());
+                        break;
+                    case ScanTask::State::kDone:
+                        running_tasks_count.fetch_sub(
+                            1, std::memory_order_release);
+                        continue;
+                }
+            } catch (...) {
+                {
+                    std::lock_guard lock(first_error_mutex);
+                    if (!first_error) {
+                        first_error = std::current_exception();
+                    }
+                }
+                task = ScanTask();
+                running_tasks_count.fetch_sub(1, std::memory_order_release);
+                continue;
+            }
+            push(task_index);
+        }
+    };
+    Workers::Run(threads_count, worker);
+
+    stats_ = Stats{
+        .resumes_count   = resumes_count.load(std::memory_order_relaxed),
+        .not_ready_count = not_ready_count.load(std::memory_order_relaxed),
+        .batches_count   = batches_count.load(std::memory_order_relaxed),
+    };
+    if (first_error) {
+        std::rethrow_exception(first_error);
+    }
+}
+
+}  // namespace AppSpace::ACTrieDS
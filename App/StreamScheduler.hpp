@@ -0,0 +1,222 @@
+#pragma once
+
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <exception>
+#include <span>
+#include <string_view>
+
+#include "ACTrie.hpp"
+#include "ScanPipeline.hpp"
+
+namespace AppSpace::ACTrieDS {
+
+/// @brief Source of the bytes of a stream that may have no data yet (a
+///         socket, a pipe, a ring of captured packets), read without
+///         blocking by the tasks of StreamScheduler.
+class StreamSource {
+public:
+    enum class ReadStatus {
+        kRead,
+        // No data now, the read will be retried later
+        kNotReady,
+        kEnd,
+    };
+
+    struct ReadResult final {
+        ReadStatus status;
+        // Number of the read bytes, not 0 only for kRead
+        std::size_t size;
+    };
+
+    virtual ~StreamSource() = default;
+    /// @brief Fills the beginning of the buffer without blocking. Throws
+    ///         std::system_error if the source can not be read.
+    /// @param buffer
+    virtual ReadResult TryRead(std::span<char> buffer) = 0;
+};
+
+/// @brief Gives the text in memory by parts of at most max_read_size bytes.
+///         Every not_ready_period-th read finds no data (0 means never), to
+///         check the tasks waiting for the slow streams.
+class MemoryStreamSource final : public StreamSource {
+public:
+    explicit MemoryStreamSource(std::string_view text,
+                                std::size_t max_read_size    = SIZE_MAX,
+                                std::size_t not_ready_period = 0) noexcept;
+    ReadResult TryRead(std::span<char> buffer) override;
+
+private:
+    std::string_view text_;
+    std::size_t max_read_size_;
+    std::size_t not_ready_period_;
+    std::size_t reads_count_ = 0;
+};
+
+/// @brief Reads the std::FILE, which is always ready (regular files are
+///         read from the page cache or wait for the disk in fread()).
+class FileStreamSource final : public StreamSource {
+public:
+    /// @param file is not closed by the source
+    explicit FileStreamSource(std::FILE* file) noexcept;
+    ReadResult TryRead(std::span<char> buffer) override;
+
+private:
+    std::FILE* file_;
+};
+
+/// @brief Coroutine run by StreamScheduler. It waits for the data by
+///         `co_await ScanTask::Read(source, buffer)`, which gives the number
+///         of the read bytes (0 at the end of the source), and gives the
+///         matches to the sink of the scheduler by `co_yield batch`. The
+///         batch must stay unchanged until the task is resumed.
+///
+///  Task is created suspended and owns its coroutine frame.
+class ScanTask final {
+public:
+    class promise_type;
+    using Handle = std::coroutine_handle<promise_type>;
+
+    enum class State {
+        kWaitsForSource,
+        kYieldedBatch,
+        kDone,
+    };
+
+    class ReadAwaiter final {
+    public:
+        ReadAwaiter(StreamSource& source, std::span<char> buffer) noexcept;
+        bool await_ready();
+        void await_suspend(Handle handle) noexcept;
+        std::size_t await_resume() const noexcept;
+        /// @brief Returns false if the source is not ready.
+        bool TryRead();
+
+    private:
+        StreamSource& source_;
+        std::span<char> buffer_;
+        std::size_t read_size_ = 0;
+    };
+
+    class promise_type final {
+    public:
+        ScanTask get_return_object() noexcept;
+        std::suspend_always initial_suspend() const noexcept;
+        std::suspend_always final_suspend() const noexcept;
+        std::suspend_always yield_value(
+            const ScanPipeline::MatchesBatch& batch) noexcept;
+        void return_void() const noexcept;
+        void unhandled_exception() noexcept;
+
+    private:
+        friend class ScanTask;
+
+        const ScanPipeline::MatchesBatch* yielded_batch_ = nullptr;
+        ReadAwaiter* pending_read_                       = nullptr;
+        std::exception_ptr error_;
+    };
+
+    static ReadAwaiter Read(StreamSource& source,
+                            std::span<char> buffer) noexcept;
+
+    ScanTask() noexcept = default;
+    ScanTask(ScanTask&& other) noexcept;
+    ScanTask& operator=(ScanTask&& other) noexcept;
+    ~ScanTask();
+
+    /// @brief Runs the task until it yields a batch, waits for the source
+    ///         that is not ready or finishes. Task that waits for the source
+    ///         is resumed only if the retried read gets the data. Exception
+    ///         of the task is rethrown when it finishes.
+    State Resume();
+    /// @brief Batch of the last Resume() that returned kYieldedBatch.
+    const ScanPipeline::MatchesBatch& YieldedBatch() const noexcept;
+    bool IsDone() const noexcept;
+
+private:
+    explicit ScanTask(Handle handle) noexcept;
+
+    Handle handle_;
+};
+
+/// @brief Scans the source by the parts of buffer_size bytes and yields
+///         the matches by batches of batch_capacity. The automaton state is
+///         kept between the parts (see ACTrie::FindNextInStream()), so the
+///         frame holds only one buffer and one batch.
+/// @param actrie must be built and must outlive the task
+/// @param source must outlive the task
+/// @param source_index is put into the batches
+/// @param buffer_size
+/// @param batch_capacity
+ScanTask ScanStream(const ACTrie& actrie, StreamSource& source,
+                    std::size_t source_index, std::size_t buffer_size,
+                    std::size_t batch_capacity);
+
+/// @brief Runs many scan tasks on a few threads: thousands of the streams
+///         (one per connection or capture) are multiplexed without a thread
+///         per stream.
+///
+///  Ready tasks wait in the lock-free queue. A thread takes a task and
+///   resumes it: the task scans until it yields a batch, which is given to
+///   the sink, or until its source is not ready, then the task is put back
+///   to the end of the queue, so the streams share the threads fairly. One
+///   task is resumed by one thread at a time, so the batches of a stream
+///   come to the sink in order.
+class StreamScheduler final {
+public:
+    struct Stats final {
+        std::uint64_t resumes_count;
+        // Resumes that found the source not ready
+        std::uint64_t not_ready_count;
+        std::uint64_t batches_count;
+    };
+
+    static constexpr std::size_t kDefaultBufferSize    = std::size_t{1} << 16;
+    static constexpr std::size_t kDefaultBatchCapacity = std::size_t{1} << 10;
+
+    /// @param actrie must be built and must outlive the scheduler
+    /// @param threads_count 0 means the number of hardware threads
+    explicit StreamScheduler(const ACTrie& actrie,
+                             std::size_t threads_count = 0);
+    /// @param buffer_size bytes read at once by each task of Run(sources)
+    /// @param batch_capacity matches in one batch
+    StreamScheduler& SetBuffers(std::size_t buffer_size,
+                                std::size_t batch_capacity) noexcept;
+    /// @brief Runs ScanStream() for each source (batches get the index of
+    ///         the source), see Run(tasks, sink).
+    /// @param sources
+    /// @param sink
+    void Run(std::span<StreamSource* const> sources,
+             ScanPipeline::MatchesSink& sink);
+    /// @brief Runs the tasks until all of them finish. Sink is called by
+    ///         the threads of the scheduler, at once by several of them if
+    ///         the threads count is greater than 1. First exception thrown
+    ///         by a task or by the sink is rethrown after all tasks finish,
+    ///         the rest of the failed task is skipped.
+    /// @param tasks
+    /// @param sink
+    void Run(std::span<ScanTask> tasks, ScanPipeline::MatchesSink& sink);
+    constexpr std::size_t ThreadsCount() const noexcept;
+    /// @brief Counters of the last Run().
+    constexpr const Stats& GetStats() const noexcept;
+
+private:
+    const ACTrie& actrie_;
+    std::size_t threads_count_;
+    std::size_t buffer_size_    = kDefaultBufferSize;
+    std::size_t batch_capacity_ = kDefaultBatchCapacity;
+    Stats stats_{};
+};
+
+constexpr std::size_t StreamScheduler::ThreadsCount() const noexcept {
+    return threads_count_;
+}
+
+constexpr const StreamScheduler::Stats& StreamScheduler::GetStats()
+    const noexcept {
+    return stats_;
+}
+
+}  // namespace AppSpace::ACTrieDS
@@ -0,0 +1,297 @@
+#include "TeddyMatcher.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <limits>
+
+#include "CpuFeatures.hpp"
+
+namespace AppSpace::ACTrieDS {
+
+namespace {
+
+using FingerprintMasks = TeddyMatcher::FingerprintMasks;
+
+constexpr std::uint8_t kNibbleMask = 0x0F;
+
+static_assert(!ACTrie::kIsCaseInsensitive,
+              "TeddyMatcher compares symbols case sensitively");
+
+/// @brief Checks text[position:] against the fingerprint masks symbol by
+///         symbol. Used when cpu has no SSSE3 and for the tail of the text.
+template <class OnCandidate>
+void ScanScalar(std::string_view text, std::size_t position,
+                const FingerprintMasks& masks, OnCandidate on_candidate) {
+    const std::size_t fingerprint_length = masks.fingerprint_length;
+    for (; position + fingerprint_length <= text.size(); position++) {
+        std::uint8_t buckets_mask = std::numeric_limits<std::uint8_t>::max();
+        for (std::size_t j = 0; j < fingerprint_length; j++) {
+            const auto symbol = static_cast<std::uint8_t>(text[position + j]);
+            buckets_mask &= masks.low_nibbles[j][symbol & kNibbleMask];
+            buckets_mask &= masks.high_nibbles[j][symbol >> 4];
+        }
+        if (buckets_mask != 0) {
+            on_candidate(position, buckets_mask);
+        }
+    }
+}
+
+#if ACTRIE_X86_SIMD
+
+/// @brief Scans the text by blocks of 16 symbols.
+/// @return Position from which the text should be scanned with ScanScalar
+template <class OnCandidate>
+ACTRIE_TARGET_SSSE3 std::size_t ScanSsse3(std::string_view text,
+                                          const FingerprintMasks& masks,
+                                          OnCandidate on_candidate) {
+    constexpr std::size_t kBlockSize     = sizeof(__m128i);
+    const std::size_t fingerprint_length = masks.fingerprint_length;
+    const __m128i nibble_mask            = _mm_set1_epi8(kNibbleMask);
+    const __m128i zero                   = _mm_setzero_si128();
+    __m128i low_tables[TeddyMatcher::kMaxFingerprintLength]{};
+    __m128i high_tables[TeddyMatcher::kMaxFingerprintLength]{};
+    for (std::size_t j = 0; j < fingerprint_length; j++) {
+        low_tables[j] = _mm_loadu_si128(
+            reinterpret_cast<const __m128i*>(masks.low_nibbles[j].data()));
+        high_tables[j] = _mm_loadu_si128(
+            reinterpret_cast<const __m128i*>(masks.high_nibbles[j].data()));
+    }
+
+    alignas(kBlockSize) std::array<std::uint8_t, kBlockSize> buckets{};
+    std::size_t position = 0;
+    for (; position + kBlockSize + fingerprint_length - 1 <= text.size();
+         position += kBlockSize) {
+        __m128i candidates = _mm_set1_epi8(-1);
+        for (std::size_t j = 0; j < fingerprint_length; j++) {
+            const __m128i block = _mm_loadu_si128(
+                reinterpret_cast<const __m128i*>(text.data() + position + j));
+            const __m128i low  = _mm_and_si128(block, nibble_mask);
+            const __m128i high = _mm_and_si128(_mm_srli_epi16(block, 4),
+                                               nibble_mask);
+            candidates         = _mm_and_si128(
+                candidates,
+                _mm_and_si128(_mm_shuffle_epi8(low_tables[j], low),
+                              _mm_shuffle_epi8(high_tables[j], high)));
+        }
+
+        auto positions_mask = static_cast<std::uint32_t>(
+            _mm_movemask_epi8(_mm_cmpeq_epi8(candidates, zero)));
+        positions_mask ^= (1u << kBlockSize) - 1;
+        if (positions_mask == 0) {
+            continue;
+        }
+
+        _mm_store_si128(reinterpret_cast<__m128i*>(buckets.data()),
+                        candidates);
+        do {
+            const auto k = static_cast<std::size_t>(
+                std::countr_zero(positions_mask));
+            on_candidate(position + k, buckets[k]);
+            positions_mask &= positions_mask - 1;
+        } while (positions_mask != 0);
+    }
+
+    return position;
+}
+
+/// @brief Scans the text by blocks of 32 symbols.
+/// @return Position from which the text should be scanned with ScanScalar
+template <class OnCandidate>
+ACTRIE_TARGET_AVX2 std::size_t ScanAvx2(std::string_view text,
+                                        const FingerprintMasks& masks,
+                                        OnCandidate on_candidate) {
+    constexpr std::size_t kBlockSize     = sizeof(__m256i);
+    const std::size_t fingerprint_length = masks.fingerprint_length;
+    const __m256i nibble_mask            = _mm256_set1_epi8(kNibbleMask);
+    const __m256i zero                   = _mm256_setzero_si256();
+    // vpshufb shuffles each 128-bit lane independently,
+    //  so tables are duplicated in both lanes.
+    __m256i low_tables[TeddyMatcher::kMaxFingerprintLength]{};
+    __m256i high_tables[TeddyMatcher::kMaxFingerprintLength]{};
+    for (std::size_t j = 0; j < fingerprint_length; j++) {
+        low_tables[j] = _mm256_broadcastsi128_si256(_mm_loadu_si128(
+            reinterpret_cast<const __m128i*>(masks.low_nibbles[j].data())));
+        high_tables[j] = _mm256_broadcastsi128_si256(_mm_loadu_si128(
+            reinterpret_cast<const __m128i*>(masks.high_nibbles[j].data())));
+    }
+
+    alignas(kBlockSize) std::array<std::uint8_t, kBlockSize> buckets{};
+    std::size_t position = 0;
+    for (; position + kBlockSize + fingerprint_length - 1 <= text.size();
+         position += kBlockSize) {
+        __m256i candidates = _mm256_set1_epi8(-1);
+        for (std::size_t j = 0; j < fingerprint_length; j++) {
+            const __m256i block = _mm256_loadu_si256(
+                reinterpret_cast<const __m256i*>(text.data() + position + j));
+            const __m256i low  = _mm256_and_si256(block, nibble_mask);
+            const __m256i high = _mm256_and_si256(_mm256_srli_epi16(block, 4),
+                                                  nibble_mask);
+            candidates         = _mm256_and_si256(
+                candidates,
+                _mm256_and_si256(_mm256_shuffle_epi8(low_tables[j], low),
+                                 _mm256_shuffle_epi8(high_tables[j], high)));
+        }
+
+        auto positions_mask = ~static_cast<std::uint32_t>(
+            _mm256_movemask_epi8(_mm256_cmpeq_epi8(candidates, zero)));
+        if (positions_mask == 0) {
+            continue;
+        }
+
+        _mm256_store_si256(reinterpret_cast<__m256i*>(buckets.data()),
+                           candidates);
+        do {
+            const auto k = static_cast<std::size_t>(
+                std::countr_zero(positions_mask));
+            on_candidate(position + k, buckets[k]);
+            positions_mask &= positions_mask - 1;
+        } while (positions_mask != 0);
+    }
+
+    return position;
+}
+
+#endif
+
+}  // namespace
+
+TeddyMatcher& TeddyMatcher::AddPattern(Pattern pattern) {
+    assert(!is_ready_);
+    if (is_ready_) {
+        ResetTeddyMatcher();
+    }
+
+    if (const std::size_t bad_symbol_index =
+            StoredPatterns::FindBadSymbol(pattern);
+        bad_symbol_index != pattern.size()) {
+        bad_input_port_.Notify({bad_symbol_index, pattern[bad_symbol_index]});
+        return *this;
+    }
+
+    patterns_.Add(pattern);
+    return *this;
+}
+
+TeddyMatcher& TeddyMatcher::BuildTeddyMatcher() {
+    assert(!is_ready_);
+    // Sorted patterns with common prefixes get into the same buckets, so
+    //  fingerprints of one bucket are more alike and give less false
+    //  candidates
+    patterns_.DedupeKeepLast();
+
+    masks_ = FingerprintMasks{};
+    for (auto& bucket : buckets_) {
+        bucket.clear();
+    }
+    min_pattern_length_ = 0;
+    if (!patterns_.empty()) {
+        min_pattern_length_ =
+            std::min_element(patterns_.begin(), patterns_.end(),
+                             [](const StoredPattern& lhs,
+                                const StoredPattern& rhs) {
+                                 return lhs.pattern.size() < rhs.pattern.size();
+                             })
+                ->pattern.size();
+    }
+    masks_.fingerprint_length =
+        std::min(min_pattern_length_, kMaxFingerprintLength);
+
+    for (std::size_t i = 0; i < patterns_.size(); i++) {
+        const std::size_t bucket_index = i * kBucketsCount / patterns_.size();
+        buckets_[bucket_index].push_back(i);
+        const auto bucket_bit = static_cast<std::uint8_t>(1u << bucket_index);
+        for (std::size_t j = 0; j < masks_.fingerprint_length; j++) {
+            const auto symbol =
+                static_cast<std::uint8_t>(patterns_[i].pattern[j]);
+            masks_.low_nibbles[j][symbol & kNibbleMask] |= bucket_bit;
+            masks_.high_nibbles[j][symbol >> 4] |= bucket_bit;
+        }
+    }
+
+    is_ready_ = true;
+    return *this;
+}
+
+TeddyMatcher& TeddyMatcher::ResetTeddyMatcher() {
+    is_ready_ = false;
+    patterns_.Clear();
+    for (auto& bucket : buckets_) {
+        bucket.clear();
+    }
+    masks_              = FingerprintMasks{};
+    min_pattern_length_ = 0;
+    return *this;
+}
+
+TeddyMatcher& TeddyMatcher::FindAllSubstringsInText(Text text) {
+    if (!is_ready_) {
+        BuildTeddyMatcher();
+    }
+    if (patterns_.empty()) {
+        return *this;
+    }
+
+    pending_substrings_.Clear();
+    auto on_candidate = [this, text](std::size_t position,
+                                     std::uint32_t buckets_mask) {
+        NotifyAboutPendingSubstrings(position);
+        VerifyCandidates(text, position, buckets_mask);
+    };
+
+    std::size_t position = 0;
+#if ACTRIE_X86_SIMD
+    if (CpuFeatures::HasAvx2()) {
+        position = ScanAvx2(text, masks_, on_candidate);
+    } else if (CpuFeatures::HasSsse3()) {
+        position = ScanSsse3(text, masks_, on_candidate);
+    }
+#endif
+    ScanScalar(text, position, masks_, on_candidate);
+    NotifyAboutPendingSubstrings(text.size());
+    return *this;
+}
+
+TeddyMatcher& TeddyMatcher::AddSubscriber(FoundSubstringObserver* observer) {
+    found_substrings_port_.Subscribe(observer);
+    return *this;
+}
+
+TeddyMatcher& TeddyMatcher::AddSubscriber(BadInputPatternObserver* observer) {
+    bad_input_port_.Subscribe(observer);
+    return *this;
+}
+
+void TeddyMatcher::VerifyCandidates(Text text, std::size_t position,
+                                    std::uint32_t buckets_mask) {
+    assert(buckets_mask != 0);
+    do {
+        const auto bucket_index =
+            static_cast<std::size_t>(std::countr_zero(buckets_mask));
+        buckets_mask &= buckets_mask - 1;
+        for (std::size_t pattern_index : buckets_[bucket_index]) {
+            const StoredPattern& stored_pattern = patterns_[pattern_index];
+            const std::string_view pattern      = stored_pattern.pattern;
+            if (text.size() - position < pattern.size() ||
+                text.compare(position, pattern.size(), pattern) != 0) {
+                continue;
+            }
+
+            pending_substrings_.Push(FoundSubstringInfo{
+                .found_substring       = text.substr(position, pattern.size()),
+                .substring_start_index = position,
+                .current_vertex_index  = ACTrie::kNullNodeIndex,
+                .word_index            = stored_pattern.word_index,
+            });
+        }
+    } while (buckets_mask != 0);
+}
+
+void TeddyMatcher::NotifyAboutPendingSubstrings(std::size_t end_bound) {
+    pending_substrings_.PopEndingBefore(
+        end_bound, [this](const FoundSubstringInfo& info) {
+            found_substrings_port_.Notify(info);
+        });
+}
+
+}  // namespace AppSpace::ACTrieDS
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+#include "ACTrie.hpp"
+#include "Observer.hpp"
+#include "PendingSubstrings.hpp"
+#include "StoredPatterns.hpp"
+
+namespace AppSpace::ACTrieDS {
+
+/// @brief Packed SIMD matcher for small sets of patterns ("Teddy").
+///
+///  Patterns are distributed among 8 buckets. For each of the first
+///   kMaxFingerprintLength symbols of the patterns we keep two 16 byte
+///   tables indexed by the low and high nibble of the symbol. i-th bit of
+///   the table entry is set if some pattern from the i-th bucket has
+///   a symbol with such nibble on this position. Looking up 16 (or 32)
+///   text symbols at once with pshufb gives candidate buckets for each
+///   position, candidates are then verified exactly.
+///
+///  Has the same interface for adding patterns and reporting found substrings
+///   as the ACTrie and reports substrings in the same order (by the end
+///   position, longer first). current_vertex_index of the found substring is
+///   always ACTrie::kNullNodeIndex. Unlike the ACTrie, it never reports the
+///   empty pattern (see StoredPatterns).
+class TeddyMatcher final {
+public:
+    using WordLength                = ACTrie::WordLength;
+    using Pattern                   = ACTrie::Pattern;
+    using Text                      = ACTrie::Text;
+    using FoundSubstringInfo        = ACTrie::FoundSubstringInfo;
+    using BadInputPatternInfo       = ACTrie::BadInputPatternInfo;
+    using FoundSubstringInfoPassBy  = ACTrie::FoundSubstringInfoPassBy;
+    using BadInputPatternInfoPassBy = ACTrie::BadInputPatternInfoPassBy;
+    using FoundSubstringObserver    = ACTrie::FoundSubstringObserver;
+    using BadInputPatternObserver   = ACTrie::BadInputPatternObserver;
+
+    static constexpr std::size_t kBucketsCount         = 8;
+    static constexpr std::size_t kMaxFingerprintLength = 3;
+    static constexpr std::size_t kNibbleTableSize      = 16;
+
+    TeddyMatcher& AddPattern(Pattern pattern);
+    TeddyMatcher& BuildTeddyMatcher();
+    TeddyMatcher& ResetTeddyMatcher();
+    TeddyMatcher& FindAllSubstringsInText(Text text);
+    TeddyMatcher& AddSubscriber(FoundSubstringObserver* observer);
+    TeddyMatcher& AddSubscriber(BadInputPatternObserver* observer);
+    constexpr std::size_t PatternsSize() const noexcept;
+
+    using NibbleTable = std::array<std::uint8_t, kNibbleTableSize>;
+    struct FingerprintMasks final {
+        std::array<NibbleTable, kMaxFingerprintLength> low_nibbles{};
+        std::array<NibbleTable, kMaxFingerprintLength> high_nibbles{};
+        std::size_t fingerprint_length = 0;
+    };
+
+private:
+    void VerifyCandidates(Text text, std::size_t position,
+                          std::uint32_t buckets_mask);
+    void NotifyAboutPendingSubstrings(std::size_t end_bound);
+
+    StoredPatterns patterns_;
+    std::array<std::vector<std::size_t>, kBucketsCount> buckets_;
+    FingerprintMasks masks_;
+    std::size_t min_pattern_length_ = 0;
+    bool is_ready_                  = false;
+    PendingSubstrings pending_substrings_;
+    Observable<FoundSubstringInfo, FoundSubstringInfoPassBy>
+        found_substrings_port_;
+    Observable<BadInputPatternInfo, BadInputPatternInfoPassBy> bad_input_port_;
+};
+
+constexpr std::size_t TeddyMatcher::PatternsSize() const noexcept {
+    return patterns_.AddedSize();
+}
+
+}  // namespace AppSpace::ACTrieDS
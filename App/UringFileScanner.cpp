@@ -0,0 +1,663 @@
+#include "UringFileScanner.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <exception>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include "Workers.hpp"
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cstring>
+#define ACTRIE_URING_FILE_SCANNER 1
+#else
+#define ACTRIE_URING_FILE_SCANNER 0
+#endif
+
+namespace AppSpace::ACTrieDS {
+
+namespace {
+
+constexpr std::size_t AlignDown(std::size_t value,
+                                std::size_t alignment) noexcept {
+    return value / alignment * alignment;
+}
+
+constexpr std::size_t AlignUp(std::size_t value,
+                              std::size_t alignment) noexcept {
+    return AlignDown(value + alignment - 1, alignment);
+}
+
+}  // namespace
+
+UringFileScanner::UringFileScanner(const ACTrie& actrie,
+                                   std::size_t threads_count)
+    : actrie_(actrie),
+      threads_count_(threads_count != 0 ? threads_count
+                                        : Workers::HardwareThreadsCount()) {
+    assert(actrie_.IsReady());
+}
+
+UringFileScanner& UringFileScanner::SetQueueDepth(
+    std::size_t queue_depth) noexcept {
+    queue_depth_ = std::clamp(queue_depth, std::size_t{1}, kMaxQueueDepth);
+    return *this;
+}
+
+UringFileScanner& UringFileScanner::SetBufferSize(
+    std::size_t buffer_size) noexcept {
+    buffer_size_ =
+        AlignUp(std::max(buffer_size, std::size_t{1}), kDirectIOAlignment);
+    return *this;
+}
+
+UringFileScanner& UringFileScanner::SetDirectIO(bool direct_io) noexcept {
+    direct_io_ = direct_io;
+    return *this;
+}
+
+#if ACTRIE_URING_FILE_SCANNER
+
+namespace {
+
+using File               = UringFileScanner::File;
+using FoundSubstringInfo = ACTrie::FoundSubstringInfo;
+
+[[noreturn]] void ThrowSystemError(int error_code, const char* what) {
+    throw std::system_error(error_code, std::system_category(), what);
+}
+
+class FileDescriptor final {
+public:
+    explicit FileDescriptor(int fd) noexcept : fd_(fd) {}
+    FileDescriptor(const FileDescriptor&)            = delete;
+    FileDescriptor& operator=(const FileDescriptor&) = delete;
+    FileDescriptor(FileDescriptor&& other) noexcept
+        : fd_(std::exchange(other.fd_, -1)) {}
+    ~FileDescriptor() {
+        if (fd_ >= 0) {
+            close(fd_);
+        }
+    }
+
+    constexpr int Get() const noexcept {
+        return fd_;
+    }
+
+private:
+    int fd_;
+};
+
+class Mapping final {
+public:
+    Mapping() noexcept = default;
+    Mapping(int fd, std::size_t size, off_t offset) : size_(size) {
+        address_ = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                        MAP_SHARED | MAP_POPULATE, fd, offset);
+        if (address_ == MAP_FAILED) {
+            address_ = nullptr;
+            ThrowSystemError(errno, "io_uring mmap");
+        }
+    }
+    Mapping(const Mapping&)            = delete;
+    Mapping& operator=(const Mapping&) = delete;
+    Mapping& operator=(Mapping&& other) noexcept {
+        std::swap(address_, other.address_);
+        std::swap(size_, other.size_);
+        return *this;
+    }
+    ~Mapping() {
+        if (address_ != nullptr) {
+            munmap(address_, size_);
+        }
+    }
+
+    template <class T>
+    T* At(std::size_t offset) const noexcept {
+        return reinterpret_cast<T*>(static_cast<char*>(address_) + offset);
+    }
+
+private:
+    void* address_    = nullptr;
+    std::size_t size_ = 0;
+};
+
+/// @brief Submission and completion queues of io_uring set up by the raw
+///         system calls and shared with the kernel through mmap().
+class Ring final {
+public:
+    explicit Ring(unsigned entries)
+        : fd_(static_cast<int>(
+              syscall(__NR_io_uring_setup, entries, &params_))) {
+        if (fd_.Get() < 0) {
+            ThrowSystemError(errno, "io_uring_setup");
+        }
+
+        std::size_t sq_ring_size =
+            params_.sq_off.array + params_.sq_entries * sizeof(unsigned);
+        std::size_t cq_ring_size =
+            params_.cq_off.cqes + params_.cq_entries * sizeof(io_uring_cqe);
+        // Since Linux 5.4 both rings are in one mapping
+        const bool is_single_mapping =
+            params_.features & IORING_FEAT_SINGLE_MMAP;
+        if (is_single_mapping) {
+            sq_ring_size = cq_ring_size = std::max(sq_ring_size, cq_ring_size);
+        }
+        sq_ring_ = Mapping(fd_.Get(), sq_ring_size, IORING_OFF_SQ_RING);
+        if (!is_single_mapping) {
+            cq_ring_ = Mapping(fd_.Get(), cq_ring_size, IORING_OFF_CQ_RING);
+        }
+        entries_mapping_ =
+            Mapping(fd_.Get(), params_.sq_entries * sizeof(io_uring_sqe),
+                    IORING_OFF_SQES);
+
+        const Mapping& cq_ring = is_single_mapping ? sq_ring_ : cq_ring_;
+        sq_tail_  = sq_ring_.At<unsigned>(params_.sq_off.tail);
+        sq_mask_  = *sq_ring_.At<unsigned>(params_.sq_off.ring_mask);
+        sq_array_ = sq_ring_.At<unsigned>(params_.sq_off.array);
+        entries_  = entries_mapping_.At<io_uring_sqe>(0);
+        cq_head_  = cq_ring.At<unsigned>(params_.cq_off.head);
+        cq_tail_  = cq_ring.At<unsigned>(params_.cq_off.tail);
+        cq_mask_  = *cq_ring.At<unsigned>(params_.cq_off.ring_mask);
+        cqes_     = cq_ring.At<io_uring_cqe>(params_.cq_off.cqes);
+
+        next_tail_ = *sq_tail_;
+    }
+
+    /// @brief Fixed buffers are pinned once instead of at every read.
+    /// @return false if the kernel refused (e.g. RLIMIT_MEMLOCK is low)
+    bool RegisterBuffers(std::span<const iovec> buffers) noexcept {
+        return syscall(__NR_io_uring_register, fd_.Get(),
+                       IORING_REGISTER_BUFFERS, buffers.data(),
+                       static_cast<unsigned>(buffers.size())) == 0;
+    }
+
+    /// @brief Ring has at least as many entries as the reads in flight,
+    ///         so the free entry is always found.
+    io_uring_sqe& TakeEntry() noexcept {
+        const unsigned index = next_tail_++ & sq_mask_;
+        pending_entries_count_++;
+        sq_array_[index]    = index;
+        io_uring_sqe& entry = entries_[index];
+        std::memset(&entry, 0, sizeof(entry));
+        return entry;
+    }
+
+    /// @brief Submits the taken entries and waits for at least
+    ///         min_completions completions.
+    void SubmitAndWait(unsigned min_completions) {
+        std::atomic_ref(*sq_tail_).store(next_tail_, std::memory_order_release);
+        while (true) {
+            const long submitted_count =
+                syscall(__NR_io_uring_enter, fd_.Get(), pending_entries_count_,
+                        min_completions, IORING_ENTER_GETEVENTS, nullptr, 0);
+            if (submitted_count >= 0) {
+                pending_entries_count_ -=
+                    static_cast<unsigned>(submitted_count);
+                if (pending_entries_count_ == 0) {
+                    return;
+                }
+            } else if (errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+                ThrowSystemError(errno, "io_uring_enter");
+            }
+        }
+    }
+
+    /// @brief Calls on_completion(user_data, result) for each completed
+    ///         read.
+    template <class CompletionHandler>
+    void ForEachCompletion(CompletionHandler on_completion) {
+        const unsigned tail =
+            std::atomic_ref(*cq_tail_).load(std::memory_order_acquire);
+        for (unsigned head = *cq_head_; head != tail; head++) {
+            const io_uring_cqe& completion = cqes_[head & cq_mask_];
+            const std::uint64_t user_data  = completion.user_data;
+            const int result               = completion.res;
+            // Entry is given back before the handler submits the next read
+            std::atomic_ref(*cq_head_).store(head + 1,
+                                             std::memory_order_release);
+            on_completion(user_data, result);
+        }
+    }
+
+private:
+    io_uring_params params_{};
+    FileDescriptor fd_;
+    Mapping sq_ring_;
+    Mapping cq_ring_;
+    Mapping entries_mapping_;
+    unsigned* sq_tail_     = nullptr;
+    unsigned* sq_array_    = nullptr;
+    io_uring_sqe* entries_ = nullptr;
+    unsigned* cq_head_     = nullptr;
+    unsigned* cq_tail_     = nullptr;
+    io_uring_cqe* cqes_    = nullptr;
+    unsigned sq_mask_      = 0;
+    unsigned cq_mask_      = 0;
+    // Taken entries are published to the kernel in SubmitAndWait()
+    unsigned next_tail_             = 0;
+    unsigned pending_entries_count_ = 0;
+};
+
+/// @brief Ring, buffers and open files of one thread.
+class ThreadScanner final {
+public:
+    struct Shared final {
+        const ACTrie& actrie;
+        std::span<const File> files;
+        std::atomic<std::size_t> next_file_index{0};
+        std::atomic<bool> is_stopped{false};
+    };
+
+    ThreadScanner(Shared& shared, std::size_t queue_depth,
+                  std::size_t buffer_size, bool direct_io)
+        : shared_(shared),
+          buffer_size_(buffer_size),
+          buffer_capacity_(
+              buffer_size +
+              AlignUp(shared.actrie.MaxPatternLength(),
+                      UringFileScanner::kDirectIOAlignment)),
+          direct_io_(direct_io),
+          buffers_(static_cast<char*>(::operator new[](
+              queue_depth * buffer_capacity_,
+              std::align_val_t{UringFileScanner::kDirectIOAlignment}))),
+          reads_(queue_depth),
+          iovecs_(queue_depth),
+          ring_(static_cast<unsigned>(queue_depth)) {
+        free_buffers_.reserve(queue_depth);
+        for (std::size_t i = queue_depth; i-- > 0;) {
+            free_buffers_.push_back(i);
+            iovecs_[i] = {
+                .iov_base = BufferAddress(i),
+                .iov_len  = buffer_capacity_,
+            };
+        }
+        held_buffers_.reserve(queue_depth);
+        is_registered_ = ring_.RegisterBuffers(iovecs_);
+    }
+
+    void Run() {
+        try {
+            while (true) {
+                while (!free_buffers_.empty() &&
+                       (SubmitNextChunk() || OpenNextFile())) {
+                }
+                if (reads_in_flight_count_ == 0) {
+                    break;
+                }
+                ring_.SubmitAndWait(1);
+                ring_.ForEachCompletion(
+                    [this](std::uint64_t buffer_index, int result) {
+                        OnReadCompleted(buffer_index, result);
+                    });
+            }
+        } catch (...) {
+            // Buffers must outlive the reads into them
+            WaitForReadsInFlight();
+            throw;
+        }
+    }
+
+private:
+    struct OpenFile final {
+        std::size_t file_index;
+        FileDescriptor fd;
+        std::size_t size;
+        std::size_t chunks_count;
+        bool is_direct;
+        std::size_t next_read_chunk_index    = 0;
+        std::size_t next_scanned_chunk_index = 0;
+        std::size_t reads_in_flight_count    = 0;
+        std::error_code error{};
+    };
+    using OpenFiles = std::list<OpenFile>;
+
+    struct BufferRead final {
+        OpenFiles::iterator file;
+        std::size_t chunk_index;
+        // Offset in the file of the first byte of the buffer
+        std::size_t read_start;
+        std::size_t read_size;
+        std::size_t read_bytes;
+    };
+
+    struct ChunkBounds final {
+        std::size_t scan_start;
+        std::size_t chunk_start;
+        std::size_t chunk_end;
+    };
+
+    struct AlignedDeleter final {
+        void operator()(char* buffers) const noexcept {
+            ::operator delete[](
+                buffers,
+                std::align_val_t{UringFileScanner::kDirectIOAlignment});
+        }
+    };
+
+    char* BufferAddress(std::size_t buffer_index) const noexcept {
+        return buffers_.get() + buffer_index * buffer_capacity_;
+    }
+
+    ChunkBounds GetChunkBounds(const OpenFile& file,
+                               std::size_t chunk_index) const noexcept {
+        const std::size_t chunk_start = chunk_index * buffer_size_;
+        const std::size_t overlap     = std::min(
+            chunk_start,
+            std::max(std::size_t{shared_.actrie.MaxPatternLength()},
+                     std::size_t{1}) -
+                1);
+        return {
+            .scan_start  = chunk_start - overlap,
+            .chunk_start = chunk_start,
+            .chunk_end   = std::min(chunk_start + buffer_size_, file.size),
+        };
+    }
+
+    bool OpenNextFile() {
+        if (shared_.is_stopped.load(std::memory_order_relaxed)) {
+            return false;
+        }
+        const std::size_t file_index =
+            shared_.next_file_index.fetch_add(1, std::memory_order_relaxed);
+        if (file_index >= shared_.files.size()) {
+            return false;
+        }
+
+        const File& file = shared_.files[file_index];
+        bool is_direct   = direct_io_;
+        int fd           = -1;
+        if (is_direct) {
+            fd = open(file.path.c_str(), O_RDONLY | O_CLOEXEC | O_DIRECT);
+            // File system does not support the direct I/O
+            is_direct = fd >= 0 || errno != EINVAL;
+        }
+        if (!is_direct) {
+            fd = open(file.path.c_str(), O_RDONLY | O_CLOEXEC);
+        }
+        FileDescriptor file_descriptor(fd);
+        struct stat file_stat {};
+        if (fd < 0 || fstat(fd, &file_stat) != 0) {
+            file.sink->OnDocumentScanned(
+                std::error_code(errno, std::generic_category()));
+            return true;
+        }
+
+        const auto size = static_cast<std::size_t>(file_stat.st_size);
+        if (size == 0) {
+            file.sink->OnDocumentScanned({});
+            return true;
+        }
+        open_files_.push_back(OpenFile{
+            .file_index   = file_index,
+            .fd           = std::move(file_descriptor),
+            .size         = size,
+            .chunks_count = (size + buffer_size_ - 1) / buffer_size_,
+            .is_direct    = is_direct,
+        });
+        return true;
+    }
+
+    /// @brief Submits the read of the next chunk of the first open file
+    ///         that has not read chunks.
+    bool SubmitNextChunk() {
+        for (auto file = open_files_.begin(); file != open_files_.end();
+             ++file) {
+            if (file->error ||
+                file->next_read_chunk_index == file->chunks_count) {
+                continue;
+            }
+
+            const std::size_t chunk_index = file->next_read_chunk_index++;
+            const ChunkBounds bounds      = GetChunkBounds(*file, chunk_index);
+            std::size_t read_start        = bounds.scan_start;
+            std::size_t read_end          = bounds.chunk_end;
+            if (file->is_direct) {
+                read_start = AlignDown(read_start,
+                                       UringFileScanner::kDirectIOAlignment);
+                read_end =
+                    AlignUp(read_end, UringFileScanner::kDirectIOAlignment);
+            }
+            const std::size_t buffer_index = free_buffers_.back();
+            free_buffers_.pop_back();
+            reads_[buffer_index] = {
+                .file        = file,
+                .chunk_index = chunk_index,
+                .read_start  = read_start,
+                .read_size   = read_end - read_start,
+                .read_bytes  = 0,
+            };
+            SubmitRead(buffer_index);
+            return true;
+        }
+        return false;
+    }
+
+    /// @brief Submits the read of the rest of the buffer.
+    void SubmitRead(std::size_t buffer_index) {
+        BufferRead& read    = reads_[buffer_index];
+        char* address       = BufferAddress(buffer_index) + read.read_bytes;
+        const auto size =
+            static_cast<unsigned>(read.read_size - read.read_bytes);
+        io_uring_sqe& entry = ring_.TakeEntry();
+        entry.fd            = read.file->fd.Get();
+        entry.off           = read.read_start + read.read_bytes;
+        entry.user_data     = buffer_index;
+        if (is_registered_) {
+            entry.opcode    = IORING_OP_READ_FIXED;
+            entry.addr      = reinterpret_cast<std::uintptr_t>(address);
+            entry.len       = size;
+            entry.buf_index = static_cast<std::uint16_t>(buffer_index);
+        } else {
+            iovecs_[buffer_index] = {.iov_base = address, .iov_len = size};
+            entry.opcode          = IORING_OP_READV;
+            entry.addr =
+                reinterpret_cast<std::uintptr_t>(&iovecs_[buffer_index]);
+            entry.len = 1;
+        }
+        read.file->reads_in_flight_count++;
+        reads_in_flight_count_++;
+    }
+
+    void OnReadCompleted(std::size_t buffer_index, int result) {
+        BufferRead& read = reads_[buffer_index];
+        OpenFile& file   = *read.file;
+        file.reads_in_flight_count--;
+        reads_in_flight_count_--;
+
+        if (result == -EAGAIN || result == -EINTR) {
+            SubmitRead(buffer_index);
+            return;
+        }
+        if (result < 0) {
+            if (!file.error) {
+                file.error = std::error_code(-result, std::generic_category());
+            }
+            free_buffers_.push_back(buffer_index);
+        } else {
+            read.read_bytes += static_cast<std::size_t>(result);
+            const bool is_file_end =
+                result == 0 || read.read_start + read.read_bytes >= file.size;
+            if (!is_file_end && read.read_bytes < read.read_size) {
+                // Short read, the rest is read into the same buffer
+                SubmitRead(buffer_index);
+                return;
+            }
+            held_buffers_.push_back(buffer_index);
+        }
+        ScanReadyChunks(read.file);
+    }
+
+    /// @brief Scans the read chunks of the file that follow the scanned
+    ///         ones, and finishes the file after the last one.
+    void ScanReadyChunks(OpenFiles::iterator file) {
+        for (std::size_t i = 0; i < held_buffers_.size();) {
+            const std::size_t buffer_index = held_buffers_[i];
+            const BufferRead& read         = reads_[buffer_index];
+            const bool is_ready =
+                read.file == file &&
+                (file->error ||
+                 read.chunk_index == file->next_scanned_chunk_index);
+            if (!is_ready) {
+                i++;
+                continue;
+            }
+
+            if (!file->error) {
+                ScanChunk(buffer_index);
+                file->next_scanned_chunk_index++;
+            }
+            held_buffers_[i] = held_buffers_.back();
+            held_buffers_.pop_back();
+            free_buffers_.push_back(buffer_index);
+            // Next chunk may be held before this one
+            i = 0;
+        }
+
+        if (file->reads_in_flight_count == 0 &&
+            (file->error ||
+             file->next_scanned_chunk_index == file->chunks_count)) {
+            shared_.files[file->file_index].sink->OnDocumentScanned(
+                file->error);
+            open_files_.erase(file);
+        }
+    }
+
+    void ScanChunk(std::size_t buffer_index) {
+        const BufferRead& read   = reads_[buffer_index];
+        const ChunkBounds bounds = GetChunkBounds(*read.file, read.chunk_index);
+        // File may become shorter after it is opened
+        const std::size_t text_end =
+            std::min(read.read_start + read.read_bytes, bounds.chunk_end);
+        if (text_end <= bounds.scan_start) {
+            return;
+        }
+
+        const ACTrie::Text text(
+            BufferAddress(buffer_index) + (bounds.scan_start - read.read_start),
+            text_end - bounds.scan_start);
+        results_.clear();
+        // Substrings ending in the overlap belong to the previous chunk
+        shared_.actrie.FindAllSubstringsInText(
+            text, [&](FoundSubstringInfo info) {
+                info.substring_start_index += bounds.scan_start;
+                if (info.substring_start_index + info.found_substring.size() >
+                    bounds.chunk_start) {
+                    results_.push_back(info);
+                }
+            });
+        if (!results_.empty()) {
+            shared_.files[read.file->file_index].sink->OnFoundSubstrings(
+                results_);
+        }
+    }
+
+    void WaitForReadsInFlight() noexcept {
+        shared_.is_stopped.store(true, std::memory_order_relaxed);
+        try {
+            while (reads_in_flight_count_ != 0) {
+                ring_.SubmitAndWait(1);
+                ring_.ForEachCompletion([this](std::uint64_t, int) {
+                    reads_in_flight_count_--;
+                });
+            }
+        } catch (const std::system_error&) {
+            // Ring is closed below, the kernel cancels the rest
+        }
+    }
+
+    Shared& shared_;
+    std::size_t buffer_size_;
+    std::size_t buffer_capacity_;
+    bool direct_io_;
+    bool is_registered_ = false;
+    std::unique_ptr<char[], AlignedDeleter> buffers_;
+    std::vector<BufferRead> reads_;
+    std::vector<iovec> iovecs_;
+    std::vector<std::size_t> free_buffers_;
+    // Read chunks that wait for the previous chunks of their files
+    std::vector<std::size_t> held_buffers_;
+    std::size_t reads_in_flight_count_ = 0;
+    OpenFiles open_files_;
+    std::vector<FoundSubstringInfo> results_;
+    // Destroyed first, while the buffers are alive
+    Ring ring_;
+};
+
+}  // namespace
+
+bool UringFileScanner::IsSupported() noexcept {
+    try {
+        Ring ring(1);
+        return true;
+    } catch (const std::system_error&) {
+        return false;
+    }
+}
+
+void UringFileScanner::Scan(std::span<const File> files) {
+    if (files.empty()) {
+        return;
+    }
+
+    // File is read by one thread, more threads would only wait
+    const std::size_t threads_count = std::min(threads_count_, files.size());
+    ThreadScanner::Shared shared{.actrie = actrie_, .files = files};
+    std::vector<std::unique_ptr<ThreadScanner>> thread_scanners;
+    thread_scanners.reserve(threads_count);
+    for (std::size_t i = 0; i < threads_count; i++) {
+        thread_scanners.push_back(std::make_unique<ThreadScanner>(
+            shared, queue_depth_, buffer_size_, direct_io_));
+    }
+
+    std::mutex error_mutex;
+    std::exception_ptr first_error;
+    auto worker = [&](std::size_t thread_index) {
+        try {
+            thread_scanners[thread_index]->Run();
+        } catch (...) {
+            std::lock_guard lock(error_mutex);
+            if (!first_error) {
+                first_error = std::current_exception();
+            }
+        }
+    };
+    Workers::Run(threads_count, worker);
+    if (first_error) {
+        std::rethrow_exception(first_error);
+    }
+}
+
+#else
+
+bool UringFileScanner::IsSupported() noexcept {
+    return false;
+}
+
+void UringFileScanner::Scan(std::span<const File> files) {
+    if (!files.empty()) {
+        throw std::system_error(
+            std::make_error_code(std::errc::function_not_supported),
+            "io_uring");
+    }
+}
+
+#endif
+
+}  // namespace AppSpace::ACTrieDS
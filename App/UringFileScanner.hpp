@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <span>
+
+#include "ACTrie.hpp"
+#include "CorpusScanner.hpp"
+
+namespace AppSpace::ACTrieDS {
+
+/// @brief Scans many files with the reads submitted through Linux io_uring,
+///         so the thread scans the completed buffers while the next reads
+///         are in flight instead of waiting in the blocking read().
+///
+///  Each thread has its own ring and its own buffers registered in the
+///   kernel, and takes the files one by one. It keeps up to queue depth
+///   reads in flight, of one large file or of several small ones: a file
+///   is split into chunks of the buffer size, each read from
+///   MaxPatternLength() - 1 bytes before its start (like the chunks of
+///   CorpusScanner), so the chunks are scanned independently. A completed
+///   chunk is scanned when all previous chunks of its file are given to
+///   the sink, so the sink gets the substrings in order. With the direct
+///   I/O the reads bypass the page cache, and the offsets and the sizes
+///   are aligned to kDirectIOAlignment.
+class UringFileScanner final {
+public:
+    using DocumentSink = CorpusScanner::DocumentSink;
+
+    struct File final {
+        std::filesystem::path path;
+        DocumentSink* sink;
+    };
+
+    static constexpr std::size_t kDefaultQueueDepth = 32;
+    static constexpr std::size_t kMaxQueueDepth     = 1024;
+    static constexpr std::size_t kDefaultBufferSize = std::size_t{1} << 20;
+    static constexpr std::size_t kDirectIOAlignment = 4096;
+
+    /// @brief io_uring can be used: Linux kernel 5.1+ that allows it.
+    static bool IsSupported() noexcept;
+
+    /// @param actrie must be built and must outlive the scanner
+    /// @param threads_count 0 means the number of hardware threads
+    explicit UringFileScanner(const ACTrie& actrie,
+                              std::size_t threads_count = 0);
+    /// @param queue_depth reads in flight of one thread, clamped to
+    ///         [1, kMaxQueueDepth]
+    UringFileScanner& SetQueueDepth(std::size_t queue_depth) noexcept;
+    /// @param buffer_size bytes of the file in one chunk, rounded up to
+    ///         kDirectIOAlignment
+    UringFileScanner& SetBufferSize(std::size_t buffer_size) noexcept;
+    /// @brief Opens the files with O_DIRECT. File system that does not
+    ///         support it is read through the page cache.
+    UringFileScanner& SetDirectIO(bool direct_io) noexcept;
+    /// @brief Scans all files and returns when all their sinks got
+    ///         OnDocumentScanned(). Errors of the files are given to their
+    ///         sinks. Throws std::system_error if the ring can not be
+    ///         created (see IsSupported()). First exception thrown by a
+    ///         sink is rethrown after all threads stop, the files not
+    ///         taken by then are skipped.
+    /// @param files
+    void Scan(std::span<const File> files);
+    constexpr std::size_t ThreadsCount() const noexcept;
+    constexpr std::size_t QueueDepth() const noexcept;
+    constexpr std::size_t BufferSize() const noexcept;
+    constexpr bool DirectIO() const noexcept;
+
+private:
+    const ACTrie& actrie_;
+    std::size_t threads_count_;
+    std::size_t queue_depth_ = kDefaultQueueDepth;
+    std::size_t buffer_size_ = kDefaultBufferSize;
+    bool direct_io_          = false;
+};
+
+constexpr std::size_t UringFileScanner::ThreadsCount() const noexcept {
+    return threads_count_;
+}
+
+constexpr std::size_t UringFileScanner::QueueDepth() const noexcept {
+    return queue_depth_;
+}
+
+constexpr std::size_t UringFileScanner::BufferSize() const noexcept {
+    return buffer_size_;
+}
+
+constexpr bool UringFileScanner::DirectIO() const noexcept {
+    return direct_io_;
+}
+
+}  // namespace AppSpace::ACTrieDS
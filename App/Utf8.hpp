@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace AppSpace::ACTrieDS::Utf8 {
+
+inline constexpr char32_t kMaxCodePoint        = 0x10FFFF;
+inline constexpr std::size_t kMaxEncodedLength = 4;
+
+struct DecodedCodePoint final {
+    char32_t code_point;
+    // Length of the encoding in bytes, 0 if the encoding is invalid
+    std::size_t length;
+};
+
+/// @brief Returns true if the byte continues the encoding of the code point,
+///         so no code point starts at it.
+constexpr bool IsContinuationByte(char byte) noexcept {
+    return (static_cast<unsigned char>(byte) & 0xC0) == 0x80;
+}
+
+/// @brief Decodes the code point starting at the text[position]. Truncated,
+///         overlong encodings, surrogates and the code points after the
+///         kMaxCodePoint are invalid.
+DecodedCodePoint DecodeCodePoint(std::string_view text,
+                                 std::size_t position) noexcept;
+
+void AppendCodePoint(std::string& text, char32_t code_point);
+
+/// @brief Unicode simple case folding (statuses C and S of the
+///         CaseFolding.txt): maps the code point to the one code point all
+///         its case variants are mapped to, or to itself.
+char32_t SimpleCaseFold(char32_t code_point) noexcept;
+
+/// @brief Appends the code points other than the folded whose simple case
+///         folding is the folded.
+void AppendCaseFoldingOrigins(char32_t folded,
+                              std::vector<char32_t>& origins);
+
+}  // namespace AppSpace::ACTrieDS::Utf8
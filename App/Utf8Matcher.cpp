@@ -0,0 +1,256 @@
+#include "Utf8Matcher.hpp"
+
+#include <cassert>
+#include <string>
+#include <unordered_map>
+
+#include "Utf8.hpp"
+
+namespace AppSpace::ACTrieDS {
+
+Utf8Matcher::Utf8Matcher(bool fold_case) noexcept : fold_case_(fold_case) {}
+
+Utf8Matcher& Utf8Matcher::AddPattern(Pattern pattern) {
+    assert(!is_ready_);
+    if (is_ready_) {
+        ResetUtf8Matcher();
+    }
+
+    for (std::size_t i = 0; i < pattern.size();) {
+        const std::size_t length = Utf8::DecodeCodePoint(pattern, i).length;
+        if (length == 0) {
+            bad_input_port_.Notify({i, pattern[i]});
+            return *this;
+        }
+        i += length;
+    }
+
+    patterns_.Add(pattern);
+    return *this;
+}
+
+Utf8Matcher& Utf8Matcher::BuildUtf8Matcher() {
+    assert(!is_ready_);
+    // Code points of the i-th pattern after the folding are
+    //  code_points[code_points_offsets[i]:code_points_offsets[i + 1]]
+    std::vector<char32_t> code_points;
+    std::vector<std::size_t> code_points_offsets(1, 0);
+    // Encodings of the code points matched by the folded code point, the
+    //  first one is the encoding of the folded code point itself
+    std::unordered_map<char32_t, std::vector<std::string>> encodings;
+    std::array<bool, kBytesCount> is_used_byte{};
+    std::vector<char32_t> origins;
+    for (const StoredPattern& stored_pattern : patterns_) {
+        const std::string& pattern = stored_pattern.pattern;
+        for (std::size_t i = 0; i < pattern.size();) {
+            const auto [code_point, length] = Utf8::DecodeCodePoint(pattern, i);
+            i += length;
+            const char32_t folded =
+                fold_case_ ? Utf8::SimpleCaseFold(code_point) : code_point;
+            code_points.push_back(folded);
+            auto [iter, inserted] = encodings.try_emplace(folded);
+            if (!inserted) {
+                continue;
+            }
+
+            std::vector<std::string>& folded_encodings = iter->second;
+            Utf8::AppendCodePoint(folded_encodings.emplace_back(), folded);
+            if (fold_case_) {
+                origins.clear();
+                Utf8::AppendCaseFoldingOrigins(folded, origins);
+                for (char32_t origin : origins) {
+                    // ASCII origins share the column of the folded symbol
+                    if (origin >= 0x80) {
+                        Utf8::AppendCodePoint(folded_encodings.emplace_back(),
+                                              origin);
+                    }
+                }
+            }
+            for (const std::string& encoding : folded_encodings) {
+                for (char byte : encoding) {
+                    is_used_byte[static_cast<std::uint8_t>(byte)] = true;
+                }
+            }
+        }
+        code_points_offsets.push_back(code_points.size());
+    }
+
+    symbols_classes_.fill(kUnusedClass);
+    symbols_classes_size_ = 1;
+    for (std::size_t byte = 0; byte < kBytesCount; byte++) {
+        if (is_used_byte[byte]) {
+            symbols_classes_[byte] =
+                static_cast<SymbolClass>(symbols_classes_size_++);
+        }
+    }
+    if (fold_case_) {
+        for (char32_t symbol = 0; symbol < 0x80; symbol++) {
+            symbols_classes_[symbol] =
+                symbols_classes_[Utf8::SimpleCaseFold(symbol)];
+        }
+    }
+
+    transitions_.clear();
+    nodes_.clear();
+    AddNode();
+    for (std::size_t p = 0; p < patterns_.size(); p++) {
+        NodeIndex node_index = kRootIndex;
+        for (std::size_t i = code_points_offsets[p];
+             i < code_points_offsets[p + 1]; i++) {
+            const std::vector<std::string>& code_point_encodings =
+                encodings.find(code_points[i])->second;
+            NodeIndex next_node_index = node_index;
+            for (char byte : code_point_encodings.front()) {
+                next_node_index = FindOrAddChild(next_node_index, byte);
+            }
+            // Other case variants end in the same node, UTF-8 is a prefix
+            //  code, so their bytes never lead to the other code points
+            for (std::size_t v = 1; v < code_point_encodings.size(); v++) {
+                const std::string& encoding = code_point_encodings[v];
+                NodeIndex variant_node_index = node_index;
+                for (std::size_t j = 0; j + 1 < encoding.size(); j++) {
+                    variant_node_index =
+                        FindOrAddChild(variant_node_index, encoding[j]);
+                }
+                NodeIndex& last_transition =
+                    Transition(variant_node_index, encoding.back());
+                assert(last_transition == kNoNode ||
+                       last_transition == next_node_index);
+                last_transition = next_node_index;
+            }
+            node_index = next_node_index;
+            nodes_[node_index].code_points_count =
+                static_cast<WordLength>(i - code_points_offsets[p] + 1);
+        }
+        // Patterns are in the order of the addition, so the pattern added
+        //  last among the ones ending in the node (repeated or equal after
+        //  the folding) sets the word index
+        nodes_[node_index].word_index = patterns_[p].word_index;
+    }
+    ComputeSuffixLinks();
+    is_ready_ = true;
+    return *this;
+}
+
+Utf8Matcher& Utf8Matcher::ResetUtf8Matcher() {
+    is_ready_ = false;
+    patterns_.Clear();
+    symbols_classes_.fill(kUnusedClass);
+    symbols_classes_size_ = 1;
+    transitions_.clear();
+    nodes_.clear();
+    return *this;
+}
+
+Utf8Matcher& Utf8Matcher::FindAllSubstringsInText(Text text) {
+    if (!is_ready_) {
+        BuildUtf8Matcher();
+    }
+
+    const std::size_t classes_size = symbols_classes_size_;
+    NodeIndex node_index           = kRootIndex;
+    for (std::size_t i = 0; i < text.size(); i++) {
+        const SymbolClass symbol_class =
+            symbols_classes_[static_cast<std::uint8_t>(text[i])];
+        node_index =
+            transitions_[std::size_t{node_index} * classes_size + symbol_class];
+        if (nodes_[node_index].output_link != kRootIndex) {
+            NotifyAboutFoundSubstrings(text, i + 1, node_index);
+        }
+    }
+    return *this;
+}
+
+Utf8Matcher& Utf8Matcher::AddSubscriber(FoundSubstringObserver* observer) {
+    found_substrings_port_.Subscribe(observer);
+    return *this;
+}
+
+Utf8Matcher& Utf8Matcher::AddSubscriber(BadInputPatternObserver* observer) {
+    bad_input_port_.Subscribe(observer);
+    return *this;
+}
+
+Utf8Matcher::NodeIndex Utf8Matcher::AddNode() {
+    const auto node_index = static_cast<NodeIndex>(nodes_.size());
+    nodes_.emplace_back();
+    transitions_.resize(transitions_.size() + symbols_classes_size_, kNoNode);
+    return node_index;
+}
+
+Utf8Matcher::NodeIndex& Utf8Matcher::Transition(NodeIndex node_index,
+                                                char byte) {
+    return transitions_[std::size_t{node_index} * symbols_classes_size_ +
+                        symbols_classes_[static_cast<std::uint8_t>(byte)]];
+}
+
+Utf8Matcher::NodeIndex Utf8Matcher::FindOrAddChild(NodeIndex node_index,
+                                                   char byte) {
+    if (Transition(node_index, byte) == kNoNode) {
+        // AddNode() invalidates the references into the transitions_
+        const NodeIndex child_index  = AddNode();
+        Transition(node_index, byte) = child_index;
+    }
+    return Transition(node_index, byte);
+}
+
+void Utf8Matcher::ComputeSuffixLinks() {
+    // The automaton is not a tree: case variants of the code point lead to
+    //  the same node. Strings leading to the node are equal after the
+    //  folding, so do their suffixes, and the suffix link computed from
+    //  any parent is the same.
+    nodes_[kRootIndex].suffix_link = kRootIndex;
+    std::vector<NodeIndex> queue(1, kRootIndex);
+    for (std::size_t q = 0; q < queue.size(); q++) {
+        const NodeIndex node_index   = queue[q];
+        const NodeIndex suffix_index = nodes_[node_index].suffix_link;
+        for (std::size_t c = 0; c < symbols_classes_size_; c++) {
+            NodeIndex& next_index =
+                transitions_[std::size_t{node_index} * symbols_classes_size_ +
+                             c];
+            const NodeIndex suffix_next_index =
+                node_index == kRootIndex
+                    ? kRootIndex
+                    : transitions_[std::size_t{suffix_index} *
+                                       symbols_classes_size_ +
+                                   c];
+            if (next_index == kNoNode) {
+                next_index = suffix_next_index;
+                continue;
+            }
+            Node& next_node = nodes_[next_index];
+            if (next_node.suffix_link != kNoNode) {
+                continue;
+            }
+
+            next_node.suffix_link = suffix_next_index;
+            next_node.output_link = next_node.word_index != kNoWord
+                                        ? next_index
+                                        : nodes_[suffix_next_index].output_link;
+            queue.push_back(next_index);
+        }
+    }
+}
+
+void Utf8Matcher::NotifyAboutFoundSubstrings(Text text, std::size_t end,
+                                             NodeIndex node_index) {
+    for (NodeIndex output_index = nodes_[node_index].output_link;
+         output_index != kRootIndex;
+         output_index = nodes_[nodes_[output_index].suffix_link].output_link) {
+        const Node& output = nodes_[output_index];
+        std::size_t start  = end;
+        for (WordLength i = 0; i < output.code_points_count; i++) {
+            do {
+                start--;
+            } while (Utf8::IsContinuationByte(text[start]));
+        }
+        found_substrings_port_.Notify(FoundSubstringInfo{
+            .found_substring       = text.substr(start, end - start),
+            .substring_start_index = start,
+            .current_vertex_index  = ACTrie::kNullNodeIndex,
+            .word_index            = output.word_index,
+        });
+    }
+}
+
+}  // namespace AppSpace::ACTrieDS
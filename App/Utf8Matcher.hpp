@@ -0,0 +1,141 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "ACTrie.hpp"
+#include "Observer.hpp"
+#include "StoredPatterns.hpp"
+
+namespace AppSpace::ACTrieDS {
+
+/// @brief Matcher of the UTF-8 patterns in the UTF-8 text, for the texts
+///         outside the alphabet of the ACTrie (the ACTrie resets the walk on
+///         each such byte).
+///
+///  Patterns are stored as the byte sequences in the Aho-Corasick automaton
+///   with the dense transitions table, like the ACTrie. The table has a
+///   column per byte used in the patterns (and one column for all unused
+///   bytes) instead of per byte value, so multilingual patterns do not make
+///   the table 256 columns wide. The text is scanned in one pass, one table
+///   lookup per byte regardless of the script.
+///
+///  Patterns must be valid UTF-8. A pattern starts with the first byte of a
+///   code point, which never occurs inside a code point, and ends with the
+///   last byte of one, so found substrings always start and end on the code
+///   point boundaries of the text.
+///
+///  With the case folding the Unicode simple case folding is applied to the
+///   patterns at the build: each code point of the pattern is matched by
+///   every code point with the same folding. Such code points are added to
+///   the automaton as the alternative byte sequences leading to the same
+///   node (ASCII letters share the column instead), so the text is not
+///   folded during the scan. Patterns equal after the folding are repeated
+///   patterns.
+///
+///  Has the same interface for adding patterns and reporting found substrings
+///   as the ACTrie and reports substrings in the same order (by the end
+///   position, longer first). Repeated pattern is reported once with the
+///   index of the last addition. Empty pattern takes its index but is not
+///   added to the automaton, so unlike the ACTrie it is never reported.
+///   current_vertex_index of the found substring is always
+///   ACTrie::kNullNodeIndex.
+class Utf8Matcher final {
+public:
+    using WordLength                = ACTrie::WordLength;
+    using Pattern                   = ACTrie::Pattern;
+    using Text                      = ACTrie::Text;
+    using FoundSubstringInfo        = ACTrie::FoundSubstringInfo;
+    using BadInputPatternInfo       = ACTrie::BadInputPatternInfo;
+    using FoundSubstringInfoPassBy  = ACTrie::FoundSubstringInfoPassBy;
+    using BadInputPatternInfoPassBy = ACTrie::BadInputPatternInfoPassBy;
+    using FoundSubstringObserver    = ACTrie::FoundSubstringObserver;
+    using BadInputPatternObserver   = ACTrie::BadInputPatternObserver;
+
+    explicit Utf8Matcher(bool fold_case = false) noexcept;
+
+    /// @brief Adds pattern to the set. Pattern which is not valid UTF-8 is
+    ///         reported as bad input at the first byte of the invalid code
+    ///         point.
+    /// @param pattern
+    Utf8Matcher& AddPattern(Pattern pattern);
+    Utf8Matcher& BuildUtf8Matcher();
+    Utf8Matcher& ResetUtf8Matcher();
+    Utf8Matcher& FindAllSubstringsInText(Text text);
+    Utf8Matcher& AddSubscriber(FoundSubstringObserver* observer);
+    Utf8Matcher& AddSubscriber(BadInputPatternObserver* observer);
+    constexpr bool IsCaseFolding() const noexcept;
+    constexpr std::size_t PatternsSize() const noexcept;
+    /// @brief Number of the nodes of the automaton, valid after the build.
+    constexpr std::size_t NodesSize() const noexcept;
+    /// @brief Number of the columns of the transitions table, valid after
+    ///         the build.
+    constexpr std::size_t SymbolsClassesSize() const noexcept;
+
+private:
+    // Valid UTF-8 uses at most 243 byte values, so the classes of the used
+    //  bytes and the class of the unused ones fit into the SymbolClass
+    using NodeIndex   = std::uint32_t;
+    using SymbolClass = std::uint8_t;
+
+    static constexpr std::size_t kBytesCount =
+        std::numeric_limits<std::uint8_t>::max() + 1;
+    static constexpr NodeIndex kRootIndex     = 0;
+    static constexpr SymbolClass kUnusedClass = 0;
+    static constexpr NodeIndex kNoNode =
+        std::numeric_limits<NodeIndex>::max();
+    static constexpr WordLength kNoWord =
+        std::numeric_limits<WordLength>::max();
+
+    struct Node final {
+        NodeIndex suffix_link        = kNoNode;
+        // The node itself if it ends a pattern, otherwise the nearest node
+        //  by the suffix links which does, kRootIndex if there are none
+        NodeIndex output_link        = kRootIndex;
+        WordLength word_index        = kNoWord;
+        // Length of the pattern ending at the node, in the code points (the
+        //  length in bytes depends on the matched case variants)
+        WordLength code_points_count = 0;
+    };
+
+    NodeIndex AddNode();
+    NodeIndex& Transition(NodeIndex node_index, char byte);
+    NodeIndex FindOrAddChild(NodeIndex node_index, char byte);
+    void ComputeSuffixLinks();
+    void NotifyAboutFoundSubstrings(Text text, std::size_t end,
+                                    NodeIndex node_index);
+
+    bool fold_case_;
+    StoredPatterns patterns_;
+    std::array<SymbolClass, kBytesCount> symbols_classes_{};
+    std::size_t symbols_classes_size_ = 1;
+    // Next node of the node v by the class c is
+    //  transitions_[v * symbols_classes_size_ + c]
+    std::vector<NodeIndex> transitions_;
+    std::vector<Node> nodes_;
+    bool is_ready_ = false;
+    Observable<FoundSubstringInfo, FoundSubstringInfoPassBy>
+        found_substrings_port_;
+    Observable<BadInputPatternInfo, BadInputPatternInfoPassBy> bad_input_port_;
+};
+
+constexpr bool Utf8Matcher::IsCaseFolding() const noexcept {
+    return fold_case_;
+}
+
+constexpr std::size_t Utf8Matcher::PatternsSize() const noexcept {
+    return patterns_.AddedSize();
+}
+
+constexpr std::size_t Utf8Matcher::NodesSize() const noexcept {
+    return nodes_.size();
+}
+
+constexpr std::size_t Utf8Matcher::SymbolsClassesSize() const noexcept {
+    return symbols_classes_size_;
+}
+
+}  // namespace AppSpace::ACTrieDS
@@ -0,0 +1,43 @@
+#include "VersionedACTrie.hpp"
+
+#include <cassert>
+#include <utility>
+
+namespace AppSpace::ACTrieDS {
+
+VersionedACTrie::VersionedACTrie(Version initial_version) noexcept {
+    Publish(std::move(initial_version));
+}
+
+VersionedACTrie::Version VersionedACTrie::Acquire() const noexcept {
+#if defined(__cpp_lib_atomic_shared_ptr)
+    return current_version_.load(std::memory_order_acquire);
+#else
+    std::lock_guard lock(current_version_mutex_);
+    return current_version_;
+#endif
+}
+
+std::uint64_t VersionedACTrie::Publish(Version version) noexcept {
+    assert(version == nullptr || version->IsReady());
+    // Previous version is released outside of the critical section, so
+    //  its destruction (if there are no readers) does not block Acquire().
+#if defined(__cpp_lib_atomic_shared_ptr)
+    Version previous_version = current_version_.exchange(
+        std::move(version), std::memory_order_acq_rel);
+#else
+    Version previous_version;
+    {
+        std::lock_guard lock(current_version_mutex_);
+        previous_version = std::exchange(current_version_, std::move(version));
+    }
+#endif
+    return published_versions_count_.fetch_add(1, std::memory_order_relaxed) +
+           1;
+}
+
+std::uint64_t VersionedACTrie::PublishedVersionsCount() const noexcept {
+    return published_versions_count_.load(std::memory_order_relaxed);
+}
+
+}  // namespace AppSpace::ACTrieDS
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+
+#include "ACTrie.hpp"
+
+namespace AppSpace::ACTrieDS {
+
+/// @brief Handle of the current version of the ACTrie which is replaced
+///         by the writer while the readers keep scanning.
+///
+///  Reader takes the current version by Acquire() and scans the text with
+///   the const ACTrie::FindAllSubstringsInText(text, on_found_substring).
+///   Writer builds a new ACTrie aside and publishes it by Publish(), which
+///   neither waits for the readers nor makes them wait for the scan.
+///   Readers that took the old version finish their scans with it, and the
+///   old version is destroyed when the last of them releases it.
+class VersionedACTrie final {
+public:
+    using Version = std::shared_ptr<const ACTrie>;
+
+    VersionedACTrie() = default;
+    explicit VersionedACTrie(Version initial_version) noexcept;
+    VersionedACTrie(const VersionedACTrie&)            = delete;
+    VersionedACTrie& operator=(const VersionedACTrie&) = delete;
+    VersionedACTrie(VersionedACTrie&&)                 = delete;
+    VersionedACTrie& operator=(VersionedACTrie&&)      = delete;
+
+    /// @brief Returns the current version (nullptr if nothing was
+    ///         published yet). It stays alive while the result is held.
+    Version Acquire() const noexcept;
+    /// @brief Replaces the current version. Built ACTrie is expected.
+    /// @param version
+    /// @return Number of the published version (counted from 1).
+    std::uint64_t Publish(Version version) noexcept;
+    std::uint64_t PublishedVersionsCount() const noexcept;
+
+private:
+#if defined(__cpp_lib_atomic_shared_ptr)
+    std::atomic<Version> current_version_;
+#else
+    // Lock is held only for the copy of the pointer, never for a scan
+    mutable std::mutex current_version_mutex_;
+    Version current_version_;
+#endif
+    std::atomic<std::uint64_t> published_versions_count_{0};
+};
+
+}  // namespace AppSpace::ACTrieDS
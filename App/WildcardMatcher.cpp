@@ -0,0 +1,181 @@
+#include "WildcardMatcher.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <string_view>
+
+namespace AppSpace::ACTrieDS {
+
+WildcardMatcher& WildcardMatcher::AddPattern(Pattern pattern) {
+    assert(!is_ready_);
+    if (is_ready_) {
+        ResetWildcardMatcher();
+    }
+
+    if (const std::size_t bad_symbol_index = StoredPatterns::FindBadSymbol(
+            pattern, std::string_view(&kAnySymbol, 1));
+        bad_symbol_index != pattern.size()) {
+        bad_input_port_.Notify({bad_symbol_index, pattern[bad_symbol_index]});
+        return *this;
+    }
+    // Such pattern would be found at each position of the text
+    if (!pattern.empty() &&
+        pattern.find_first_not_of(kAnySymbol) == std::string_view::npos) {
+        bad_input_port_.Notify({pattern.size() - 1, kAnySymbol});
+        return *this;
+    }
+
+    patterns_.Add(pattern);
+    return *this;
+}
+
+WildcardMatcher& WildcardMatcher::BuildWildcardMatcher() {
+    assert(!is_ready_);
+    patterns_.DedupeKeepLast();
+
+    fragments_index_.Reset();
+    std::size_t counters_size = 0;
+    std::vector<std::string_view> pattern_fragments;
+    for (std::size_t i = 0; i < patterns_.size(); i++) {
+        StoredPattern& stored_pattern  = patterns_[i];
+        const std::string_view pattern = stored_pattern.pattern;
+        pattern_fragments.clear();
+        std::size_t max_fragment_length = 0;
+        for (std::size_t start = 0; start < pattern.size();) {
+            if (pattern[start] == kAnySymbol) {
+                start++;
+                continue;
+            }
+
+            const std::size_t end =
+                std::min(pattern.find(kAnySymbol, start), pattern.size());
+            pattern_fragments.push_back(pattern.substr(start, end - start));
+            max_fragment_length = std::max(max_fragment_length, end - start);
+            start               = end;
+        }
+
+        const std::size_t min_voting_length =
+            std::min(max_fragment_length, kMinCountedFragmentLength);
+        stored_pattern.fragments_count        = 0;
+        stored_pattern.has_unverified_symbols = false;
+        stored_pattern.counters_offset        = counters_size;
+        counters_size += pattern.size();
+        for (std::string_view fragment : pattern_fragments) {
+            if (fragment.size() < min_voting_length) {
+                stored_pattern.has_unverified_symbols = true;
+                continue;
+            }
+
+            const auto fragment_end = static_cast<WordLength>(
+                std::size_t(fragment.data() - pattern.data()) + fragment.size());
+            fragments_index_.AddUse(
+                fragment,
+                FragmentUse{
+                    .pattern_index       = static_cast<std::uint32_t>(i),
+                    .fragment_end_offset = fragment_end,
+                });
+            stored_pattern.fragments_count++;
+        }
+    }
+    fragments_index_.Build();
+    counters_.resize(counters_size);
+    is_ready_ = true;
+    return *this;
+}
+
+WildcardMatcher& WildcardMatcher::ResetWildcardMatcher() {
+    is_ready_ = false;
+    patterns_.Clear();
+    fragments_index_.Reset();
+    counters_.clear();
+    return *this;
+}
+
+WildcardMatcher& WildcardMatcher::FindAllSubstringsInText(Text text) {
+    if (!is_ready_) {
+        BuildWildcardMatcher();
+    }
+    if (patterns_.empty()) {
+        return *this;
+    }
+
+    pending_substrings_.Clear();
+    std::ranges::fill(counters_, StartCounter{});
+    fragments_index_.FindAllFragmentsInText(
+        text, [this, text](const FoundSubstringInfo& fragment_info) {
+            const std::size_t fragment_end =
+                fragment_info.substring_start_index +
+                fragment_info.found_substring.size();
+            // Fragments are found by the end position, so the substrings
+            //  found later end at or after the fragment_end
+            NotifyAboutPendingSubstrings(fragment_end - 1);
+            CountFoundFragment(text, fragment_end, fragment_info.word_index);
+        });
+    NotifyAboutPendingSubstrings(text.size());
+    return *this;
+}
+
+WildcardMatcher& WildcardMatcher::AddSubscriber(
+    FoundSubstringObserver* observer) {
+    found_substrings_port_.Subscribe(observer);
+    return *this;
+}
+
+WildcardMatcher& WildcardMatcher::AddSubscriber(
+    BadInputPatternObserver* observer) {
+    bad_input_port_.Subscribe(observer);
+    return *this;
+}
+
+bool WildcardMatcher::MatchesAt(std::string_view pattern, Text text,
+                                std::size_t start) noexcept {
+    for (std::size_t i = 0; i < pattern.size(); i++) {
+        if (pattern[i] != kAnySymbol && pattern[i] != text[start + i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void WildcardMatcher::CountFoundFragment(Text text, std::size_t fragment_end,
+                                         WordLength fragment_index) {
+    for (const FragmentUse& use : fragments_index_.Uses(fragment_index)) {
+        if (fragment_end < use.fragment_end_offset) {
+            continue;
+        }
+        const StoredPattern& stored_pattern = patterns_[use.pattern_index];
+        const std::size_t pattern_length    = stored_pattern.pattern.size();
+        const std::size_t start = fragment_end - use.fragment_end_offset;
+        if (text.size() - start < pattern_length) {
+            continue;
+        }
+
+        // Votes for the start are given by the fragments ending in
+        //  (start, start + pattern_length], before the first vote for the
+        //  next start sharing the counter
+        StartCounter& counter =
+            counters_[stored_pattern.counters_offset + start % pattern_length];
+        if (counter.start != start) {
+            counter = StartCounter{.start = start, .found_fragments_count = 0};
+        }
+        if (++counter.found_fragments_count == stored_pattern.fragments_count &&
+            (!stored_pattern.has_unverified_symbols ||
+             MatchesAt(stored_pattern.pattern, text, start))) {
+            pending_substrings_.Push(FoundSubstringInfo{
+                .found_substring       = text.substr(start, pattern_length),
+                .substring_start_index = start,
+                .current_vertex_index  = ACTrie::kNullNodeIndex,
+                .word_index            = stored_pattern.word_index,
+            });
+        }
+    }
+}
+
+void WildcardMatcher::NotifyAboutPendingSubstrings(std::size_t end_bound) {
+    pending_substrings_.PopEndingBefore(
+        end_bound, [this](const FoundSubstringInfo& info) {
+            found_substrings_port_.Notify(info);
+        });
+}
+
+}  // namespace AppSpace::ACTrieDS
@@ -0,0 +1,123 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "ACTrie.hpp"
+#include "FragmentsIndex.hpp"
+#include "Observer.hpp"
+#include "PendingSubstrings.hpp"
+#include "StoredPatterns.hpp"
+
+namespace AppSpace::ACTrieDS {
+
+/// @brief Matcher of the patterns with the don't care positions: kAnySymbol
+///         in the pattern matches any single byte of the text.
+///
+///  Patterns are not expanded into the concrete variants (their number grows
+///   exponentially with the number of the wildcards). Each pattern is split
+///   into the fixed fragments between the wildcards, all fragments are found
+///   by one ACTrie. Fragment found at the text position votes for the start
+///   of each pattern containing it (start = fragment end - fragment end
+///   offset in the pattern). Votes are counted in the circular array of the
+///   pattern length per pattern: when all fragments of the pattern voted for
+///   the start, the pattern is found there.
+///
+///  Short fragments are found at almost every position of the text, so only
+///   the fragments of at least kMinCountedFragmentLength symbols (or the
+///   longest fragments of the pattern if it has no such fragments) vote. The
+///   rest of the pattern is compared with the text when all votes for the
+///   start are counted.
+///
+///  Has the same interface for adding patterns and reporting found substrings
+///   as the ACTrie and reports substrings in the same order (by the end
+///   position, longer first). current_vertex_index of the found substring is
+///   always ACTrie::kNullNodeIndex. Unlike the ACTrie, it never reports the
+///   empty pattern (see StoredPatterns).
+class WildcardMatcher final {
+public:
+    using WordLength                = ACTrie::WordLength;
+    using Pattern                   = ACTrie::Pattern;
+    using Text                      = ACTrie::Text;
+    using FoundSubstringInfo        = ACTrie::FoundSubstringInfo;
+    using BadInputPatternInfo       = ACTrie::BadInputPatternInfo;
+    using FoundSubstringInfoPassBy  = ACTrie::FoundSubstringInfoPassBy;
+    using BadInputPatternInfoPassBy = ACTrie::BadInputPatternInfoPassBy;
+    using FoundSubstringObserver    = ACTrie::FoundSubstringObserver;
+    using BadInputPatternObserver   = ACTrie::BadInputPatternObserver;
+
+    static constexpr char kAnySymbol                       = '?';
+    static constexpr std::size_t kMinCountedFragmentLength = 3;
+    static_assert(ACTrie::SymbolToIndex(kAnySymbol) >= ACTrie::kAlphabetLength,
+                  "Wildcard must not be a symbol of the patterns");
+
+    /// @brief Adds pattern to the set. Symbols other than kAnySymbol must be
+    ///         in the alphabet of the ACTrie. Non empty pattern made only of
+    ///         the wildcards is reported as bad input at its last symbol.
+    /// @param pattern
+    WildcardMatcher& AddPattern(Pattern pattern);
+    WildcardMatcher& BuildWildcardMatcher();
+    WildcardMatcher& ResetWildcardMatcher();
+    WildcardMatcher& FindAllSubstringsInText(Text text);
+    WildcardMatcher& AddSubscriber(FoundSubstringObserver* observer);
+    WildcardMatcher& AddSubscriber(BadInputPatternObserver* observer);
+    constexpr std::size_t PatternsSize() const noexcept;
+    /// @brief Number of the distinct voting fragments, valid after the build.
+    constexpr std::size_t FragmentsSize() const noexcept;
+
+private:
+    static constexpr std::size_t kNoStart =
+        std::numeric_limits<std::size_t>::max();
+
+    struct StoredPattern final {
+        std::string pattern;
+        WordLength word_index;
+        // Number of the voting fragments
+        WordLength fragments_count = 0;
+        // Pattern has symbols not covered by the voting fragments
+        bool has_unverified_symbols = false;
+        // Offset of the pattern counters in the counters_
+        std::size_t counters_offset = 0;
+    };
+    struct FragmentUse final {
+        std::uint32_t pattern_index;
+        // Offset of the symbol after the fragment in the pattern
+        WordLength fragment_end_offset;
+    };
+    struct StartCounter final {
+        std::size_t start                = kNoStart;
+        WordLength found_fragments_count = 0;
+    };
+
+    static bool MatchesAt(std::string_view pattern, Text text,
+                          std::size_t start) noexcept;
+    void CountFoundFragment(Text text, std::size_t fragment_end,
+                            WordLength fragment_index);
+    void NotifyAboutPendingSubstrings(std::size_t end_bound);
+
+    BasicStoredPatterns<StoredPattern> patterns_;
+    FragmentsIndex<FragmentUse> fragments_index_;
+    // Votes for the start s of the i-th pattern are in the
+    //  counters_[counters_offset + s % pattern length], valid if the start
+    //  of the counter is s
+    std::vector<StartCounter> counters_;
+    bool is_ready_ = false;
+    PendingSubstrings pending_substrings_;
+    Observable<FoundSubstringInfo, FoundSubstringInfoPassBy>
+        found_substrings_port_;
+    Observable<BadInputPatternInfo, BadInputPatternInfoPassBy> bad_input_port_;
+};
+
+constexpr std::size_t WildcardMatcher::PatternsSize() const noexcept {
+    return patterns_.AddedSize();
+}
+
+constexpr std::size_t WildcardMatcher::FragmentsSize() const noexcept {
+    return fragments_index_.FragmentsSize();
+}
+
+}  // namespace AppSpace::ACTrieDS
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <thread>
+#include <vector>
+
+namespace AppSpace::ACTrieDS::Workers {
+
+inline std::size_t HardwareThreadsCount() noexcept {
+    return std::max(std::size_t{std::thread::hardware_concurrency()},
+                    std::size_t{1});
+}
+
+/// @brief Runs worker(thread_index) on threads_count threads (including
+///         the calling one) and waits for all of them.
+template <class Worker>
+void Run(std::size_t threads_count, Worker& worker) {
+    std::vector<std::jthread> threads;
+    threads.reserve(threads_count - 1);
+    for (std::size_t thread_index = 1; thread_index < threads_count;
+         thread_index++) {
+        threads.emplace_back(std::ref(worker), thread_index);
+    }
+    worker(std::size_t{0});
+}
+
+}  // namespace AppSpace::ACTrieDS::Workers
@@ -0,0 +1,184 @@
+#include "WuManberMatcher.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+namespace AppSpace::ACTrieDS {
+
+static_assert(!ACTrie::kIsCaseInsensitive,
+              "WuManberMatcher compares symbols case sensitively");
+
+WuManberMatcher& WuManberMatcher::AddPattern(Pattern pattern) {
+    assert(!is_ready_);
+    if (is_ready_) {
+        ResetWuManberMatcher();
+    }
+
+    if (const std::size_t bad_symbol_index =
+            StoredPatterns::FindBadSymbol(pattern);
+        bad_symbol_index != pattern.size()) {
+        bad_input_port_.Notify({bad_symbol_index, pattern[bad_symbol_index]});
+        return *this;
+    }
+
+    patterns_.Add(pattern);
+    return *this;
+}
+
+WuManberMatcher& WuManberMatcher::BuildWuManberMatcher() {
+    assert(!is_ready_);
+    patterns_.DedupeKeepLast();
+
+    shifts_.clear();
+    candidates_offsets_.clear();
+    candidates_.clear();
+    window_length_ = 0;
+    block_length_  = 0;
+    if (patterns_.empty()) {
+        is_ready_ = true;
+        return *this;
+    }
+
+    std::size_t min_pattern_length = patterns_[0].pattern.size();
+    for (const StoredPattern& stored_pattern : patterns_) {
+        min_pattern_length =
+            std::min(min_pattern_length, stored_pattern.pattern.size());
+    }
+    window_length_ = std::min(min_pattern_length, kMaxWindowLength);
+    block_length_  = window_length_ >= 3 &&
+                            patterns_.size() >= kLongBlockMinPatternsSize
+                         ? 3
+                     : window_length_ >= 2 ? 2
+                                           : 1;
+
+    const auto max_shift =
+        static_cast<Shift>(window_length_ - block_length_ + 1);
+    shifts_.assign(kHashTableSize, max_shift);
+    candidates_offsets_.assign(kHashTableSize + 1, 0);
+    for (const StoredPattern& stored_pattern : patterns_) {
+        const char* pattern = stored_pattern.pattern.data();
+        for (std::size_t q = block_length_ - 1; q < window_length_; q++) {
+            const std::uint32_t block_hash = HashBlock(pattern + q);
+            const auto shift = static_cast<Shift>(window_length_ - 1 - q);
+            shifts_[block_hash] = std::min(shifts_[block_hash], shift);
+        }
+        candidates_offsets_[HashBlock(pattern + window_length_ - 1) + 1]++;
+    }
+
+    for (std::size_t h = 0; h < kHashTableSize; h++) {
+        candidates_offsets_[h + 1] += candidates_offsets_[h];
+    }
+    candidates_.resize(patterns_.size());
+    std::vector<std::uint32_t> filled_offsets(candidates_offsets_.begin(),
+                                              candidates_offsets_.end() - 1);
+    for (std::size_t i = 0; i < patterns_.size(); i++) {
+        const std::uint32_t block_hash =
+            HashBlock(patterns_[i].pattern.data() + window_length_ - 1);
+        candidates_[filled_offsets[block_hash]++] =
+            static_cast<std::uint32_t>(i);
+    }
+
+    is_ready_ = true;
+    return *this;
+}
+
+WuManberMatcher& WuManberMatcher::ResetWuManberMatcher() {
+    is_ready_ = false;
+    patterns_.Clear();
+    shifts_.clear();
+    candidates_offsets_.clear();
+    candidates_.clear();
+    window_length_ = 0;
+    block_length_  = 0;
+    return *this;
+}
+
+WuManberMatcher& WuManberMatcher::FindAllSubstringsInText(Text text) {
+    if (!is_ready_) {
+        BuildWuManberMatcher();
+    }
+    if (patterns_.empty()) {
+        return *this;
+    }
+
+    pending_substrings_.Clear();
+    const char* const data = text.data();
+    for (std::size_t window_end = window_length_ - 1;
+         window_end < text.size();) {
+        const std::uint32_t block_hash = HashBlock(data + window_end);
+        const Shift shift              = shifts_[block_hash];
+        if (shift != 0) {
+            window_end += shift;
+            continue;
+        }
+
+        const std::size_t window_start = window_end + 1 - window_length_;
+        NotifyAboutPendingSubstrings(window_start);
+        VerifyCandidates(text, window_start, block_hash);
+        window_end++;
+    }
+    NotifyAboutPendingSubstrings(text.size());
+    return *this;
+}
+
+WuManberMatcher& WuManberMatcher::AddSubscriber(
+    FoundSubstringObserver* observer) {
+    found_substrings_port_.Subscribe(observer);
+    return *this;
+}
+
+WuManberMatcher& WuManberMatcher::AddSubscriber(
+    BadInputPatternObserver* observer) {
+    bad_input_port_.Subscribe(observer);
+    return *this;
+}
+
+std::uint32_t WuManberMatcher::HashBlock(
+    const char* block_end) const noexcept {
+    const auto last = static_cast<std::uint8_t>(block_end[0]);
+    switch (block_length_) {
+        case 1:
+            return last;
+        case 2:
+            return (std::uint32_t{static_cast<std::uint8_t>(block_end[-1])}
+                    << 8) |
+                   last;
+        default:
+            assert(block_length_ == 3);
+            return ((std::uint32_t{static_cast<std::uint8_t>(block_end[-2])}
+                     << 10) ^
+                    (std::uint32_t{static_cast<std::uint8_t>(block_end[-1])}
+                     << 5) ^
+                    last) &
+                   (kHashTableSize - 1);
+    }
+}
+
+void WuManberMatcher::VerifyCandidates(Text text, std::size_t window_start,
+                                       std::uint32_t block_hash) {
+    for (std::uint32_t i = candidates_offsets_[block_hash];
+         i < candidates_offsets_[block_hash + 1]; i++) {
+        const StoredPattern& stored_pattern = patterns_[candidates_[i]];
+        const std::string_view pattern      = stored_pattern.pattern;
+        if (text.size() - window_start < pattern.size() ||
+            text.compare(window_start, pattern.size(), pattern) != 0) {
+            continue;
+        }
+
+        pending_substrings_.Push(FoundSubstringInfo{
+            .found_substring       = text.substr(window_start, pattern.size()),
+            .substring_start_index = window_start,
+            .current_vertex_index  = ACTrie::kNullNodeIndex,
+            .word_index            = stored_pattern.word_index,
+        });
+    }
+}
+
+void WuManberMatcher::NotifyAboutPendingSubstrings(std::size_t end_bound) {
+    pending_substrings_.PopEndingBefore(
+        end_bound, [this](const FoundSubstringInfo& info) {
+            found_substrings_port_.Notify(info);
+        });
+}
+
+}  // namespace AppSpace::ACTrieDS
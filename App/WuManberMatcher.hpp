@@ -0,0 +1,96 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+#include "ACTrie.hpp"
+#include "Observer.hpp"
+#include "PendingSubstrings.hpp"
+#include "StoredPatterns.hpp"
+
+namespace AppSpace::ACTrieDS {
+
+/// @brief Wu-Manber block-shift matcher for sets of long patterns.
+///
+///  The text is scanned by the window of the minimal pattern length m.
+///   Last block (2 or 3 symbols) of the window is hashed and looked up in the
+///   shift table: how far the window can be moved so that no pattern prefix
+///   of length m is skipped. Only if the shift is zero, patterns whose
+///   m-prefix ends with a block with such hash are verified. On the sets of
+///   long patterns the average shift is close to m - block size + 1, so the
+///   scan speed grows with the minimal pattern length instead of staying at
+///   one transition per symbol.
+///
+///  Has the same interface for adding patterns and reporting found substrings
+///   as the ACTrie and reports substrings in the same order (by the end
+///   position, longer first). current_vertex_index of the found substring is
+///   always ACTrie::kNullNodeIndex. Unlike the ACTrie, it never reports the
+///   empty pattern (see StoredPatterns).
+class WuManberMatcher final {
+public:
+    using WordLength                = ACTrie::WordLength;
+    using Pattern                   = ACTrie::Pattern;
+    using Text                      = ACTrie::Text;
+    using FoundSubstringInfo        = ACTrie::FoundSubstringInfo;
+    using BadInputPatternInfo       = ACTrie::BadInputPatternInfo;
+    using FoundSubstringInfoPassBy  = ACTrie::FoundSubstringInfoPassBy;
+    using BadInputPatternInfoPassBy = ACTrie::BadInputPatternInfoPassBy;
+    using FoundSubstringObserver    = ACTrie::FoundSubstringObserver;
+    using BadInputPatternObserver   = ACTrie::BadInputPatternObserver;
+
+    using Shift = std::uint8_t;
+    // Window is limited so that shifts fit into one byte
+    static constexpr std::size_t kMaxWindowLength = 255;
+    static constexpr std::size_t kHashBits        = 16;
+    static constexpr std::size_t kHashTableSize   = std::size_t{1}
+                                                  << kHashBits;
+    // Block of 3 symbols is used for large sets, otherwise the shift
+    //  table becomes filled with small shifts
+    static constexpr std::size_t kLongBlockMinPatternsSize = 256;
+
+    WuManberMatcher& AddPattern(Pattern pattern);
+    WuManberMatcher& BuildWuManberMatcher();
+    WuManberMatcher& ResetWuManberMatcher();
+    WuManberMatcher& FindAllSubstringsInText(Text text);
+    WuManberMatcher& AddSubscriber(FoundSubstringObserver* observer);
+    WuManberMatcher& AddSubscriber(BadInputPatternObserver* observer);
+    constexpr std::size_t PatternsSize() const noexcept;
+    constexpr std::size_t WindowLength() const noexcept;
+    constexpr std::size_t BlockLength() const noexcept;
+
+private:
+    std::uint32_t HashBlock(const char* block_end) const noexcept;
+    void VerifyCandidates(Text text, std::size_t window_start,
+                          std::uint32_t block_hash);
+    void NotifyAboutPendingSubstrings(std::size_t end_bound);
+
+    StoredPatterns patterns_;
+    std::vector<Shift> shifts_;
+    // Patterns with the block hash h are
+    //  candidates_[candidates_offsets_[h]:candidates_offsets_[h + 1]]
+    std::vector<std::uint32_t> candidates_offsets_;
+    std::vector<std::uint32_t> candidates_;
+    std::size_t window_length_ = 0;
+    std::size_t block_length_  = 0;
+    bool is_ready_             = false;
+    PendingSubstrings pending_substrings_;
+    Observable<FoundSubstringInfo, FoundSubstringInfoPassBy>
+        found_substrings_port_;
+    Observable<BadInputPatternInfo, BadInputPatternInfoPassBy> bad_input_port_;
+};
+
+constexpr std::size_t WuManberMatcher::PatternsSize() const noexcept {
+    return patterns_.AddedSize();
+}
+
+constexpr std::size_t WuManberMatcher::WindowLength() const noexcept {
+    return window_length_;
+}
+
+constexpr std::size_t WuManberMatcher::BlockLength() const noexcept {
+    return block_length_;
+}
+
+}  // namespace AppSpace::ACTrieDS
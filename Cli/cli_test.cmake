@@ -0,0 +1,35 @@
+# Checks the exit codes and the output of actrie_cli, run by ctest as
+#  cmake -DACTRIE_CLI=<actrie_cli path> -DWORK_DIR=<directory> -P cli_test.cmake
+
+file(REMOVE_RECURSE "${WORK_DIR}")
+file(MAKE_DIRECTORY "${WORK_DIR}")
+file(WRITE "${WORK_DIR}/patterns.txt" "ab\nbc\n")
+file(WRITE "${WORK_DIR}/found.txt" "abc.abc")
+file(WRITE "${WORK_DIR}/not_found.txt" "xyz")
+
+function(check_cli expected_exit_code expected_output)
+    execute_process(
+        COMMAND "${ACTRIE_CLI}" ${ARGN}
+        WORKING_DIRECTORY "${WORK_DIR}"
+        RESULT_VARIABLE exit_code
+        OUTPUT_VARIABLE output
+        ERROR_QUIET
+    )
+    if (NOT exit_code STREQUAL expected_exit_code OR
+        NOT output STREQUAL expected_output)
+        message(FATAL_ERROR "actrie_cli ${ARGN}\n"
+            "exit code ${exit_code}, expected ${expected_exit_code}\n"
+            "output:\n${output}expected output:\n${expected_output}")
+    endif()
+endfunction()
+
+# Exit codes like the ones of grep: 0 found, 1 nothing found, 2 error
+check_cli(0 "0 0\n1 1\n4 0\n5 1\n" patterns.txt found.txt)
+check_cli(1 "" patterns.txt not_found.txt)
+check_cli(0 "4\n" -c patterns.txt found.txt)
+check_cli(0 "found.txt:4\nnot_found.txt:0\n"
+    -j 1 -c patterns.txt found.txt not_found.txt)
+# No count line for the file that can not be opened
+check_cli(2 "found.txt:4\n" -j 1 -c patterns.txt found.txt missing.txt)
+check_cli(2 "" -c missing.txt found.txt)
+check_cli(2 "" -x patterns.txt found.txt)
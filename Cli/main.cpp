@@ -0,0 +1,339 @@
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <exception>
+#include <filesystem>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+#include "../App/ACTrie.hpp"
+#include "../App/CorpusScanner.hpp"
+#include "../App/MappedFile.hpp"
+#include "../App/ScanPipeline.hpp"
+
+namespace {
+
+using AppSpace::ACTrieDS::ACTrie;
+using AppSpace::ACTrieDS::ByteSource;
+using AppSpace::ACTrieDS::CorpusScanner;
+using AppSpace::ACTrieDS::FileByteSource;
+using AppSpace::ACTrieDS::MappedFile;
+using AppSpace::ACTrieDS::ScanPipeline;
+
+// Exit codes like the ones of grep
+constexpr int kFoundExitCode    = 0;
+constexpr int kNotFoundExitCode = 1;
+constexpr int kErrorExitCode    = 2;
+
+constexpr std::string_view kUsage =
+    "Usage: actrie_cli [-j THREADS] [-c] PATTERNS_FILE [FILE...]\n"
+    "Finds all occurances of the patterns (one per line of PATTERNS_FILE)\n"
+    "in the files, or in stdin if there are no files or FILE is '-'.\n"
+    "Prints a line 'OFFSET PATTERN_ID' for each occurance, where\n"
+    "PATTERN_ID is the number of the pattern line counted from 0. With\n"
+    "several files each line starts with 'FILE:'.\n"
+    "  -j THREADS  number of the build and scanning threads (default: all\n"
+    "              cores)\n"
+    "  -c          print only the number of the occurances per input\n"
+    "Lines of one input are printed in order of the occurances, except\n"
+    "for stdin scanned by several threads, where they come by blocks.\n";
+
+struct Options final {
+    std::size_t threads_count = 0;
+    bool count_only           = false;
+    std::string patterns_path;
+    std::vector<std::string> inputs;
+};
+
+std::optional<Options> ParseOptions(std::span<char* const> arguments) {
+    Options options;
+    for (std::size_t i = 1; i < arguments.size(); i++) {
+        const std::string_view argument = arguments[i];
+        if (argument == "-j" && i + 1 < arguments.size()) {
+            const std::string_view value = arguments[++i];
+            const auto [end, error] =
+                std::from_chars(value.data(), value.data() + value.size(),
+                                options.threads_count);
+            if (error != std::errc{} || end != value.data() + value.size()) {
+                return std::nullopt;
+            }
+        } else if (argument == "-c") {
+            options.count_only = true;
+        } else if (argument.starts_with('-') && argument != "-") {
+            return std::nullopt;
+        } else if (options.patterns_path.empty()) {
+            options.patterns_path = argument;
+        } else {
+            options.inputs.emplace_back(argument);
+        }
+    }
+    if (options.patterns_path.empty()) {
+        return std::nullopt;
+    }
+    if (options.inputs.empty()) {
+        options.inputs.emplace_back("-");
+    }
+    return options;
+}
+
+/// @brief Adds the lines of the file as the patterns. Lines with the
+///         symbols out of the ACTrie alphabet and empty lines are skipped,
+///         so the line number of each word_index is remembered.
+std::vector<std::size_t> LoadPatterns(const std::string& path,
+                                      ACTrie& actrie) {
+    const MappedFile file(path);
+    std::vector<std::size_t> patterns_lines;
+    std::string_view contents = file.Contents();
+    for (std::size_t line_number = 0; !contents.empty(); line_number++) {
+        const std::size_t line_end = contents.find('\n');
+        std::string_view line      = contents.substr(0, line_end);
+        contents.remove_prefix(line_end != std::string_view::npos
+                                   ? line_end + 1
+                                   : contents.size());
+        if (line.ends_with('\r')) {
+            line.remove_suffix(1);
+        }
+
+        const bool is_correct_pattern =
+            !line.empty() && std::ranges::all_of(line, [](char symbol) {
+                return ACTrie::SymbolToIndex(symbol) < ACTrie::kAlphabetLength;
+            });
+        if (!is_correct_pattern) {
+            if (!line.empty()) {
+                std::cerr << "actrie_cli: skipped pattern on line "
+                          << line_number << ": symbols must be from '"
+                          << ACTrie::kAlphabetStart << "' to '"
+                          << ACTrie::kAlphabetEnd << "'\n";
+            }
+            continue;
+        }
+        actrie.AddPattern(line);
+        patterns_lines.push_back(line_number);
+    }
+    return patterns_lines;
+}
+
+/// @brief Lines are collected in a buffer and written to stdout by large
+///         blocks, so that lines of different inputs are never cut. Blocks
+///         of different inputs scanned at the same time can interleave,
+///         each line is prefixed with the input name then.
+class OutputBuffer final {
+public:
+    static constexpr std::size_t kFlushSize = std::size_t{1} << 16;
+
+    explicit OutputBuffer(std::mutex& stdout_mutex) noexcept
+        : stdout_mutex_(stdout_mutex) {}
+    OutputBuffer(const OutputBuffer&)            = delete;
+    OutputBuffer& operator=(const OutputBuffer&) = delete;
+    ~OutputBuffer() {
+        Flush();
+    }
+
+    void Append(std::string_view text) {
+        buffer_.append(text);
+    }
+
+    void AppendNumber(std::uint64_t number) {
+        char digits[24];
+        const auto result =
+            std::to_chars(std::begin(digits), std::end(digits), number);
+        buffer_.append(digits, result.ptr);
+    }
+
+    void EndLine() {
+        buffer_.push_back('\n');
+        if (buffer_.size() >= kFlushSize) {
+            Flush();
+        }
+    }
+
+    void Flush() {
+        std::lock_guard lock(stdout_mutex_);
+        std::fwrite(buffer_.data(), 1, buffer_.size(), stdout);
+        buffer_.clear();
+    }
+
+private:
+    std::mutex& stdout_mutex_;
+    std::string buffer_;
+};
+
+/// @brief Prints the occurances of one input.
+class Printer final {
+public:
+    Printer(std::string prefix, const std::vector<std::size_t>& patterns_lines,
+            bool count_only, std::mutex& stdout_mutex)
+        : prefix_(std::move(prefix)),
+          patterns_lines_(patterns_lines),
+          output_(stdout_mutex),
+          count_only_(count_only) {}
+
+    void Print(std::uint64_t offset, ACTrie::WordLength word_index) {
+        occurances_count_++;
+        if (!count_only_) {
+            output_.Append(prefix_);
+            output_.AppendNumber(offset);
+            output_.Append(" ");
+            output_.AppendNumber(patterns_lines_[word_index]);
+            output_.EndLine();
+        }
+    }
+
+    /// @brief Flushes the lines. The count is not printed for the input
+    ///         that could not be read, like by grep.
+    /// @param is_read
+    void Finish(bool is_read = true) {
+        if (count_only_ && is_read) {
+            output_.Append(prefix_);
+            output_.AppendNumber(occurances_count_);
+            output_.EndLine();
+        }
+        output_.Flush();
+    }
+
+    constexpr std::uint64_t OccurancesCount() const noexcept {
+        return occurances_count_;
+    }
+
+private:
+    std::string prefix_;
+    const std::vector<std::size_t>& patterns_lines_;
+    OutputBuffer output_;
+    std::uint64_t occurances_count_ = 0;
+    bool count_only_;
+};
+
+class FileSink final : public CorpusScanner::DocumentSink {
+public:
+    FileSink(std::string path, Printer& printer) noexcept
+        : path_(std::move(path)), printer_(printer) {}
+
+    void OnFoundSubstrings(
+        std::span<const ACTrie::FoundSubstringInfo> infos) override {
+        for (const ACTrie::FoundSubstringInfo& info : infos) {
+            printer_.Print(info.substring_start_index, info.word_index);
+        }
+    }
+
+    void OnDocumentScanned(std::error_code error) override {
+        if (error) {
+            std::cerr << "actrie_cli: " << path_ << ": " << error.message()
+                      << '\n';
+            failed_ = true;
+        }
+        printer_.Finish(!error);
+    }
+
+    constexpr bool Failed() const noexcept {
+        return failed_;
+    }
+
+private:
+    std::string path_;
+    Printer& printer_;
+    bool failed_ = false;
+};
+
+class StdinSink final : public ScanPipeline::MatchesSink {
+public:
+    explicit StdinSink(Printer& printer) noexcept : printer_(printer) {}
+
+    void OnMatches(const ScanPipeline::MatchesBatch& batch) override {
+        for (const ScanPipeline::Match& match : batch.matches) {
+            printer_.Print(match.offset, match.word_index);
+        }
+    }
+
+private:
+    Printer& printer_;
+};
+
+int Run(const Options& options) {
+    ACTrie actrie;
+    actrie.SetBuildThreadsCount(options.threads_count);
+    const std::vector<std::size_t> patterns_lines =
+        LoadPatterns(options.patterns_path, actrie);
+    actrie.BuildACTrie();
+
+    std::mutex stdout_mutex;
+    const bool print_names = options.inputs.size() > 1;
+    std::vector<std::unique_ptr<Printer>> printers;
+    for (const std::string& input : options.inputs) {
+        printers.push_back(std::make_unique<Printer>(
+            print_names ? input + ":" : std::string(), patterns_lines,
+            options.count_only, stdout_mutex));
+    }
+
+    bool failed = false;
+    std::vector<std::unique_ptr<FileSink>> file_sinks;
+    std::vector<CorpusScanner::Document> documents;
+    for (std::size_t i = 0; i < options.inputs.size(); i++) {
+        if (options.inputs[i] == "-") {
+            continue;
+        }
+        file_sinks.push_back(
+            std::make_unique<FileSink>(options.inputs[i], *printers[i]));
+        documents.push_back(CorpusScanner::Document{
+            .source = std::filesystem::path(options.inputs[i]),
+            .sink   = file_sinks.back().get(),
+        });
+    }
+    CorpusScanner(actrie, options.threads_count).Scan(documents);
+    for (const auto& file_sink : file_sinks) {
+        failed = failed || file_sink->Failed();
+    }
+
+    // Stdin is read once, even if it is given several times
+    for (std::size_t i = 0; i < options.inputs.size(); i++) {
+        if (options.inputs[i] != "-") {
+            continue;
+        }
+        FileByteSource source(stdin);
+        ByteSource* sources[] = {&source};
+        StdinSink sink(*printers[i]);
+        ScanPipeline(actrie)
+            .SetThreadsCounts(1, options.threads_count, 1)
+            .Run(sources, sink);
+        printers[i]->Finish();
+        break;
+    }
+
+    std::uint64_t occurances_count = 0;
+    for (const auto& printer : printers) {
+        occurances_count += printer->OccurancesCount();
+    }
+    if (failed) {
+        return kErrorExitCode;
+    }
+    return occurances_count != 0 ? kFoundExitCode : kNotFoundExitCode;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    const std::optional<Options> options =
+        ParseOptions(std::span(argv, std::size_t(argc)));
+    if (!options) {
+        std::cerr << kUsage;
+        return kErrorExitCode;
+    }
+
+    try {
+        return Run(*options);
+    } catch (const std::exception& ex) {
+        std::cerr << "actrie_cli: " << ex.what() << '\n';
+    } catch (...) {
+        std::cerr << "actrie_cli: unknown error\n";
+    }
+    return kErrorExitCode;
+}
@@ -0,0 +1,1547 @@
+#include "benchmarks.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdint>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <ranges>
+#include <regex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "../App/ACTrie.hpp"
+#include "../App/ApproximateMatcher.hpp"
+#include "../App/AutoMatcher.hpp"
+#include "../App/ClassPatternMatcher.hpp"
+#include "../App/HugePagesMemoryResource.hpp"
+#include "../App/MappedFile.hpp"
+#include "../App/MatchRange.hpp"
+#include "../App/MatchesWriter.hpp"
+#include "../App/OccurancesHistogram.hpp"
+#include "../App/ScanPipeline.hpp"
+#include "../App/ShiftAndMatcher.hpp"
+#include "../App/StreamScheduler.hpp"
+#include "../App/TeddyMatcher.hpp"
+#include "../App/UringFileScanner.hpp"
+#include "../App/Utf8.hpp"
+#include "../App/Utf8Matcher.hpp"
+#include "../App/WildcardMatcher.hpp"
+#include "../App/WuManberMatcher.hpp"
+#include "Timer.hpp"
+
+namespace AppSpace {
+
+namespace {
+
+using ACTrie = ACTrieDS::ACTrie;
+
+struct ScanMeasurement final {
+    std::size_t found_occurances_size;
+    Timer::Duration time_passed_millis;
+};
+
+struct BenchmarkResult final {
+    std::vector<std::pair<std::string, ScanMeasurement>> measurements;
+    std::size_t patterns_size;
+    std::size_t text_size;
+    // What found_occurances_size of the measurements counts
+    std::string_view counter_name = "occurances found";
+};
+
+template <class Matcher>
+ScanMeasurement MeasureScan(Matcher& matcher, std::string_view text) {
+    std::size_t found_occurances_size = 0;
+    typename Matcher::FoundSubstringObserver found_substrings_obs(
+        [&found_occurances_size](ACTrie::FoundSubstringInfoPassBy) {
+            found_occurances_size++;
+        });
+    matcher.AddSubscriber(&found_substrings_obs);
+
+    Timer timer;
+    matcher.FindAllSubstringsInText(text);
+    return {
+        .found_occurances_size = found_occurances_size,
+        .time_passed_millis    = timer.TimePassed(),
+    };
+}
+
+/// @brief Generates text that looks like a log file: lowercase words,
+///         digits and punctuation with rare uppercase error markers.
+std::string GenerateLogText(std::size_t text_length,
+                            const std::string_view rare_words[],
+                            std::size_t rare_words_size,
+                            std::size_t rare_word_period) {
+    constexpr std::string_view kWords[] = {
+        "request", "handled", "user",  "session", "cache", "miss",
+        "hit",     "path",    "items", "query",   "ok",    "latency",
+    };
+    std::mt19937 rnd(2024);
+    std::string text;
+    text.reserve(text_length + 64);
+    std::size_t line_number = 0;
+    while (text.size() < text_length) {
+        text += "2024-05-09 12:";
+        text += std::to_string(rnd() % 60);
+        text += " [info] ";
+        const std::size_t words_in_line = 4 + rnd() % 8;
+        for (std::size_t i = 0; i < words_in_line; i++) {
+            text += kWords[rnd() % std::size(kWords)];
+            text += i % 3 == 2 ? "=" : " ";
+            text += std::to_string(rnd() % 1000);
+            text += ' ';
+        }
+        if (++line_number % rare_word_period == 0) {
+            text += rare_words[rnd() % rare_words_size];
+        }
+        text += '\n';
+    }
+    text.resize(text_length);
+    return text;
+}
+
+BenchmarkResult SparseLogPrefilterBenchmark() {
+    std::string_view patterns[] = {"ERROR", "FATAL", "Timeout"};
+    constexpr std::size_t kTextLength      = 1 << 26;
+    constexpr std::size_t kRareWordsPeriod = 1000;
+    const std::string text = GenerateLogText(
+        kTextLength, patterns, std::size(patterns), kRareWordsPeriod);
+
+    ACTrie actrie;
+    for (std::string_view pattern : patterns) {
+        actrie.AddPattern(pattern);
+    }
+    actrie.BuildACTrie();
+
+    BenchmarkResult result{
+        .measurements  = {},
+        .patterns_size = std::size(patterns),
+        .text_size     = text.size(),
+    };
+    actrie.SetPrefilterEnabled(false);
+    result.measurements.emplace_back("ACTrie without prefilter",
+                                     MeasureScan(actrie, text));
+    actrie.SetPrefilterEnabled(true);
+    result.measurements.emplace_back("ACTrie with first symbol prefilter",
+                                     MeasureScan(actrie, text));
+    return result;
+}
+
+template <class Matcher>
+void AddPatterns(Matcher& matcher, const std::vector<std::string>& patterns) {
+    for (std::string_view pattern : patterns) {
+        matcher.AddPattern(pattern);
+    }
+}
+
+/// @brief Generates patterns_size random words (lowercase letters only).
+std::vector<std::string> GenerateKeywords(std::size_t patterns_size,
+                                          std::size_t min_pattern_length,
+                                          std::size_t max_pattern_length,
+                                          std::uint32_t seed) {
+    std::mt19937 rnd(seed);
+    std::vector<std::string> patterns(patterns_size);
+    for (std::string& pattern : patterns) {
+        const std::size_t length =
+            min_pattern_length +
+            rnd() % (max_pattern_length - min_pattern_length + 1);
+        for (std::size_t i = 0; i < length; i++) {
+            pattern.push_back(static_cast<char>('a' + rnd() % 26));
+        }
+    }
+    return patterns;
+}
+
+BenchmarkResult SmallSetTeddyBenchmark() {
+    constexpr std::size_t kTextLength = 1 << 26;
+    BenchmarkResult result{
+        .measurements  = {},
+        .patterns_size = 0,
+        .text_size     = kTextLength,
+    };
+    constexpr std::size_t kPatternsSizes[] = {5, 15, 30};
+    for (std::size_t patterns_size : kPatternsSizes) {
+        auto patterns = GenerateKeywords(patterns_size, 5, 12,
+                                         std::uint32_t(patterns_size));
+        std::vector<std::string_view> rare_words(patterns.begin(),
+                                                 patterns.end());
+        const std::string text = GenerateLogText(
+            kTextLength, rare_words.data(), rare_words.size(), 10);
+        result.patterns_size += patterns_size;
+
+        ACTrie actrie;
+        AddPatterns(actrie, patterns);
+        result.measurements.emplace_back(
+            "ACTrie, " + std::to_string(patterns_size) + " patterns",
+            MeasureScan(actrie, text));
+        ACTrieDS::TeddyMatcher teddy;
+        AddPatterns(teddy, patterns);
+        result.measurements.emplace_back(
+            "TeddyMatcher, " + std::to_string(patterns_size) + " patterns",
+            MeasureScan(teddy, text));
+    }
+    return result;
+}
+
+BenchmarkResult ShortPatternsShiftAndBenchmark() {
+    constexpr std::size_t kTextLength = 1 << 26;
+    BenchmarkResult result{
+        .measurements  = {},
+        .patterns_size = 0,
+        .text_size     = kTextLength,
+    };
+    // Text is generated from the same small alphabet as the patterns,
+    //  so the automaton rarely returns to the root.
+    constexpr std::pair<std::size_t, std::size_t> kPatternsSets[] = {
+        {8, 6},
+        {16, 8},
+    };
+    std::mt19937 rnd(28);
+    std::string text(kTextLength, '\0');
+    for (char& c : text) {
+        c = static_cast<char>('a' + rnd() % 4);
+    }
+    for (const auto& [patterns_size, max_pattern_length] : kPatternsSets) {
+        std::vector<std::string> patterns(patterns_size);
+        for (std::string& pattern : patterns) {
+            const std::size_t length = 3 + rnd() % (max_pattern_length - 2);
+            for (std::size_t i = 0; i < length; i++) {
+                pattern.push_back(static_cast<char>('a' + rnd() % 4));
+            }
+        }
+        result.patterns_size += patterns_size;
+        const std::string suffix =
+            ", " + std::to_string(patterns_size) + " patterns";
+
+        ACTrie actrie;
+        AddPatterns(actrie, patterns);
+        result.measurements.emplace_back("ACTrie" + suffix,
+                                         MeasureScan(actrie, text));
+        ACTrieDS::TeddyMatcher teddy;
+        AddPatterns(teddy, patterns);
+        result.measurements.emplace_back("TeddyMatcher" + suffix,
+                                         MeasureScan(teddy, text));
+        ACTrieDS::ShiftAndMatcher shift_and;
+        AddPatterns(shift_and, patterns);
+        result.measurements.emplace_back("ShiftAndMatcher" + suffix,
+                                         MeasureScan(shift_and, text));
+    }
+    return result;
+}
+
+BenchmarkResult LongPatternsWuManberBenchmark() {
+    constexpr std::size_t kTextLength   = 1 << 26;
+    constexpr std::size_t kPatternsSize = 2000;
+    BenchmarkResult result{
+        .measurements  = {},
+        .patterns_size = kPatternsSize,
+        .text_size     = kTextLength,
+    };
+    constexpr std::size_t kMinPatternsLengths[] = {8, 16, 32};
+    for (std::size_t min_pattern_length : kMinPatternsLengths) {
+        auto patterns = GenerateKeywords(kPatternsSize, min_pattern_length,
+                                         2 * min_pattern_length,
+                                         std::uint32_t(min_pattern_length));
+        std::vector<std::string_view> rare_words(patterns.begin(),
+                                                 patterns.end());
+        const std::string text = GenerateLogText(
+            kTextLength, rare_words.data(), rare_words.size(), 100);
+        const std::string suffix = ", min pattern length " +
+                                   std::to_string(min_pattern_length);
+
+        ACTrie actrie;
+        AddPatterns(actrie, patterns);
+        result.measurements.emplace_back("ACTrie" + suffix,
+                                         MeasureScan(actrie, text));
+        ACTrieDS::WuManberMatcher wu_manber;
+        AddPatterns(wu_manber, patterns);
+        result.measurements.emplace_back("WuManberMatcher" + suffix,
+                                         MeasureScan(wu_manber, text));
+    }
+    return result;
+}
+
+/// @brief Measures all matchers on the grid of the patterns sets, thresholds
+///         of the AutoMatcher::ChooseEngine() are calibrated by this table.
+BenchmarkResult EngineSelectionBenchmark() {
+    using AutoMatcher = ACTrieDS::AutoMatcher;
+    constexpr std::size_t kTextLength       = 1 << 24;
+    constexpr std::size_t kTeddyMaxPatterns = 256;
+    BenchmarkResult result{
+        .measurements  = {},
+        .patterns_size = 0,
+        .text_size     = kTextLength,
+    };
+    constexpr std::size_t kPatternsSizes[]      = {4, 16, 32, 64, 256, 2000};
+    constexpr std::size_t kMinPatternsLengths[] = {1, 2, 4, 6, 16};
+    // Chosen engine is calibrated well for the shape if it is at most 25%
+    //  (and 1ms for the timer resolution) slower than the fastest one
+    constexpr std::size_t kToleratedSlowdownPercents = 25;
+    std::size_t shapes_size                          = 0;
+    std::size_t well_chosen_shapes_size              = 0;
+    std::vector<std::pair<std::string, ScanMeasurement>> badly_chosen_shapes;
+    for (std::size_t patterns_size : kPatternsSizes) {
+        for (std::size_t min_pattern_length : kMinPatternsLengths) {
+            auto patterns = GenerateKeywords(
+                patterns_size, min_pattern_length, 2 * min_pattern_length,
+                std::uint32_t(patterns_size * 100 + min_pattern_length));
+            std::vector<std::string_view> rare_words(patterns.begin(),
+                                                     patterns.end());
+            const std::string text = GenerateLogText(
+                kTextLength, rare_words.data(), rare_words.size(), 10);
+            const auto statistics = AutoMatcher::ComputeStatistics(patterns);
+            const auto chosen_engine = AutoMatcher::ChooseEngine(statistics);
+            result.patterns_size =
+                std::max(result.patterns_size, patterns_size);
+            const std::string shape_name =
+                std::to_string(patterns_size) + " patterns, min length " +
+                std::to_string(min_pattern_length);
+
+            Timer::Duration chosen_time{};
+            Timer::Duration fastest_time = Timer::Duration::max();
+            AutoMatcher::Engine fastest_engine = chosen_engine;
+            auto measure = [&]<class Matcher>(Matcher& matcher,
+                                              AutoMatcher::Engine engine) {
+                AddPatterns(matcher, patterns);
+                std::string name =
+                    shape_name + ", " +
+                    std::string(AutoMatcher::EngineName(engine));
+                const ScanMeasurement measurement = MeasureScan(matcher, text);
+                if (engine == chosen_engine) {
+                    name += " (chosen)";
+                    chosen_time = measurement.time_passed_millis;
+                }
+                if (measurement.time_passed_millis < fastest_time) {
+                    fastest_time   = measurement.time_passed_millis;
+                    fastest_engine = engine;
+                }
+                result.measurements.emplace_back(std::move(name), measurement);
+            };
+            {
+                ACTrie actrie;
+                actrie.SetPrefilterEnabled(false);
+                measure(actrie, AutoMatcher::Engine::kACTrie);
+            }
+            if (statistics.first_symbols_size <=
+                AutoMatcher::kPrefilterMaxFirstSymbols) {
+                ACTrie actrie;
+                measure(actrie, AutoMatcher::Engine::kACTrieWithPrefilter);
+            }
+            if (patterns_size <= kTeddyMaxPatterns) {
+                ACTrieDS::TeddyMatcher teddy;
+                measure(teddy, AutoMatcher::Engine::kTeddy);
+            }
+            if (statistics.patterns_total_length <=
+                ACTrieDS::ShiftAndMatcher::kMaxPatternsTotalLength) {
+                ACTrieDS::ShiftAndMatcher shift_and;
+                measure(shift_and, AutoMatcher::Engine::kShiftAnd);
+            }
+            ACTrieDS::WuManberMatcher wu_manber;
+            measure(wu_manber, AutoMatcher::Engine::kWuManber);
+
+            shapes_size++;
+            if (chosen_time * 100 <=
+                fastest_time * (100 + kToleratedSlowdownPercents) +
+                    Timer::Duration(100)) {
+                well_chosen_shapes_size++;
+            } else {
+                badly_chosen_shapes.emplace_back(
+                    shape_name + ", chosen " +
+                        std::string(AutoMatcher::EngineName(chosen_engine)) +
+                        " is slower than " +
+                        std::string(AutoMatcher::EngineName(fastest_engine)) +
+                        " by",
+                    ScanMeasurement{
+                        .found_occurances_size = 0,
+                        .time_passed_millis    = chosen_time - fastest_time,
+                    });
+            }
+        }
+    }
+
+    // Thresholds of the AutoMatcher should be updated if the shapes below
+    //  are listed
+    result.measurements.insert(result.measurements.end(),
+                               badly_chosen_shapes.begin(),
+                               badly_chosen_shapes.end());
+    result.measurements.emplace_back(
+        "chosen engine is close to the fastest for " +
+            std::to_string(well_chosen_shapes_size) + " of " +
+            std::to_string(shapes_size) + " shapes",
+        ScanMeasurement{
+            .found_occurances_size = 0,
+            .time_passed_millis    = {},
+        });
+    return result;
+}
+
+BenchmarkResult ParallelBuildBenchmark() {
+    constexpr std::size_t kPatternsSize = 1'000'000;
+    auto patterns = GenerateKeywords(kPatternsSize, 4, 16, 31);
+    const std::vector<std::string_view> patterns_views(patterns.begin(),
+                                                       patterns.end());
+    std::size_t patterns_total_length = 0;
+    for (std::string_view pattern : patterns_views) {
+        patterns_total_length += pattern.size();
+    }
+    BenchmarkResult result{
+        .measurements  = {},
+        .patterns_size = kPatternsSize,
+        // Speed is measured in the symbols of the patterns
+        .text_size     = patterns_total_length,
+        .counter_name  = "nodes built",
+    };
+
+    const std::size_t threads_counts[] = {1, 0};
+    for (std::size_t threads_count : threads_counts) {
+        ACTrie actrie;
+        actrie.SetBuildThreadsCount(threads_count);
+        Timer timer;
+        actrie.AddPatterns(patterns_views).BuildACTrie();
+        result.measurements.emplace_back(
+            std::to_string(actrie.BuildThreadsCount()) + " build threads",
+            ScanMeasurement{
+                .found_occurances_size = actrie.NodesSize(),
+                .time_passed_millis    = timer.TimePassed(),
+            });
+    }
+    return result;
+}
+
+BenchmarkResult HugePagesBenchmark() {
+    using ACTrieDS::HugePagesMemoryResource;
+    constexpr std::size_t kPatternsSize = 300'000;
+    constexpr std::size_t kTextLength   = 1 << 25;
+    BenchmarkResult result{
+        .measurements  = {},
+        .patterns_size = kPatternsSize,
+        .text_size     = kTextLength,
+    };
+    const auto patterns = GenerateKeywords(kPatternsSize, 6, 20, 33);
+    // Random text walks to the random nodes of the first levels of the
+    //  trie, which are spread over hundreds of megabytes of the nodes.
+    std::mt19937 rnd(33);
+    std::string text(kTextLength, '\0');
+    for (char& symbol : text) {
+        symbol = static_cast<char>('a' + rnd() % 26);
+    }
+
+    auto measure = [&](std::pmr::memory_resource* memory_resource,
+                       std::string name) {
+        ACTrie actrie(memory_resource);
+        AddPatterns(actrie, patterns);
+        actrie.BuildACTrie();
+        result.measurements.emplace_back(std::move(name),
+                                         MeasureScan(actrie, text));
+    };
+    measure(std::pmr::get_default_resource(), "4 KB pages");
+    HugePagesMemoryResource transparent_resource(
+        HugePagesMemoryResource::Mode::kTransparent);
+    measure(&transparent_resource, "transparent 2 MB pages");
+    HugePagesMemoryResource explicit_resource(
+        HugePagesMemoryResource::Mode::kExplicit);
+    measure(&explicit_resource, "explicit 2 MB pages");
+    if (explicit_resource.ExplicitHugePagesFallbacks() != 0) {
+        result.measurements.back().first +=
+            " (not reserved, transparent used)";
+    }
+    return result;
+}
+
+BenchmarkResult ScoringBenchmark() {
+    constexpr std::size_t kPatternsSize = 5'000;
+    constexpr std::size_t kTextLength   = 1 << 25;
+    const auto patterns = GenerateKeywords(kPatternsSize, 2, 6, 36);
+    std::mt19937 rnd(36);
+    std::string text(kTextLength, '\0');
+    for (char& symbol : text) {
+        symbol = static_cast<char>('a' + rnd() % 26);
+    }
+    BenchmarkResult result{
+        .measurements  = {},
+        .patterns_size = kPatternsSize,
+        .text_size     = kTextLength,
+        .counter_name  = "score",
+    };
+
+    auto build_actrie = [&](ACTrie& actrie, std::uint32_t max_counted) {
+        AddPatterns(actrie, patterns);
+        for (std::size_t i = 0; i < patterns.size(); i++) {
+            actrie.SetPatternWeight(i, ACTrie::Score(i % 5), max_counted);
+        }
+        actrie.BuildACTrie();
+    };
+    auto measure_score_text = [&](const ACTrie& actrie, std::string name) {
+        Timer timer;
+        const ACTrie::Score score = actrie.ScoreText(text);
+        result.measurements.emplace_back(
+            std::move(name), ScanMeasurement{
+                                 .found_occurances_size = std::size_t(score),
+                                 .time_passed_millis = timer.TimePassed(),
+                             });
+    };
+
+    ACTrie actrie;
+    build_actrie(actrie, ACTrie::kUncappedOccurances);
+    // What had to be done before: weights of the found substrings are
+    //  summed by the subscriber
+    ACTrie::Score score = 0;
+    ACTrie::FoundSubstringObserver found_substrings_obs(
+        [&score](ACTrie::FoundSubstringInfoPassBy info) {
+            score += ACTrie::Score(info.word_index % 5);
+        });
+    actrie.AddSubscriber(&found_substrings_obs);
+    Timer timer;
+    actrie.FindAllSubstringsInText(text);
+    result.measurements.emplace_back(
+        "sum in the found substrings subscriber",
+        ScanMeasurement{
+            .found_occurances_size = std::size_t(score),
+            .time_passed_millis    = timer.TimePassed(),
+        });
+    measure_score_text(actrie, "ScoreText, weights of the output chains");
+
+    ACTrie capped_actrie;
+    build_actrie(capped_actrie, std::numeric_limits<std::uint32_t>::max() - 1);
+    measure_score_text(capped_actrie, "ScoreText, capped patterns");
+    return result;
+}
+
+BenchmarkResult OccurancesHistogramBenchmark() {
+    using ACTrieDS::OccurancesHistogram;
+    constexpr std::size_t kPatternsSize = 5'000;
+    constexpr std::size_t kTextsSize    = 256;
+    constexpr std::size_t kTextLength   = 1 << 17;
+    const auto patterns = GenerateKeywords(kPatternsSize, 2, 6, 37);
+    std::mt19937 rnd(37);
+    std::vector<std::string> texts(kTextsSize, std::string(kTextLength, ' '));
+    for (std::string& text : texts) {
+        for (char& symbol : text) {
+            symbol = static_cast<char>('a' + rnd() % 26);
+        }
+    }
+    const std::vector<std::string_view> texts_views(texts.begin(),
+                                                    texts.end());
+    BenchmarkResult result{
+        .measurements  = {},
+        .patterns_size = kPatternsSize,
+        .text_size     = kTextsSize * kTextLength,
+    };
+    ACTrie actrie;
+    AddPatterns(actrie, patterns);
+    actrie.BuildACTrie();
+
+    // What had to be done before: counts are incremented by the subscriber
+    std::vector<OccurancesHistogram::Count> counts(kPatternsSize);
+    ACTrie::FoundSubstringObserver found_substrings_obs(
+        [&counts](ACTrie::FoundSubstringInfoPassBy info) {
+            counts[info.word_index]++;
+        });
+    actrie.AddSubscriber(&found_substrings_obs);
+    Timer timer;
+    for (std::string_view text : texts_views) {
+        actrie.FindAllSubstringsInText(text);
+    }
+    std::size_t found_occurances_size = 0;
+    for (OccurancesHistogram::Count count : counts) {
+        found_occurances_size += count;
+    }
+    result.measurements.emplace_back(
+        "count in the found substrings subscriber",
+        ScanMeasurement{
+            .found_occurances_size = found_occurances_size,
+            .time_passed_millis    = timer.TimePassed(),
+        });
+
+    for (std::size_t threads_count : {std::size_t{1}, std::size_t{0}}) {
+        OccurancesHistogram histogram(actrie, threads_count);
+        timer.GetAndResetTime();
+        histogram.CountInTexts(texts_views);
+        const auto time_passed_millis = timer.TimePassed();
+        found_occurances_size         = 0;
+        for (OccurancesHistogram::Count count : histogram.Counts()) {
+            found_occurances_size += count;
+        }
+        result.measurements.emplace_back(
+            "histogram, " + std::to_string(histogram.ThreadsCount()) +
+                " threads",
+            ScanMeasurement{
+                .found_occurances_size = found_occurances_size,
+                .time_passed_millis    = time_passed_millis,
+            });
+    }
+    return result;
+}
+
+BenchmarkResult ScanPipelineBenchmark() {
+    using ACTrieDS::ByteSource;
+    using ACTrieDS::FileByteSource;
+    using ACTrieDS::ScanPipeline;
+    constexpr std::size_t kPatternsSize = 5'000;
+    constexpr std::size_t kTextLength   = 1 << 26;
+    std::string_view rare_words[] = {"ERROR", "FATAL", "Timeout"};
+    const std::string text =
+        GenerateLogText(kTextLength, rare_words, std::size(rare_words), 100);
+    const std::filesystem::path path =
+        std::filesystem::temp_directory_path() / "actrie_pipeline_benchmark";
+    std::ofstream(path, std::ios::binary) << text;
+    BenchmarkResult result{
+        .measurements  = {},
+        .patterns_size = kPatternsSize,
+        .text_size     = text.size(),
+    };
+    ACTrie actrie;
+    AddPatterns(actrie, GenerateKeywords(kPatternsSize, 4, 12, 39));
+    for (std::string_view rare_word : rare_words) {
+        actrie.AddPattern(rare_word);
+    }
+    actrie.BuildACTrie();
+
+    // What had to be done before: the file is read and then scanned
+    Timer timer;
+    std::size_t found_occurances_size = 0;
+    {
+        std::string contents(std::filesystem::file_size(path), '\0');
+        std::FILE* file = std::fopen(path.string().c_str(), "rb");
+        contents.resize(
+            std::fread(contents.data(), 1, contents.size(), file));
+        std::fclose(file);
+        actrie.FindAllSubstringsInText(
+            contents, [&found_occurances_size](
+                          const ACTrie::FoundSubstringInfo&) noexcept {
+                found_occurances_size++;
+            });
+    }
+    result.measurements.emplace_back(
+        "read the whole file, then scan",
+        ScanMeasurement{
+            .found_occurances_size = found_occurances_size,
+            .time_passed_millis    = timer.TimePassed(),
+        });
+
+    class CountingSink final : public ScanPipeline::MatchesSink {
+    public:
+        void OnMatches(const ScanPipeline::MatchesBatch& batch) override {
+            matches_count += batch.matches.size();
+        }
+
+        std::size_t matches_count = 0;
+    };
+    for (std::size_t scanner_threads_count : {1U, 0U}) {
+        std::FILE* file = std::fopen(path.string().c_str(), "rb");
+        FileByteSource source(file);
+        ByteSource* sources[] = {&source};
+        CountingSink sink;
+        ScanPipeline pipeline(actrie);
+        pipeline.SetThreadsCounts(1, scanner_threads_count, 1);
+        timer.GetAndResetTime();
+        pipeline.Run(sources, sink);
+        const auto time_passed_millis = timer.TimePassed();
+        std::fclose(file);
+        const ScanPipeline::Stats stats = pipeline.GetStats();
+        std::string name = "pipeline, " +
+                           std::to_string(scanner_threads_count) +
+                           " scanner threads (0 is all), stalls: reader ";
+        name += std::to_string(stats.readers.output_stalls_count) +
+                ", scanners " +
+                std::to_string(stats.scanners.input_stalls_count) + "/" +
+                std::to_string(stats.scanners.output_stalls_count) +
+                ", sink " + std::to_string(stats.sinks.input_stalls_count);
+        result.measurements.emplace_back(
+            std::move(name), ScanMeasurement{
+                .found_occurances_size = sink.matches_count,
+                .time_passed_millis    = time_passed_millis,
+            });
+    }
+    std::filesystem::remove(path);
+    return result;
+}
+
+BenchmarkResult UringFilesBenchmark() {
+    using ACTrieDS::MappedFile;
+    using ACTrieDS::UringFileScanner;
+    constexpr std::size_t kPatternsSize = 5'000;
+    constexpr std::size_t kFilesSize    = 256;
+    constexpr std::size_t kFileLength   = 1 << 18;
+    std::string_view rare_words[] = {"ERROR", "FATAL", "Timeout"};
+    const std::filesystem::path files_directory =
+        std::filesystem::temp_directory_path() / "actrie_uring_benchmark";
+    std::filesystem::create_directories(files_directory);
+    std::vector<std::filesystem::path> paths;
+    for (std::size_t i = 0; i < kFilesSize; i++) {
+        paths.push_back(files_directory / (std::to_string(i) + ".log"));
+        std::ofstream(paths.back(), std::ios::binary) << GenerateLogText(
+            kFileLength, rare_words, std::size(rare_words), 100);
+    }
+    BenchmarkResult result{
+        .measurements  = {},
+        .patterns_size = kPatternsSize,
+        .text_size     = kFilesSize * kFileLength,
+    };
+    ACTrie actrie;
+    AddPatterns(actrie, GenerateKeywords(kPatternsSize, 4, 12, 41));
+    for (std::string_view rare_word : rare_words) {
+        actrie.AddPattern(rare_word);
+    }
+    actrie.BuildACTrie();
+    std::size_t found_occurances_size = 0;
+    auto count_occurance = [&found_occurances_size](
+                               const ACTrie::FoundSubstringInfo&) noexcept {
+        found_occurances_size++;
+    };
+
+    // Scanner waits for each blocking read
+    Timer timer;
+    std::string contents;
+    for (const std::filesystem::path& path : paths) {
+        contents.resize(std::filesystem::file_size(path));
+        std::FILE* file = std::fopen(path.string().c_str(), "rb");
+        contents.resize(
+            std::fread(contents.data(), 1, contents.size(), file));
+        std::fclose(file);
+        actrie.FindAllSubstringsInText(contents, count_occurance);
+    }
+    result.measurements.emplace_back(
+        "read each file, then scan",
+        ScanMeasurement{
+            .found_occurances_size = found_occurances_size,
+            .time_passed_millis    = timer.TimePassed(),
+        });
+
+    found_occurances_size = 0;
+    timer.GetAndResetTime();
+    for (const std::filesystem::path& path : paths) {
+        const MappedFile file(path);
+        actrie.FindAllSubstringsInText(file.Contents(), count_occurance);
+    }
+    result.measurements.emplace_back(
+        "mmap each file, then scan",
+        ScanMeasurement{
+            .found_occurances_size = found_occurances_size,
+            .time_passed_millis    = timer.TimePassed(),
+        });
+
+    if (!UringFileScanner::IsSupported()) {
+        std::cout << "io_uring is not supported\n";
+        std::filesystem::remove_all(files_directory);
+        return result;
+    }
+    class CountingSink final : public UringFileScanner::DocumentSink {
+    public:
+        void OnFoundSubstrings(
+            std::span<const ACTrie::FoundSubstringInfo> infos) override {
+            occurances_count += infos.size();
+        }
+        void OnDocumentScanned(std::error_code) override {}
+
+        std::size_t occurances_count = 0;
+    };
+    for (const bool direct_io : {false, true}) {
+        for (const std::size_t queue_depth : {1U, 8U, 32U}) {
+            CountingSink sink;
+            std::vector<UringFileScanner::File> files;
+            for (const std::filesystem::path& path : paths) {
+                files.push_back({.path = path, .sink = &sink});
+            }
+            UringFileScanner scanner(actrie, 1);
+            scanner.SetQueueDepth(queue_depth)
+                .SetBufferSize(kFileLength / 4)
+                .SetDirectIO(direct_io);
+            timer.GetAndResetTime();
+            scanner.Scan(files);
+            result.measurements.emplace_back(
+                std::string("io_uring") + (direct_io ? " with O_DIRECT" : "") +
+                    ", queue depth " + std::to_string(queue_depth),
+                ScanMeasurement{
+                    .found_occurances_size = sink.occurances_count,
+                    .time_passed_millis    = timer.TimePassed(),
+                });
+        }
+    }
+    std::filesystem::remove_all(files_directory);
+    return result;
+}
+
+BenchmarkResult MatchesWritersBenchmark() {
+    using ACTrieDS::BinaryMatchesWriter;
+    using ACTrieDS::NdjsonMatchesWriter;
+    constexpr std::size_t kPatternsSize = 5'000;
+    constexpr std::size_t kTextLength   = 1 << 22;
+    std::mt19937 rnd(42);
+    std::string text(kTextLength, '\0');
+    for (char& symbol : text) {
+        symbol = static_cast<char>('a' + rnd() % 26);
+    }
+    BenchmarkResult result{
+        .measurements  = {},
+        .patterns_size = kPatternsSize,
+        .text_size     = kTextLength,
+        .counter_name  = "matches written",
+    };
+    // Short patterns give about one match per symbol
+    const auto patterns = GenerateKeywords(kPatternsSize, 2, 3, 42);
+    const std::filesystem::path path =
+        std::filesystem::temp_directory_path() / "actrie_matches_benchmark";
+
+    // What had to be done before: each match is formatted by the subscriber
+    ACTrie observed_actrie;
+    AddPatterns(observed_actrie, patterns);
+    observed_actrie.BuildACTrie();
+    std::FILE* file = std::fopen(path.string().c_str(), "wb");
+    std::size_t written_matches_count = 0;
+    ACTrie::FoundSubstringObserver found_substrings_obs(
+        [&](ACTrie::FoundSubstringInfoPassBy info) {
+            std::fprintf(file, "%zu %u %zu\n", info.substring_start_index,
+                         info.word_index, info.found_substring.size());
+            written_matches_count++;
+        });
+    observed_actrie.AddSubscriber(&found_substrings_obs);
+    Timer timer;
+    observed_actrie.FindAllSubstringsInText(text);
+    std::fclose(file);
+    result.measurements.emplace_back(
+        "fprintf in the found substrings subscriber",
+        ScanMeasurement{
+            .found_occurances_size = written_matches_count,
+            .time_passed_millis    = timer.TimePassed(),
+        });
+
+    ACTrie actrie;
+    AddPatterns(actrie, patterns);
+    actrie.BuildACTrie();
+
+    auto measure_writer = [&]<class Writer>(std::string name) {
+        std::FILE* output = std::fopen(path.string().c_str(), "wb");
+        timer.GetAndResetTime();
+        Writer writer(output);
+        actrie.FindAllSubstringsInText(
+            text, [&writer](const ACTrie::FoundSubstringInfo& info) {
+                writer.Add(info);
+            });
+        writer.Finish();
+        const auto time_passed_millis = timer.TimePassed();
+        std::fclose(output);
+        result.measurements.emplace_back(
+            std::move(name),
+            ScanMeasurement{
+                .found_occurances_size = writer.WrittenMatchesCount(),
+                .time_passed_millis    = time_passed_millis,
+            });
+    };
+    measure_writer.operator()<NdjsonMatchesWriter>("NDJSON columnar blocks");
+    measure_writer.operator()<BinaryMatchesWriter>("binary columnar blocks");
+    std::filesystem::remove(path);
+    return result;
+}
+
+BenchmarkResult LinesBenchmark() {
+    using LineMatchMode                 = ACTrie::LineMatchMode;
+    constexpr std::size_t kPatternsSize = 5'000;
+    constexpr std::size_t kTextLength   = 1 << 26;
+    std::string_view rare_words[] = {"ERROR", "FATAL", "Timeout"};
+    const std::string text =
+        GenerateLogText(kTextLength, rare_words, std::size(rare_words), 100);
+    BenchmarkResult result{
+        .measurements  = {},
+        .patterns_size = kPatternsSize,
+        .text_size     = text.size(),
+    };
+    ACTrie actrie;
+    AddPatterns(actrie, GenerateKeywords(kPatternsSize, 5, 12, 43));
+    for (std::string_view rare_word : rare_words) {
+        actrie.AddPattern(rare_word);
+    }
+    // Most lines have several of these words
+    for (std::string_view frequent_word : {"user", "cache", "query"}) {
+        actrie.AddPattern(frequent_word);
+    }
+    actrie.BuildACTrie();
+
+    // What had to be done before: lines are found by the second pass
+    Timer timer;
+    std::vector<std::size_t> starts;
+    actrie.FindAllSubstringsInText(
+        text, [&starts](const ACTrie::FoundSubstringInfo& info) {
+            starts.push_back(info.substring_start_index);
+        });
+    std::size_t lines_sum = 0;
+    for (std::size_t i = 0, line_index = 0; std::size_t start : starts) {
+        for (; i < start; i++) {
+            line_index += text[i] == '\n';
+        }
+        lines_sum += line_index;
+    }
+    result.measurements.emplace_back(
+        "scan, then count the lines (" + std::to_string(lines_sum) + ")",
+        ScanMeasurement{
+            .found_occurances_size = starts.size(),
+            .time_passed_millis    = timer.TimePassed(),
+        });
+
+    for (LineMatchMode mode : {LineMatchMode::kAllSubstrings,
+                               LineMatchMode::kFirstSubstringOfLine}) {
+        timer.GetAndResetTime();
+        std::size_t found_occurances_size = 0;
+        lines_sum                         = 0;
+        actrie.FindSubstringsInLines(
+            text, mode, [&](const ACTrie::FoundInLineInfo& info) {
+                found_occurances_size++;
+                lines_sum += info.line_index;
+            });
+        result.measurements.emplace_back(
+            std::string(mode == LineMatchMode::kAllSubstrings
+                            ? "lines during the scan"
+                            : "first substring of each line") +
+                " (" + std::to_string(lines_sum) + ")",
+            ScanMeasurement{
+                .found_occurances_size = found_occurances_size,
+                .time_passed_millis    = timer.TimePassed(),
+            });
+    }
+    return result;
+}
+
+BenchmarkResult MatchRangeBenchmark() {
+    using ACTrieDS::MatchRange;
+    constexpr std::size_t kPatternsSize = 5'000;
+    constexpr std::size_t kTextLength   = 1 << 26;
+    constexpr std::size_t kTakenSize    = 10;
+    std::string_view rare_words[] = {"ERROR", "FATAL", "Timeout"};
+    const std::string text =
+        GenerateLogText(kTextLength, rare_words, std::size(rare_words), 100);
+    BenchmarkResult result{
+        .measurements  = {},
+        .patterns_size = kPatternsSize,
+        .text_size     = text.size(),
+    };
+    ACTrie actrie;
+    AddPatterns(actrie, GenerateKeywords(kPatternsSize, 5, 12, 44));
+    for (std::string_view rare_word : rare_words) {
+        actrie.AddPattern(rare_word);
+    }
+    actrie.BuildACTrie();
+
+    // What had to be done before: all substrings are collected by the
+    //  callback and the first ones are taken from the buffer
+    Timer timer;
+    std::vector<ACTrie::FoundSubstringInfo> infos;
+    actrie.FindAllSubstringsInText(
+        text, [&infos](const ACTrie::FoundSubstringInfo& info) {
+            infos.push_back(info);
+        });
+    auto is_fatal = [](const ACTrie::FoundSubstringInfo& info) {
+        return info.found_substring == "FATAL";
+    };
+    result.measurements.emplace_back(
+        "collect all, take the first " + std::to_string(kTakenSize) +
+            " FATAL",
+        ScanMeasurement{
+            .found_occurances_size = std::size_t(std::ranges::distance(
+                infos | std::views::filter(is_fatal) |
+                std::views::take(kTakenSize))),
+            .time_passed_millis    = timer.TimePassed(),
+        });
+
+    timer.GetAndResetTime();
+    const auto pulled_size = std::ranges::distance(MatchRange(actrie, text));
+    result.measurements.emplace_back(
+        "pull all",
+        ScanMeasurement{
+            .found_occurances_size = std::size_t(pulled_size),
+            .time_passed_millis    = timer.TimePassed(),
+        });
+
+    // Only the text up to the wanted substrings is scanned
+    timer.GetAndResetTime();
+    MatchRange range(actrie, text);
+    const auto taken_size = std::ranges::distance(
+        std::ranges::ref_view(range) | std::views::filter(is_fatal) |
+        std::views::take(kTakenSize));
+    result.measurements.emplace_back(
+        "pull the first " + std::to_string(kTakenSize) + " FATAL (" +
+            std::to_string(range.Cursor().position) + " symbols scanned)",
+        ScanMeasurement{
+            .found_occurances_size = std::size_t(taken_size),
+            .time_passed_millis    = timer.TimePassed(),
+        });
+    return result;
+}
+
+BenchmarkResult StreamSchedulerBenchmark() {
+    using ACTrieDS::MemoryStreamSource;
+    using ACTrieDS::ScanPipeline;
+    using ACTrieDS::ScanTask;
+    using ACTrieDS::StreamScheduler;
+    using ACTrieDS::StreamSource;
+    constexpr std::size_t kPatternsSize = 5'000;
+    constexpr std::size_t kStreamsSize  = 2'000;
+    constexpr std::size_t kStreamLength = 1 << 15;
+    // Like the packets of the captured connections
+    constexpr std::size_t kReadSize = 1500;
+    std::string_view rare_words[]   = {"ERROR", "FATAL", "Timeout"};
+    const std::string text          = GenerateLogText(
+        kStreamsSize * kStreamLength, rare_words, std::size(rare_words), 100);
+    BenchmarkResult result{
+        .measurements  = {},
+        .patterns_size = kPatternsSize,
+        .text_size     = text.size(),
+    };
+    ACTrie actrie;
+    AddPatterns(actrie, GenerateKeywords(kPatternsSize, 5, 12, 45));
+    for (std::string_view rare_word : rare_words) {
+        actrie.AddPattern(rare_word);
+    }
+    actrie.BuildACTrie();
+
+    class CountingSink final : public ScanPipeline::MatchesSink {
+    public:
+        void OnMatches(const ScanPipeline::MatchesBatch& batch) override {
+            matches_count.fetch_add(batch.matches.size(),
+                                    std::memory_order_relaxed);
+        }
+
+        std::atomic<std::size_t> matches_count{0};
+    };
+    auto make_sources = [&]() {
+        std::vector<MemoryStreamSource> sources;
+        for (std::size_t i = 0; i < kStreamsSize; i++) {
+            sources.emplace_back(
+                std::string_view(text).substr(i * kStreamLength, kStreamLength),
+                kReadSize);
+        }
+        return sources;
+    };
+
+    // What had to be done before: a thread per stream
+    std::vector<MemoryStreamSource> sources = make_sources();
+    CountingSink sink;
+    Timer timer;
+    {
+        std::vector<std::jthread> threads;
+        for (std::size_t i = 0; i < kStreamsSize; i++) {
+            threads.emplace_back([&, i]() {
+                ScanTask task = ACTrieDS::ScanStream(
+                    actrie, sources[i], i, StreamScheduler::kDefaultBufferSize,
+                    StreamScheduler::kDefaultBatchCapacity);
+                while (true) {
+                    const ScanTask::State state = task.Resume();
+                    if (state == ScanTask::State::kDone) {
+                        break;
+                    }
+                    if (state == ScanTask::State::kYieldedBatch) {
+                        sink.OnMatches(task.YieldedBatch());
+                    }
+                }
+            });
+        }
+    }
+    result.measurements.emplace_back(
+        "thread per stream",
+        ScanMeasurement{
+            .found_occurances_size = sink.matches_count.load(),
+            .time_passed_millis    = timer.TimePassed(),
+        });
+
+    sources = make_sources();
+    std::vector<StreamSource*> sources_pointers;
+    for (MemoryStreamSource& source : sources) {
+        sources_pointers.push_back(&source);
+    }
+    CountingSink scheduler_sink;
+    timer.GetAndResetTime();
+    StreamScheduler(actrie).Run(sources_pointers, scheduler_sink);
+    result.measurements.emplace_back(
+        "stream scheduler",
+        ScanMeasurement{
+            .found_occurances_size = scheduler_sink.matches_count.load(),
+            .time_passed_millis    = timer.TimePassed(),
+        });
+    return result;
+}
+
+BenchmarkResult BudgetedScanBenchmark() {
+    constexpr std::size_t kPatternsSize = 5'000;
+    constexpr std::size_t kTextLength   = 1 << 26;
+    std::string_view rare_words[]       = {"ERROR", "FATAL", "Timeout"};
+    const std::string text =
+        GenerateLogText(kTextLength, rare_words, std::size(rare_words), 100);
+    BenchmarkResult result{
+        .measurements  = {},
+        .patterns_size = kPatternsSize,
+        .text_size     = text.size(),
+    };
+    ACTrie actrie;
+    AddPatterns(actrie, GenerateKeywords(kPatternsSize, 5, 12, 44));
+    for (std::string_view rare_word : rare_words) {
+        actrie.AddPattern(rare_word);
+    }
+    actrie.BuildACTrie();
+
+    Timer timer;
+    std::size_t found_occurances_size = 0;
+    auto count_substring = [&found_occurances_size](
+                               const ACTrie::FoundSubstringInfo&) {
+        found_occurances_size++;
+    };
+    actrie.FindAllSubstringsInText(text, count_substring);
+    result.measurements.emplace_back(
+        "one call",
+        ScanMeasurement{
+            .found_occurances_size = found_occurances_size,
+            .time_passed_millis    = timer.TimePassed(),
+        });
+
+    // Like the scan interleaved with the frames of an event loop
+    constexpr ACTrie::ScanBudget kBudgets[] = {
+        {.max_symbols_count = 1 << 12, .max_found_substrings_count = 1 << 8},
+        {.max_symbols_count = 1 << 16, .max_found_substrings_count = 1 << 12},
+    };
+    for (const ACTrie::ScanBudget& budget : kBudgets) {
+        timer.GetAndResetTime();
+        found_occurances_size   = 0;
+        std::size_t calls_count = 0;
+        ACTrie::ScanCursor cursor;
+        bool finished = false;
+        while (!finished) {
+            calls_count++;
+            finished = actrie.FindAllSubstringsInText(
+                text, ACTrie::kAllGroups, cursor, budget, count_substring);
+        }
+        result.measurements.emplace_back(
+            "budget of " + std::to_string(budget.max_symbols_count) +
+                " symbols and " +
+                std::to_string(budget.max_found_substrings_count) +
+                " substrings (" + std::to_string(calls_count) + " calls)",
+            ScanMeasurement{
+                .found_occurances_size = found_occurances_size,
+                .time_passed_millis    = timer.TimePassed(),
+            });
+    }
+    return result;
+}
+
+BenchmarkResult WildcardsBenchmark() {
+    using ACTrieDS::WildcardMatcher;
+    constexpr std::size_t kPatternsSize = 2'000;
+    constexpr std::size_t kTextLength   = 1 << 24;
+    constexpr std::string_view kLetters =
+        "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz";
+    std::string_view rare_words[] = {"ERROR", "FATAL", "Timeout"};
+    const std::string text =
+        GenerateLogText(kTextLength, rare_words, std::size(rare_words), 100);
+    // Signatures with one don't care position each
+    std::mt19937 rnd(47);
+    std::vector<std::string> patterns =
+        GenerateKeywords(kPatternsSize, 5, 12, 47);
+    for (std::string_view rare_word : rare_words) {
+        patterns.emplace_back(rare_word);
+    }
+    for (std::string& pattern : patterns) {
+        pattern[1 + rnd() % (pattern.size() - 1)] = WildcardMatcher::kAnySymbol;
+    }
+    BenchmarkResult result{
+        .measurements  = {},
+        .patterns_size = patterns.size(),
+        .text_size     = text.size(),
+    };
+
+    Timer timer;
+    WildcardMatcher matcher;
+    AddPatterns(matcher, patterns);
+    matcher.BuildWildcardMatcher();
+    result.measurements.emplace_back(
+        "wildcards, build (" + std::to_string(matcher.FragmentsSize()) +
+            " fragments)",
+        ScanMeasurement{
+            .found_occurances_size = 0,
+            .time_passed_millis    = timer.TimePassed(),
+        });
+    std::size_t found_occurances_size = 0;
+    WildcardMatcher::FoundSubstringObserver found_substrings_obs(
+        [&found_occurances_size](ACTrie::FoundSubstringInfoPassBy) {
+            found_occurances_size++;
+        });
+    matcher.AddSubscriber(&found_substrings_obs);
+    timer.GetAndResetTime();
+    matcher.FindAllSubstringsInText(text);
+    result.measurements.emplace_back(
+        "wildcards, scan",
+        ScanMeasurement{
+            .found_occurances_size = found_occurances_size,
+            .time_passed_millis    = timer.TimePassed(),
+        });
+
+    // What had to be done before: each wildcard is replaced by each letter
+    //  (the symbols outside the alphabet can not be added at all)
+    timer.GetAndResetTime();
+    ACTrie actrie;
+    for (const std::string& pattern : patterns) {
+        std::string variant = pattern;
+        const std::size_t wildcard_index =
+            pattern.find(WildcardMatcher::kAnySymbol);
+        for (char letter : kLetters) {
+            variant[wildcard_index] = letter;
+            actrie.AddPattern(variant);
+        }
+    }
+    actrie.BuildACTrie();
+    result.measurements.emplace_back(
+        "expanded into " + std::to_string(actrie.PatternsSize()) +
+            " patterns, build (" + std::to_string(actrie.NodesSize()) +
+            " nodes)",
+        ScanMeasurement{
+            .found_occurances_size = 0,
+            .time_passed_millis    = timer.TimePassed(),
+        });
+    timer.GetAndResetTime();
+    found_occurances_size = 0;
+    actrie.FindAllSubstringsInText(
+        text, [&found_occurances_size](const ACTrie::FoundSubstringInfo&) {
+            found_occurances_size++;
+        });
+    result.measurements.emplace_back(
+        "expanded, scan",
+        ScanMeasurement{
+            .found_occurances_size = found_occurances_size,
+            .time_passed_millis    = timer.TimePassed(),
+        });
+    return result;
+}
+
+BenchmarkResult ClassPatternsBenchmark() {
+    using ACTrieDS::ClassPatternMatcher;
+    constexpr std::size_t kPatternsSize = 2'000;
+    constexpr std::size_t kTextLength   = 1 << 22;
+    std::string_view rare_words[]       = {"ERROR", "FATAL", "Timeout"};
+    const std::string text =
+        GenerateLogText(kTextLength, rare_words, std::size(rare_words), 100);
+    constexpr std::string_view kClassPatterns[] = {
+        "latency=[0-9][0-9][0-9] ", "12:5[0-9] ",   "user [0-9] ",
+        "[EF][RA][RT][OA][RL]",     "miss=[0-9]\\ ", "[Tt]imeout",
+    };
+    const std::vector<std::string> keywords =
+        GenerateKeywords(kPatternsSize, 5, 12, 48);
+    BenchmarkResult result{
+        .measurements  = {},
+        .patterns_size = keywords.size() + std::size(kClassPatterns),
+        .text_size     = text.size(),
+    };
+
+    ACTrie actrie;
+    AddPatterns(actrie, keywords);
+    actrie.BuildACTrie();
+    result.measurements.emplace_back("ACTrie, keywords only",
+                                     MeasureScan(actrie, text));
+
+    ClassPatternMatcher matcher;
+    AddPatterns(matcher, keywords);
+    for (std::string_view class_pattern : kClassPatterns) {
+        matcher.AddPattern(class_pattern);
+    }
+    Timer timer;
+    matcher.BuildClassPatternMatcher();
+    result.measurements.emplace_back(
+        "classes, build (" + std::to_string(matcher.StatesSize()) +
+            " states, " + std::to_string(matcher.SymbolsClassesSize()) +
+            " symbols classes)",
+        ScanMeasurement{
+            .found_occurances_size = 0,
+            .time_passed_millis    = timer.TimePassed(),
+        });
+    result.measurements.emplace_back(
+        "classes, keywords and classes in one pass",
+        MeasureScan(matcher, text));
+
+    // What had to be done before: a separate regex pass for the classes
+    std::string alternation;
+    for (std::string_view class_pattern : kClassPatterns) {
+        alternation += alternation.empty() ? "" : "|";
+        alternation += class_pattern;
+    }
+    const std::regex regex(alternation);
+    timer.GetAndResetTime();
+    const auto regex_matches_size = std::distance(
+        std::sregex_iterator(text.begin(), text.end(), regex),
+        std::sregex_iterator());
+    result.measurements.emplace_back(
+        "std::regex, second pass for the classes",
+        ScanMeasurement{
+            .found_occurances_size = std::size_t(regex_matches_size),
+            .time_passed_millis    = timer.TimePassed(),
+        });
+    return result;
+}
+
+BenchmarkResult ApproximateBenchmark() {
+    using ACTrieDS::ApproximateMatcher;
+    constexpr std::size_t kPatternsSize = 500;
+    constexpr std::size_t kTextLength   = 1 << 22;
+    constexpr std::string_view kLetters =
+        "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz";
+    // Markers with the recognition errors, the exact ones are not in the text
+    std::string_view rare_words[] = {"ERRDR", "FATAI", "Timeovt"};
+    const std::string text =
+        GenerateLogText(kTextLength, rare_words, std::size(rare_words), 100);
+    std::vector<std::string> patterns =
+        GenerateKeywords(kPatternsSize, 6, 12, 49);
+    for (std::string_view marker : {"ERROR", "FATAL", "Timeout"}) {
+        patterns.emplace_back(marker);
+    }
+    BenchmarkResult result{
+        .measurements  = {},
+        .patterns_size = patterns.size(),
+        .text_size     = text.size(),
+    };
+
+    constexpr std::size_t kMaxMismatches[] = {1, 2};
+    for (std::size_t max_mismatches : kMaxMismatches) {
+        const std::string name =
+            "at most " + std::to_string(max_mismatches) + " mismatches";
+        Timer timer;
+        ApproximateMatcher matcher(max_mismatches);
+        AddPatterns(matcher, patterns);
+        matcher.BuildApproximateMatcher();
+        result.measurements.emplace_back(
+            name + ", build (" + std::to_string(matcher.FragmentsSize()) +
+                " fragments)",
+            ScanMeasurement{
+                .found_occurances_size = 0,
+                .time_passed_millis    = timer.TimePassed(),
+            });
+        result.measurements.emplace_back(name + ", scan",
+                                         MeasureScan(matcher, text));
+    }
+
+    // What had to be done before: each position of each pattern is replaced
+    //  by each letter, only for 1 mismatch
+    Timer timer;
+    ACTrie actrie;
+    for (const std::string& pattern : patterns) {
+        actrie.AddPattern(pattern);
+        std::string variant = pattern;
+        for (std::size_t i = 0; i < pattern.size(); i++) {
+            for (char letter : kLetters) {
+                if (letter != pattern[i]) {
+                    variant[i] = letter;
+                    actrie.AddPattern(variant);
+                }
+            }
+            variant[i] = pattern[i];
+        }
+    }
+    actrie.BuildACTrie();
+    result.measurements.emplace_back(
+        "1 mismatch expanded into " + std::to_string(actrie.PatternsSize()) +
+            " patterns, build (" + std::to_string(actrie.NodesSize()) +
+            " nodes)",
+        ScanMeasurement{
+            .found_occurances_size = 0,
+            .time_passed_millis    = timer.TimePassed(),
+        });
+    result.measurements.emplace_back("1 mismatch expanded, scan",
+                                     MeasureScan(actrie, text));
+    return result;
+}
+
+/// @brief Generates text that looks like a multilingual chat log: words of
+///         the vocabulary in the Latin, Cyrillic, Greek and CJK scripts,
+///         some of them capitalized or in the upper case.
+std::string GenerateChatText(std::size_t text_length,
+                             const std::vector<std::string>& vocabulary,
+                             std::uint32_t seed) {
+    namespace Utf8 = ACTrieDS::Utf8;
+    auto to_upper = [](char32_t code_point) {
+        const bool has_upper_case =
+            (code_point >= U'a' && code_point <= U'z') ||
+            (code_point >= 0x430 && code_point <= 0x44F) ||
+            (code_point >= 0x3B1 && code_point <= 0x3C9 &&
+             code_point != 0x3C2);
+        return has_upper_case ? code_point - 0x20 : code_point;
+    };
+
+    std::mt19937 rnd(seed);
+    std::string text;
+    text.reserve(text_length + 64);
+    while (text.size() < text_length) {
+        const std::string& word = vocabulary[rnd() % vocabulary.size()];
+        const std::size_t upper_case_size =
+            rnd() % 4 == 0 ? 1 : (rnd() % 20 == 0 ? word.size() : 0);
+        for (std::size_t i = 0, j = 0; i < word.size(); j++) {
+            const auto [code_point, length] = Utf8::DecodeCodePoint(word, i);
+            Utf8::AppendCodePoint(
+                text, j < upper_case_size ? to_upper(code_point) : code_point);
+            i += length;
+        }
+        text += rnd() % 10 == 0 ? "\n" : (rnd() % 5 == 0 ? ", " : " ");
+    }
+    text.resize(text_length);
+    return text;
+}
+
+BenchmarkResult Utf8ChatBenchmark() {
+    using ACTrieDS::Utf8Matcher;
+    namespace Utf8                      = ACTrieDS::Utf8;
+    constexpr std::size_t kPatternsSize = 2'000;
+    constexpr std::size_t kTextLength   = 1 << 24;
+    // First letters and sizes of the lower case alphabets of the scripts
+    constexpr std::pair<char32_t, std::size_t> kAlphabets[] = {
+        {U'a', 26}, {0x430, 32}, {0x3B1, 17}, {0x4E00, 3000}};
+    std::mt19937 rnd(50);
+    std::vector<std::string> vocabulary(10'000);
+    for (std::string& word : vocabulary) {
+        const auto [first_letter, alphabet_size] =
+            kAlphabets[rnd() % std::size(kAlphabets)];
+        const std::size_t length = 2 + rnd() % 7;
+        for (std::size_t i = 0; i < length; i++) {
+            Utf8::AppendCodePoint(
+                word, first_letter + char32_t(rnd() % alphabet_size));
+        }
+    }
+    const std::vector<std::string> patterns(
+        vocabulary.begin(), vocabulary.begin() + kPatternsSize);
+    const std::string chat_text = GenerateChatText(kTextLength, vocabulary, 50);
+    std::string_view rare_words[] = {"ERROR", "FATAL", "Timeout"};
+    const std::string log_text =
+        GenerateLogText(kTextLength, rare_words, std::size(rare_words), 100);
+    const std::vector<std::string> keywords =
+        GenerateKeywords(kPatternsSize, 5, 12, 50);
+    BenchmarkResult result{
+        .measurements  = {},
+        .patterns_size = kPatternsSize,
+        .text_size     = kTextLength,
+    };
+
+    // Throughput on the ASCII text must not be lost
+    ACTrie actrie;
+    AddPatterns(actrie, keywords);
+    actrie.BuildACTrie();
+    result.measurements.emplace_back("ACTrie, ASCII log",
+                                     MeasureScan(actrie, log_text));
+    Utf8Matcher ascii_matcher;
+    AddPatterns(ascii_matcher, keywords);
+    ascii_matcher.BuildUtf8Matcher();
+    result.measurements.emplace_back("utf-8, ASCII log",
+                                     MeasureScan(ascii_matcher, log_text));
+
+    for (bool fold_case : {false, true}) {
+        const std::string name =
+            fold_case ? "utf-8 with case folding" : "utf-8";
+        Timer timer;
+        Utf8Matcher matcher(fold_case);
+        AddPatterns(matcher, patterns);
+        matcher.BuildUtf8Matcher();
+        result.measurements.emplace_back(
+            name + ", build (" + std::to_string(matcher.NodesSize()) +
+                " nodes, " + std::to_string(matcher.SymbolsClassesSize()) +
+                " symbols classes)",
+            ScanMeasurement{
+                .found_occurances_size = 0,
+                .time_passed_millis    = timer.TimePassed(),
+            });
+        result.measurements.emplace_back(name + ", chat log",
+                                         MeasureScan(matcher, chat_text));
+    }
+
+    // Folding of the text instead: the matcher of the folded patterns is
+    //  given the text folded code point by code point
+    Utf8Matcher folded_matcher;
+    for (const std::string& pattern : patterns) {
+        std::string folded_pattern;
+        for (std::size_t i = 0; i < pattern.size();) {
+            const auto [code_point, length] = Utf8::DecodeCodePoint(pattern, i);
+            Utf8::AppendCodePoint(folded_pattern,
+                                  Utf8::SimpleCaseFold(code_point));
+            i += length;
+        }
+        folded_matcher.AddPattern(folded_pattern);
+    }
+    folded_matcher.BuildUtf8Matcher();
+    Timer timer;
+    std::string folded_text;
+    folded_text.reserve(chat_text.size());
+    for (std::size_t i = 0; i < chat_text.size();) {
+        const auto [code_point, length] = Utf8::DecodeCodePoint(chat_text, i);
+        if (length == 0) {
+            folded_text.push_back(chat_text[i++]);
+            continue;
+        }
+        Utf8::AppendCodePoint(folded_text, Utf8::SimpleCaseFold(code_point));
+        i += length;
+    }
+    const auto folding_time = timer.TimePassed();
+    ScanMeasurement folded_scan = MeasureScan(folded_matcher, folded_text);
+    folded_scan.time_passed_millis += folding_time;
+    result.measurements.emplace_back("utf-8, folded text, chat log",
+                                     folded_scan);
+    return result;
+}
+
+void RunBenchmarkWrapper(std::function<BenchmarkResult()> benchmark_function,
+                         std::string_view benchmark_name) noexcept {
+    try {
+        std::cout << "----------------------------------------------------"
+                     "------------\n"
+                  << "Running benchmark " << benchmark_name << '\n';
+        const BenchmarkResult result = benchmark_function();
+        std::cout << "Number of added patterns: " << result.patterns_size
+                  << '\n'
+                  << "Length of the text to search patterns in: "
+                  << result.text_size << " symbols\n";
+        for (const auto& [name, measurement] : result.measurements) {
+            const auto millis = measurement.time_passed_millis.count();
+            std::cout << name << ": " << millis << "ms, "
+                      << measurement.found_occurances_size << ' '
+                      << result.counter_name;
+            if (millis > 0) {
+                std::cout << ", "
+                          << result.text_size / std::size_t(millis) / 1000
+                          << " MB/s";
+            }
+            std::cout << '\n';
+        }
+        std::cout << "----------------------------------------------------"
+                     "------------\n";
+    } catch (const std::exception& ex) {
+        std::cerr << "Benchmark " << benchmark_name
+                  << " failed with exception: " << ex.what() << '\n';
+    } catch (...) {
+        std::cerr << "Benchmark " << benchmark_name
+                  << " failed with unknown exception\n";
+    }
+}
+
+}  // namespace
+
+void RunBenchmarks() noexcept {
+    RunBenchmarkWrapper(SparseLogPrefilterBenchmark, "sparse log prefilter");
+    RunBenchmarkWrapper(SmallSetTeddyBenchmark, "small patterns sets");
+    RunBenchmarkWrapper(ShortPatternsShiftAndBenchmark, "short patterns");
+    RunBenchmarkWrapper(LongPatternsWuManberBenchmark, "long patterns");
+    RunBenchmarkWrapper(EngineSelectionBenchmark, "engine selection");
+    RunBenchmarkWrapper(ParallelBuildBenchmark, "parallel build");
+    RunBenchmarkWrapper(HugePagesBenchmark, "huge pages");
+    RunBenchmarkWrapper(ScoringBenchmark, "weighted scoring");
+    RunBenchmarkWrapper(OccurancesHistogramBenchmark, "occurances histogram");
+    RunBenchmarkWrapper(ScanPipelineBenchmark, "scan pipeline");
+    RunBenchmarkWrapper(UringFilesBenchmark, "io_uring files");
+    RunBenchmarkWrapper(MatchesWritersBenchmark, "matches writers");
+    RunBenchmarkWrapper(LinesBenchmark, "line numbers");
+    RunBenchmarkWrapper(MatchRangeBenchmark, "pulled substrings");
+    RunBenchmarkWrapper(StreamSchedulerBenchmark, "stream scheduler");
+    RunBenchmarkWrapper(BudgetedScanBenchmark, "budgeted scan");
+    RunBenchmarkWrapper(WildcardsBenchmark, "wildcards");
+    RunBenchmarkWrapper(ClassPatternsBenchmark, "class patterns");
+    RunBenchmarkWrapper(ApproximateBenchmark, "approximate matching");
+    RunBenchmarkWrapper(Utf8ChatBenchmark, "utf-8 chat logs");
+}
+
+}  // namespace AppSpace
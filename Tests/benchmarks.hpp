@@ -0,0 +1,5 @@
+#pragma once
+
+namespace AppSpace {
+void RunBenchmarks() noexcept;
+}
@@ -0,0 +1,5 @@
+#include "benchmarks.hpp"
+
+int main() {
+    AppSpace::RunBenchmarks();
+}
@@ -1,10 +1,52 @@
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <cstddef>
 #include <cstdint>
+#include <cstdio>
 #include <exception>
+#include <filesystem>
+#include <fstream>
 #include <functional>
 #include <iostream>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <ranges>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 
 #include "../App/ACTrie.hpp"
+#include "../App/ApproximateMatcher.hpp"
+#include "../App/AutoMatcher.hpp"
+#include "../App/ClassPatternMatcher.hpp"
+#include "../App/CorpusScanner.hpp"
+#include "../App/HugePagesMemoryResource.hpp"
+#include "../App/LineTracker.hpp"
+#include "../App/MatchRange.hpp"
+#include "../App/MatchesWriter.hpp"
 #include "../App/Observer.hpp"
+#include "../App/OccurancesHistogram.hpp"
+#include "../App/ScanPipeline.hpp"
+#include "../App/ShiftAndMatcher.hpp"
+#include "../App/StreamScheduler.hpp"
+#include "../App/TeddyMatcher.hpp"
+#include "../App/UringFileScanner.hpp"
+#include "../App/Utf8.hpp"
+#include "../App/Utf8Matcher.hpp"
+#include "../App/VersionedACTrie.hpp"
+#include "../App/WildcardMatcher.hpp"
+#include "../App/WuManberMatcher.hpp"
 #include "Timer.hpp"
 
 namespace AppSpace {
@@ -194,6 +236,2283 @@ TestResult Test4Impl() {
     };
 }
 
+TestResult Test5Impl() {
+    constexpr std::string_view patterns[] = {"xyz", "xy", "yzx", "zz",
+                                             "yyyy"};
+    constexpr std::size_t kTextLength     = 1e6;
+    constexpr std::size_t kIters          = 5e3;
+    std::string text(kTextLength, 'a');
+    for (std::size_t i = 0; i < kIters; i++) {
+        constexpr std::size_t kScale = kTextLength / kIters;
+        std::size_t index            = i * kScale + i % 7;
+        text[index]                  = static_cast<char>('x' + i % 3);
+        text[index + 1]              = static_cast<char>('x' + i % 5 % 3);
+        text[index + 2]              = i % 11 == 0 ? '#' : 'y';
+        text[index + 3]              = static_cast<char>('x' + i % 2);
+    }
+
+    using Occurance = std::tuple<std::string_view, std::size_t,
+                                 ACTrie::VertexIndex>;
+    auto find_occurances = [&](bool prefilter_enabled) {
+        ACTrie actrie;
+        for (std::string_view pattern : patterns) {
+            actrie.AddPattern(pattern);
+        }
+        actrie.SetPrefilterEnabled(prefilter_enabled);
+        std::vector<Occurance> occurances;
+        ACTrie::FoundSubstringObserver found_substrings_obs(
+            [&occurances](ACTrie::FoundSubstringInfoPassBy info) {
+                occurances.emplace_back(info.found_substring,
+                                        info.substring_start_index,
+                                        info.current_vertex_index);
+            });
+        actrie.AddSubscriber(&found_substrings_obs);
+        actrie.FindAllSubstringsInText(text);
+        return std::pair{std::move(occurances), actrie.IsPrefilterActive()};
+    };
+
+    const auto [expected_occurances, expected_prefilter_active] =
+        find_occurances(false);
+    Timer timer;
+    const auto [found_occurances, prefilter_active] = find_occurances(true);
+    auto time_passed_millis                         = timer.TimePassed();
+    const bool passed = !expected_prefilter_active && prefilter_active &&
+                        found_occurances == expected_occurances;
+    return {
+        .status = passed ? TestStatus::kPassed : TestStatus::kNotPassed,
+        .found_occurances_size    = found_occurances.size(),
+        .expected_occurances_size = expected_occurances.size(),
+        .patterns_size            = std::size(patterns),
+        .text_size                = text.size(),
+        .time_passed_millis       = time_passed_millis,
+    };
+}
+
+using Occurance =
+    std::tuple<std::string_view, std::size_t, ACTrie::WordLength>;
+
+template <class Matcher>
+std::vector<Occurance> FindOccurances(
+    Matcher& matcher, const std::vector<std::string>& patterns,
+    std::string_view text) {
+    for (std::string_view pattern : patterns) {
+        matcher.AddPattern(pattern);
+    }
+    std::vector<Occurance> occurances;
+    typename Matcher::FoundSubstringObserver found_substrings_obs(
+        [&occurances](ACTrie::FoundSubstringInfoPassBy info) {
+            occurances.emplace_back(info.found_substring,
+                                    info.substring_start_index,
+                                    info.word_index);
+        });
+    matcher.AddSubscriber(&found_substrings_obs);
+    matcher.FindAllSubstringsInText(text);
+    return occurances;
+}
+
+std::string GenerateRandomString(std::size_t length, std::string_view symbols,
+                                 std::mt19937& rnd) {
+    std::string str(length, '\0');
+    for (char& c : str) {
+        c = symbols[rnd() % symbols.size()];
+    }
+    return str;
+}
+
+// Symbols of the random texts, the last one is never used in the random
+//  patterns
+constexpr std::string_view kRandomTextSymbols = "abcdXYZ.";
+
+/// @brief Generates patterns_size random patterns of 1 to max_pattern_length
+///         symbols of the kRandomTextSymbols except the last one.
+std::vector<std::string> GenerateRandomPatterns(std::size_t patterns_size,
+                                                std::size_t max_pattern_length,
+                                                std::mt19937& rnd) {
+    constexpr std::string_view kPatternsSymbols =
+        kRandomTextSymbols.substr(0, kRandomTextSymbols.size() - 1);
+    std::vector<std::string> patterns;
+    patterns.reserve(patterns_size);
+    for (std::size_t i = 0; i < patterns_size; i++) {
+        patterns.push_back(GenerateRandomString(1 + rnd() % max_pattern_length,
+                                                kPatternsSymbols, rnd));
+    }
+    return patterns;
+}
+
+/// @brief Checks that the found occurances are reported in the order of the
+///         ACTrie (by the end position, longer first) and are the expected
+///         ones. Order of the substrings of the same length ending at the
+///         same position is not checked.
+bool AreSameOccurancesInACTrieOrder(
+    std::vector<Occurance> found_occurances,
+    std::vector<Occurance> expected_occurances) {
+    auto end_and_length = [](const Occurance& occurance) {
+        const auto& [substring, start, _] = occurance;
+        return std::pair(start + substring.size(),
+                         std::numeric_limits<std::size_t>::max() -
+                             substring.size());
+    };
+    if (!std::ranges::is_sorted(found_occurances, std::less{},
+                                end_and_length)) {
+        return false;
+    }
+    auto reported_before = [&](const Occurance& lhs, const Occurance& rhs) {
+        return std::pair(end_and_length(lhs), std::get<2>(lhs)) <
+               std::pair(end_and_length(rhs), std::get<2>(rhs));
+    };
+    std::ranges::sort(found_occurances, reported_before);
+    std::ranges::sort(expected_occurances, reported_before);
+    return found_occurances == expected_occurances;
+}
+
+// Views of the found substrings are not valid after the call of the sink
+using OwnedOccurance =
+    std::tuple<std::string, std::size_t, ACTrie::WordLength>;
+
+/// @brief Document sink of the scanners which records the found substrings
+///         and checks that they are not reported concurrently or after the
+///         OnDocumentScanned(), which must be called once.
+template <class DocumentSink>
+class RecordingSink final : public DocumentSink {
+public:
+    void OnFoundSubstrings(
+        std::span<const ACTrie::FoundSubstringInfo> infos) override {
+        correct_ =
+            correct_ && !is_called_.exchange(true) && scanned_calls_ == 0;
+        for (const ACTrie::FoundSubstringInfo& info : infos) {
+            occurances_.emplace_back(std::string(info.found_substring),
+                                     info.substring_start_index,
+                                     info.word_index);
+        }
+        is_called_ = false;
+    }
+    void OnDocumentScanned(std::error_code error) override {
+        scanned_calls_++;
+        error_ = error;
+    }
+    bool IsCorrect(const std::vector<OwnedOccurance>& expected_occurances,
+                   bool expect_error) const {
+        return correct_ && scanned_calls_ == 1 &&
+               bool(error_) == expect_error &&
+               occurances_ == expected_occurances;
+    }
+    std::size_t OccurancesSize() const noexcept {
+        return occurances_.size();
+    }
+
+private:
+    std::vector<OwnedOccurance> occurances_;
+    std::error_code error_;
+    std::size_t scanned_calls_ = 0;
+    std::atomic<bool> is_called_{false};
+    bool correct_ = true;
+};
+
+/// @brief Runs the Matcher and the ACTrie on the random patterns and texts
+///         and checks that they report the same substrings in the same
+///         order, and that the matcher passes the check_matcher if it is set.
+///         The patterns include the empty one, which only the ACTrie reports
+///         (the AutoMatcher would choose the ACTrie for it, so it gets no
+///         empty pattern).
+template <class Matcher>
+TestResult DifferentialTestImpl(
+    std::size_t patterns_size, std::size_t min_pattern_length,
+    std::size_t max_pattern_length, std::size_t text_length,
+    std::string_view symbols,
+    const std::function<bool(const Matcher&)>& check_matcher = {}) {
+    std::mt19937 rnd(static_cast<std::uint32_t>(patterns_size * 31 +
+                                                 max_pattern_length));
+    std::vector<std::string> patterns;
+    patterns.reserve(patterns_size);
+    for (std::size_t i = 0; i < patterns_size; i++) {
+        const std::size_t length =
+            min_pattern_length +
+            rnd() % (max_pattern_length - min_pattern_length + 1);
+        // Symbols outside the alphabet are used only for the text.
+        patterns.push_back(GenerateRandomString(
+            length, symbols.substr(0, symbols.size() - 1), rnd));
+    }
+    patterns.push_back(patterns.front());
+    constexpr bool kHasEmptyPattern =
+        !std::is_same_v<Matcher, ACTrieDS::AutoMatcher>;
+    if constexpr (kHasEmptyPattern) {
+        patterns.insert(patterns.begin() + 1, "");
+    }
+    std::string text = GenerateRandomString(text_length, symbols, rnd);
+    for (std::size_t i = 0; i + max_pattern_length < text_length;
+         i += text_length / 64) {
+        const std::string& pattern = patterns[rnd() % patterns.size()];
+        text.replace(i, pattern.size(), pattern);
+    }
+
+    ACTrie actrie;
+    std::vector<Occurance> expected_occurances =
+        FindOccurances(actrie, patterns, text);
+    std::erase_if(expected_occurances, [](const Occurance& occurance) {
+        return std::get<0>(occurance).empty();
+    });
+    Matcher matcher;
+    Timer timer;
+    const auto found_occurances = FindOccurances(matcher, patterns, text);
+    auto time_passed_millis     = timer.TimePassed();
+    const bool passed = found_occurances == expected_occurances &&
+                        (!check_matcher || check_matcher(matcher));
+    return {
+        .status = passed ? TestStatus::kPassed : TestStatus::kNotPassed,
+        .found_occurances_size    = found_occurances.size(),
+        .expected_occurances_size = expected_occurances.size(),
+        .patterns_size            = patterns.size(),
+        .text_size                = text.size(),
+        .time_passed_millis       = time_passed_millis,
+    };
+}
+
+TestResult Test6Impl() {
+    return DifferentialTestImpl<ACTrieDS::TeddyMatcher>(24, 1, 9, 1e6,
+                                                        "abcdXYZ.");
+}
+
+TestResult Test7Impl() {
+    return DifferentialTestImpl<ACTrieDS::ShiftAndMatcher>(8, 1, 7, 1e6,
+                                                           "abcXYZ.");
+}
+
+TestResult Test8Impl() {
+    using ACTrieDS::ShiftAndMatcher;
+    TestResult result = DifferentialTestImpl<ShiftAndMatcher>(14, 2, 9, 1e6,
+                                                              "abcdXYZ.");
+
+    // 7 patterns of 9 symbols take 63 bits, so the last pattern crosses into
+    //  the second bit word
+    std::mt19937 rnd(8);
+    std::vector<std::string> patterns;
+    for (std::size_t i = 0; i < 7; i++) {
+        patterns.push_back(GenerateRandomString(9, "abcdXYZ", rnd));
+    }
+    patterns.emplace_back("cdXYZabc");
+    std::string text = GenerateRandomString(100000, "abcdXYZ.", rnd);
+    for (std::size_t i = 0; i + 9 < text.size(); i += 1000) {
+        const std::string& pattern = patterns[rnd() % patterns.size()];
+        text.replace(i, pattern.size(), pattern);
+    }
+    ACTrie actrie;
+    const auto expected_occurances = FindOccurances(actrie, patterns, text);
+    ShiftAndMatcher matcher;
+    const auto found_occurances = FindOccurances(matcher, patterns, text);
+    if (matcher.PatternsTotalLength() <= ShiftAndMatcher::kBitWordSize ||
+        found_occurances != expected_occurances) {
+        result.status = TestStatus::kNotPassed;
+    }
+    result.found_occurances_size += found_occurances.size();
+    result.expected_occurances_size += expected_occurances.size();
+    result.patterns_size += patterns.size();
+    result.text_size += text.size();
+    return result;
+}
+
+TestResult Test9Impl() {
+    return DifferentialTestImpl<ACTrieDS::WuManberMatcher>(300, 16, 40, 1e6,
+                                                           "abcdXYZ.");
+}
+
+TestResult Test10Impl() {
+    return DifferentialTestImpl<ACTrieDS::WuManberMatcher>(40, 2, 12, 1e6,
+                                                           "abcXYZ.");
+}
+
+TestResult Test11Impl() {
+    using ACTrieDS::AutoMatcher;
+    // Shapes of the pattern sets for which different matchers are chosen
+    struct PatternsShape final {
+        std::size_t patterns_size;
+        std::size_t min_pattern_length;
+        std::size_t max_pattern_length;
+        std::string_view symbols;
+        AutoMatcher::Engine expected_engine;
+    };
+    constexpr PatternsShape kShapes[] = {
+        // Single symbols with at most 3 distinct first symbols
+        {3, 1, 1, "abcXYZ.", AutoMatcher::Engine::kACTrieWithPrefilter},
+        {12, 2, 8, "abcdXYZ.", AutoMatcher::Engine::kTeddy},
+        // Single symbols with many distinct first symbols
+        {12, 1, 1, "abcdefghXYZ.", AutoMatcher::Engine::kShiftAnd},
+        {120, 6, 20, "abcdXYZ.", AutoMatcher::Engine::kWuManber},
+        {200, 1, 4, "abcdefghXYZ.", AutoMatcher::Engine::kACTrie},
+    };
+    TestResult result{
+        .status                   = TestStatus::kPassed,
+        .found_occurances_size    = 0,
+        .expected_occurances_size = 0,
+        .patterns_size            = 0,
+        .text_size                = 0,
+        .time_passed_millis       = {},
+    };
+    for (const PatternsShape& shape : kShapes) {
+        const TestResult shape_result = DifferentialTestImpl<AutoMatcher>(
+            shape.patterns_size, shape.min_pattern_length,
+            shape.max_pattern_length, 1e6, shape.symbols,
+            [&shape](const AutoMatcher& matcher) {
+                return matcher.ChosenEngine() == shape.expected_engine;
+            });
+        if (shape_result.status != TestStatus::kPassed) {
+            result.status = shape_result.status;
+        }
+        result.found_occurances_size += shape_result.found_occurances_size;
+        result.expected_occurances_size +=
+            shape_result.expected_occurances_size;
+        result.patterns_size += shape_result.patterns_size;
+        result.text_size += shape_result.text_size;
+        result.time_passed_millis += shape_result.time_passed_millis;
+    }
+    return result;
+}
+
+TestResult Test12Impl() {
+    constexpr std::size_t kPatternsSize      = 60000;
+    constexpr std::size_t kMaxPatternLength  = 14;
+    constexpr std::size_t kTextLength        = 1e6;
+    constexpr std::size_t kBuildThreadsCount = 4;
+    constexpr std::string_view kSymbols      = "abcdefghXYZ.";
+    std::mt19937 rnd(12);
+    std::vector<std::string> patterns;
+    patterns.reserve(kPatternsSize + 3);
+    for (std::size_t i = 0; i < kPatternsSize; i++) {
+        patterns.push_back(GenerateRandomString(
+            1 + rnd() % kMaxPatternLength,
+            kSymbols.substr(0, kSymbols.size() - 1), rnd));
+    }
+    // Empty, bad and repeated patterns take word indexes as in AddPattern()
+    patterns.insert(patterns.begin() + kPatternsSize / 3, "");
+    patterns.insert(patterns.begin() + kPatternsSize / 2, "ab.cd");
+    patterns.push_back(patterns.front());
+    const std::string text = GenerateRandomString(kTextLength, kSymbols, rnd);
+
+    ACTrie sequential_actrie;
+    sequential_actrie.SetBuildThreadsCount(1);
+    const auto expected_occurances =
+        FindOccurances(sequential_actrie, patterns, text);
+
+    Timer timer;
+    const std::vector<std::string_view> patterns_views(patterns.begin(),
+                                                       patterns.end());
+    ACTrie parallel_actrie;
+    parallel_actrie.SetBuildThreadsCount(kBuildThreadsCount)
+        .AddPatterns(patterns_views)
+        .BuildACTrie();
+    const auto found_occurances = FindOccurances(parallel_actrie, {}, text);
+    auto time_passed_millis     = timer.TimePassed();
+    const bool passed =
+        found_occurances == expected_occurances &&
+        parallel_actrie.NodesSize() == sequential_actrie.NodesSize() &&
+        parallel_actrie.PatternsSize() == sequential_actrie.PatternsSize();
+    return {
+        .status = passed ? TestStatus::kPassed : TestStatus::kNotPassed,
+        .found_occurances_size    = found_occurances.size(),
+        .expected_occurances_size = expected_occurances.size(),
+        .patterns_size            = patterns.size(),
+        .text_size                = text.size(),
+        .time_passed_millis       = time_passed_millis,
+    };
+}
+
+/// @brief Checks every transition taken on the text against the naive
+///         automaton: the node reached after a symbol must be the node of
+///         the longest suffix of the text read so far which is a prefix of
+///         some pattern.
+TestResult Test13Impl() {
+    constexpr std::size_t kPatternsSize     = 400;
+    constexpr std::size_t kMaxPatternLength = 8;
+    constexpr std::size_t kTextLength       = 2e5;
+    constexpr std::string_view kSymbols     = "abcdefXYZ.";
+    std::mt19937 rnd(13);
+    ACTrie actrie;
+    std::vector<std::string> nodes_prefixes;
+    std::unordered_map<std::string, ACTrie::VertexIndex> prefixes_nodes;
+    ACTrie::UpdatedNodeObserver updated_nodes_obs(
+        [&](ACTrie::UpdatedNodeInfoPassBy info) {
+            if (info.status != ACTrie::UpdatedNodeStatus::kAdded ||
+                info.node_index < ACTrie::kRootIndex) {
+                return;
+            }
+            std::string prefix;
+            if (info.node_index != ACTrie::kRootIndex) {
+                prefix = nodes_prefixes[info.parent_node_index] +
+                         info.parent_to_node_edge_symbol;
+            }
+            nodes_prefixes.resize(std::max(nodes_prefixes.size(),
+                                           std::size_t{info.node_index} + 1));
+            nodes_prefixes[info.node_index] = prefix;
+            prefixes_nodes.emplace(std::move(prefix), info.node_index);
+        });
+    actrie.AddSubscriber(&updated_nodes_obs);
+    for (std::size_t i = 0; i < kPatternsSize; i++) {
+        actrie.AddPattern(GenerateRandomString(
+            1 + rnd() % kMaxPatternLength,
+            kSymbols.substr(0, kSymbols.size() - 1), rnd));
+    }
+    const std::string text = GenerateRandomString(kTextLength, kSymbols, rnd);
+
+    std::vector<ACTrie::VertexIndex> found_nodes;
+    ACTrie::PassingThroughObserver passing_through_obs(
+        [&found_nodes](ACTrie::PassingThroughInfoPassBy node_index) {
+            found_nodes.push_back(node_index);
+        });
+    actrie.AddSubscriber(&passing_through_obs);
+    Timer timer;
+    actrie.FindAllSubstringsInText(text);
+    auto time_passed_millis = timer.TimePassed();
+
+    std::vector<ACTrie::VertexIndex> expected_nodes{ACTrie::kRootIndex};
+    std::size_t segment_start = 0;
+    for (std::size_t i = 0; i < text.size(); i++) {
+        if (ACTrie::SymbolToIndex(text[i]) >= ACTrie::kAlphabetLength) {
+            expected_nodes.push_back(ACTrie::kRootIndex);
+            segment_start = i + 1;
+            continue;
+        }
+        const std::string_view segment(text.data() + segment_start,
+                                       i + 1 - segment_start);
+        for (std::size_t length = std::min(segment.size(), kMaxPatternLength);;
+             length--) {
+            auto iter = prefixes_nodes.find(
+                std::string(segment.substr(segment.size() - length)));
+            if (iter != prefixes_nodes.end()) {
+                expected_nodes.push_back(iter->second);
+                break;
+            }
+        }
+    }
+    return {
+        .status                   = found_nodes == expected_nodes
+                                        ? TestStatus::kPassed
+                                        : TestStatus::kNotPassed,
+        .found_occurances_size    = found_nodes.size(),
+        .expected_occurances_size = expected_nodes.size(),
+        .patterns_size            = kPatternsSize,
+        .text_size                = text.size(),
+        .time_passed_millis       = time_passed_millis,
+    };
+}
+
+TestResult Test14Impl() {
+    using ACTrieDS::HugePagesMemoryResource;
+    constexpr std::size_t kPatternsSize = 20000;
+    constexpr std::size_t kTextLength   = 1e6;
+    constexpr std::string_view kSymbols = "abcdefghijXYZ.";
+    std::mt19937 rnd(14);
+    std::vector<std::string> patterns;
+    patterns.reserve(kPatternsSize);
+    for (std::size_t i = 0; i < kPatternsSize; i++) {
+        patterns.push_back(GenerateRandomString(
+            4 + rnd() % 12, kSymbols.substr(0, kSymbols.size() - 1), rnd));
+    }
+    const std::string text = GenerateRandomString(kTextLength, kSymbols, rnd);
+
+    ACTrie actrie;
+    const auto expected_occurances = FindOccurances(actrie, patterns, text);
+
+    // Explicit huge pages are usually not reserved, so both the explicit
+    //  pages and the fallback to the transparent ones may be tested here.
+    HugePagesMemoryResource memory_resource(
+        HugePagesMemoryResource::Mode::kExplicit);
+    std::vector<Occurance> found_occurances;
+    Timer timer;
+    bool all_nodes_mapped = false;
+    {
+        ACTrie mapped_actrie(&memory_resource);
+        found_occurances = FindOccurances(mapped_actrie, patterns, text);
+        all_nodes_mapped = memory_resource.MappedBytes() >=
+                           mapped_actrie.NodesSize() * sizeof(ACTrie::ACTNode);
+    }
+    auto time_passed_millis = timer.TimePassed();
+    const bool passed       = found_occurances == expected_occurances &&
+                        all_nodes_mapped && memory_resource.MappedBytes() == 0;
+    return {
+        .status = passed ? TestStatus::kPassed : TestStatus::kNotPassed,
+        .found_occurances_size    = found_occurances.size(),
+        .expected_occurances_size = expected_occurances.size(),
+        .patterns_size            = patterns.size(),
+        .text_size                = text.size(),
+        .time_passed_millis       = time_passed_millis,
+    };
+}
+
+TestResult Test15Impl() {
+    using ACTrieDS::VersionedACTrie;
+    constexpr std::size_t kVersionsSize      = 40;
+    constexpr std::size_t kReadersSize       = 3;
+    constexpr std::size_t kTextLength        = 1e5;
+    const std::vector<std::string> kPatterns = {"ab", "bca", "dd", "abcd",
+                                                "a",  "cab", "XY"};
+    std::mt19937 rnd(15);
+    const std::string text =
+        GenerateRandomString(kTextLength, kRandomTextSymbols, rnd);
+
+    // Version i contains the first i % kPatterns.size() + 1 patterns
+    std::vector<std::vector<Occurance>> expected_occurances;
+    for (std::size_t i = 0; i < kPatterns.size(); i++) {
+        ACTrie actrie;
+        expected_occurances.push_back(FindOccurances(
+            actrie,
+            std::vector<std::string>(kPatterns.begin(),
+                                     kPatterns.begin() + std::ptrdiff_t(i + 1)),
+            text));
+    }
+    auto make_version = [&](std::size_t version_index) {
+        auto actrie = std::make_shared<ACTrie>();
+        for (std::size_t i = 0; i <= version_index % kPatterns.size(); i++) {
+            actrie->AddPattern(kPatterns[i]);
+        }
+        actrie->BuildACTrie();
+        return VersionedACTrie::Version(std::move(actrie));
+    };
+
+    VersionedACTrie versioned_actrie(make_version(0));
+    const std::weak_ptr<const ACTrie> first_version =
+        versioned_actrie.Acquire();
+    std::atomic<bool> writer_finished{false};
+    std::atomic<std::size_t> scans_size{0};
+    std::atomic<bool> all_scans_correct{true};
+    auto read = [&]() {
+        do {
+            const VersionedACTrie::Version version = versioned_actrie.Acquire();
+            std::vector<Occurance> occurances;
+            version->FindAllSubstringsInText(
+                text, [&occurances](const ACTrie::FoundSubstringInfo& info) {
+                    occurances.emplace_back(info.found_substring,
+                                            info.substring_start_index,
+                                            info.word_index);
+                });
+            const std::size_t patterns_size = version->PatternsSize();
+            if (occurances != expected_occurances[patterns_size - 1]) {
+                all_scans_correct = false;
+            }
+            scans_size++;
+        } while (!writer_finished);
+    };
+
+    Timer timer;
+    std::vector<std::jthread> readers;
+    for (std::size_t i = 0; i < kReadersSize; i++) {
+        readers.emplace_back(read);
+    }
+    for (std::size_t i = 1; i < kVersionsSize; i++) {
+        versioned_actrie.Publish(make_version(i));
+        std::this_thread::yield();
+    }
+    writer_finished = true;
+    readers.clear();
+    auto time_passed_millis = timer.TimePassed();
+
+    const bool passed = all_scans_correct && first_version.expired() &&
+                        versioned_actrie.PublishedVersionsCount() ==
+                            kVersionsSize;
+    return {
+        .status = passed ? TestStatus::kPassed : TestStatus::kNotPassed,
+        .found_occurances_size    = scans_size,
+        .expected_occurances_size = scans_size,
+        .patterns_size            = kPatterns.size(),
+        .text_size                = text.size(),
+        .time_passed_millis       = time_passed_millis,
+    };
+}
+
+TestResult Test16Impl() {
+    using GroupsMask                    = ACTrie::GroupsMask;
+    constexpr std::size_t kPatternsSize = 300;
+    constexpr std::size_t kGroupsSize   = 6;
+    constexpr std::size_t kTextLength   = 2e5;
+    std::mt19937 rnd(16);
+    ACTrie actrie;
+    // Union of the groups of all additions of the pattern
+    std::unordered_map<std::string, GroupsMask> patterns_groups;
+    for (std::string& pattern : GenerateRandomPatterns(kPatternsSize, 6, rnd)) {
+        const GroupsMask groups = GroupsMask{1} << (rnd() % kGroupsSize);
+        actrie.AddPattern(pattern, groups);
+        patterns_groups[std::move(pattern)] |= groups;
+    }
+    actrie.BuildACTrie();
+    const std::string text =
+        GenerateRandomString(kTextLength, kRandomTextSymbols, rnd);
+
+    auto find_occurances = [&](GroupsMask groups) {
+        std::vector<Occurance> occurances;
+        auto on_found = [&occurances](const ACTrie::FoundSubstringInfo& info) {
+            occurances.emplace_back(info.found_substring,
+                                    info.substring_start_index,
+                                    info.word_index);
+        };
+        actrie.FindAllSubstringsInText(text, groups, on_found);
+        return occurances;
+    };
+    const std::vector<Occurance> all_occurances =
+        find_occurances(ACTrie::kAllGroups);
+
+    constexpr GroupsMask kQueriesGroups[] = {0b1, 0b100, 0b10110, 0b111111,
+                                             0b1000000};
+    std::size_t found_occurances_size    = 0;
+    std::size_t expected_occurances_size = 0;
+    bool passed                          = true;
+    Timer timer;
+    for (GroupsMask groups : kQueriesGroups) {
+        std::vector<Occurance> expected_occurances;
+        for (const Occurance& occurance : all_occurances) {
+            const std::string pattern(std::get<0>(occurance));
+            if ((patterns_groups.at(pattern) & groups) != 0) {
+                expected_occurances.push_back(occurance);
+            }
+        }
+        const std::vector<Occurance> found_occurances =
+            find_occurances(groups);
+        passed = passed && found_occurances == expected_occurances;
+        found_occurances_size += found_occurances.size();
+        expected_occurances_size += expected_occurances.size();
+    }
+    auto time_passed_millis = timer.TimePassed();
+    return {
+        .status = passed ? TestStatus::kPassed : TestStatus::kNotPassed,
+        .found_occurances_size    = found_occurances_size,
+        .expected_occurances_size = expected_occurances_size,
+        .patterns_size            = kPatternsSize,
+        .text_size                = text.size(),
+        .time_passed_millis       = time_passed_millis,
+    };
+}
+
+TestResult Test17Impl() {
+    using Score                         = ACTrie::Score;
+    constexpr std::size_t kPatternsSize = 200;
+    constexpr std::size_t kTextsSize    = 20;
+    constexpr std::size_t kTextLength   = 1e4;
+    std::mt19937 rnd(17);
+    const std::vector<std::string> patterns =
+        GenerateRandomPatterns(kPatternsSize, 5, rnd);
+    std::vector<std::string> texts;
+    for (std::size_t i = 0; i < kTextsSize; i++) {
+        texts.push_back(
+            GenerateRandomString(kTextLength, kRandomTextSymbols, rnd));
+    }
+    const std::vector<ACTrie::Text> texts_views(texts.begin(), texts.end());
+
+    std::size_t found_occurances_size    = 0;
+    std::size_t expected_occurances_size = 0;
+    bool passed                          = true;
+    Timer timer;
+    // Weights are small integers, so the sums do not depend on the order
+    for (bool capped : {false, true}) {
+        ACTrie actrie;
+        std::vector<Score> weights;
+        std::vector<std::uint32_t> max_counted_occurances;
+        for (const std::string& pattern : patterns) {
+            actrie.AddPattern(pattern, ACTrie::GroupsMask{1} << (rnd() % 3));
+            weights.push_back(Score(int(rnd() % 9) - 3));
+            max_counted_occurances.push_back(
+                capped && rnd() % 2 == 0 ? std::uint32_t(rnd() % 4)
+                                         : ACTrie::kUncappedOccurances);
+            actrie.SetPatternWeight(weights.size() - 1, weights.back(),
+                                    max_counted_occurances.back());
+        }
+        actrie.BuildACTrie();
+
+        for (ACTrie::GroupsMask groups : {ACTrie::kAllGroups,
+                                          ACTrie::GroupsMask{0b101}}) {
+            std::vector<Score> expected_scores;
+            for (ACTrie::Text text : texts_views) {
+                std::vector<std::uint32_t> words_counts(kPatternsSize);
+                Score expected_score = 0;
+                actrie.FindAllSubstringsInText(
+                    text, groups, [&](const ACTrie::FoundSubstringInfo& info) {
+                        if (words_counts[info.word_index]++ <
+                            max_counted_occurances[info.word_index]) {
+                            expected_score += weights[info.word_index];
+                        }
+                    });
+                expected_scores.push_back(expected_score);
+                passed = passed &&
+                         actrie.ScoreText(text, groups) == expected_score;
+            }
+            passed = passed &&
+                     actrie.ScoreTexts(texts_views, groups) == expected_scores;
+            found_occurances_size += expected_scores.size();
+            expected_occurances_size += texts_views.size();
+        }
+    }
+
+    // Empty pattern is found only at the root, with the default weights the
+    //  score is the number of the found substrings
+    ACTrie empty_pattern_actrie;
+    empty_pattern_actrie.AddPattern("").AddPattern("ab").BuildACTrie();
+    constexpr std::string_view kEmptyPatternText = "ab.xab";
+    std::size_t empty_pattern_occurances_size    = 0;
+    empty_pattern_actrie.FindAllSubstringsInText(
+        kEmptyPatternText, [&](const ACTrie::FoundSubstringInfo&) {
+            empty_pattern_occurances_size++;
+        });
+    passed = passed && empty_pattern_occurances_size == 4 &&
+             empty_pattern_actrie.ScoreText(kEmptyPatternText) ==
+                 Score(empty_pattern_occurances_size);
+    auto time_passed_millis = timer.TimePassed();
+    return {
+        .status = passed ? TestStatus::kPassed : TestStatus::kNotPassed,
+        .found_occurances_size    = found_occurances_size,
+        .expected_occurances_size = expected_occurances_size,
+        .patterns_size            = kPatternsSize,
+        .text_size                = kTextsSize * kTextLength,
+        .time_passed_millis       = time_passed_millis,
+    };
+}
+
+TestResult Test18Impl() {
+    using ACTrieDS::OccurancesHistogram;
+    using Count                         = OccurancesHistogram::Count;
+    constexpr std::size_t kPatternsSize = 500;
+    constexpr std::size_t kTextsSize    = 64;
+    std::mt19937 rnd(18);
+    ACTrie actrie;
+    for (const std::string& pattern :
+         GenerateRandomPatterns(kPatternsSize, 6, rnd)) {
+        actrie.AddPattern(pattern);
+    }
+    actrie.BuildACTrie();
+    std::vector<std::string> texts;
+    std::size_t texts_length = 0;
+    for (std::size_t i = 0; i < kTextsSize; i++) {
+        texts.push_back(
+            GenerateRandomString(rnd() % 5000, kRandomTextSymbols, rnd));
+        texts_length += texts.back().size();
+    }
+    const std::vector<ACTrie::Text> texts_views(texts.begin(), texts.end());
+
+    std::vector<Count> expected_counts(kPatternsSize);
+    for (ACTrie::Text text : texts_views) {
+        actrie.FindAllSubstringsInText(
+            text, [&expected_counts](const ACTrie::FoundSubstringInfo& info) {
+                expected_counts[info.word_index]++;
+            });
+    }
+    auto counts_equal = [&expected_counts](std::span<const Count> counts) {
+        return std::equal(counts.begin(), counts.end(),
+                          expected_counts.begin(), expected_counts.end());
+    };
+
+    bool passed = true;
+    Timer timer;
+    for (std::size_t threads_count : {1U, 3U, 8U, 100U}) {
+        OccurancesHistogram histogram(actrie, threads_count);
+        histogram.CountInTexts(texts_views);
+        passed = passed && counts_equal(histogram.Counts());
+    }
+    // Counts of the several calls are summed until Reset()
+    OccurancesHistogram histogram(actrie, 4);
+    const std::span<const ACTrie::Text> texts_span(texts_views);
+    histogram.CountInTexts(texts_span.first(kTextsSize / 2))
+        .CountInTexts(texts_span.subspan(kTextsSize / 2));
+    passed = passed && counts_equal(histogram.Counts());
+    histogram.Reset().CountInTexts({});
+    passed = passed && std::ranges::all_of(histogram.Counts(),
+                                           [](Count count) {
+                                               return count == 0;
+                                           });
+    auto time_passed_millis = timer.TimePassed();
+
+    std::size_t expected_occurances_size = 0;
+    for (Count count : expected_counts) {
+        expected_occurances_size += count;
+    }
+    return {
+        .status = passed ? TestStatus::kPassed : TestStatus::kNotPassed,
+        .found_occurances_size    = expected_occurances_size,
+        .expected_occurances_size = expected_occurances_size,
+        .patterns_size            = kPatternsSize,
+        .text_size                = texts_length,
+        .time_passed_millis       = time_passed_millis,
+    };
+}
+
+TestResult Test19Impl() {
+    using ACTrieDS::CorpusScanner;
+    constexpr std::size_t kPatternsSize = 300;
+    std::mt19937 rnd(19);
+    ACTrie actrie;
+    for (const std::string& pattern :
+         GenerateRandomPatterns(kPatternsSize, 6, rnd)) {
+        actrie.AddPattern(pattern);
+    }
+    // Longer than the smallest chunks
+    actrie.AddPattern("abcdabcdabcdabcdabcd");
+    actrie.BuildACTrie();
+
+    std::vector<std::string> texts;
+    constexpr std::size_t kTextsLengths[] = {0,      1, 10,   1000, 3000,
+                                             200000, 5, 40000};
+    for (std::size_t length : kTextsLengths) {
+        texts.push_back(GenerateRandomString(length, kRandomTextSymbols, rnd));
+    }
+    texts.back().replace(100, 20, "abcdabcdabcdabcdabcd");
+    const std::filesystem::path files_directory =
+        std::filesystem::temp_directory_path() / "actrie_test_19";
+    std::filesystem::create_directories(files_directory);
+    std::vector<std::filesystem::path> files;
+    for (std::size_t i = 3; i < texts.size(); i += 2) {
+        files.push_back(files_directory / (std::to_string(i) + ".txt"));
+        std::ofstream(files.back(), std::ios::binary) << texts[i];
+    }
+    const std::filesystem::path missing_file = files_directory / "missing";
+
+    std::vector<std::vector<OwnedOccurance>> expected_occurances;
+    std::size_t texts_length = 0;
+    for (const std::string& text : texts) {
+        texts_length += text.size();
+        expected_occurances.emplace_back();
+        actrie.FindAllSubstringsInText(
+            text, [&](const ACTrie::FoundSubstringInfo& info) {
+                expected_occurances.back().emplace_back(
+                    info.found_substring, info.substring_start_index,
+                    info.word_index);
+            });
+    }
+
+    std::size_t found_occurances_size    = 0;
+    std::size_t expected_occurances_size = 0;
+    bool passed                          = true;
+    Timer timer;
+    for (std::size_t chunk_size : {3U, 1000U, 1U << 20}) {
+        std::vector<RecordingSink<CorpusScanner::DocumentSink>> sinks(
+            texts.size() + 1);
+        std::vector<CorpusScanner::Document> documents;
+        for (std::size_t i = 0, file_index = 0; i < texts.size(); i++) {
+            CorpusScanner::Document document{.source = {}, .sink = &sinks[i]};
+            if (i >= 3 && i % 2 == 1) {
+                document.source = files[file_index++];
+            } else {
+                document.source = ACTrie::Text(texts[i]);
+            }
+            documents.push_back(std::move(document));
+        }
+        documents.push_back({.source = missing_file, .sink = &sinks.back()});
+
+        CorpusScanner scanner(actrie, 4);
+        scanner.SetChunkSize(chunk_size).Scan(documents);
+        for (std::size_t i = 0; i < texts.size(); i++) {
+            passed =
+                passed && sinks[i].IsCorrect(expected_occurances[i], false);
+            found_occurances_size += sinks[i].OccurancesSize();
+            expected_occurances_size += expected_occurances[i].size();
+        }
+        passed = passed && sinks.back().IsCorrect({}, true);
+    }
+    auto time_passed_millis = timer.TimePassed();
+    std::filesystem::remove_all(files_directory);
+    return {
+        .status = passed ? TestStatus::kPassed : TestStatus::kNotPassed,
+        .found_occurances_size    = found_occurances_size,
+        .expected_occurances_size = expected_occurances_size,
+        .patterns_size            = kPatternsSize + 1,
+        .text_size                = texts_length,
+        .time_passed_millis       = time_passed_millis,
+    };
+}
+
+TestResult Test20Impl() {
+    using ACTrieDS::ByteSource;
+    using ACTrieDS::ScanPipeline;
+    using ACTrieDS::TextByteSource;
+    using Match                         = ScanPipeline::Match;
+    constexpr std::size_t kPatternsSize = 300;
+    constexpr std::size_t kSourcesSize  = 5;
+    std::mt19937 rnd(20);
+    ACTrie actrie;
+    for (const std::string& pattern :
+         GenerateRandomPatterns(kPatternsSize, 6, rnd)) {
+        actrie.AddPattern(pattern);
+    }
+    actrie.AddPattern("abcdabcdabcdabcdabcd");
+    actrie.BuildACTrie();
+
+    std::vector<std::string> texts;
+    std::size_t texts_length = 0;
+    for (std::size_t i = 0; i < kSourcesSize; i++) {
+        texts.push_back(
+            GenerateRandomString(rnd() % 30000, kRandomTextSymbols, rnd));
+        texts_length += texts.back().size();
+    }
+    texts[1] += "abcdabcdabcdabcdabcd";
+    auto match_less = [](const Match& lhs, const Match& rhs) {
+        return std::tie(lhs.offset, lhs.length, lhs.word_index) <
+               std::tie(rhs.offset, rhs.length, rhs.word_index);
+    };
+    auto match_equal = [](const Match& lhs, const Match& rhs) {
+        return std::tie(lhs.offset, lhs.length, lhs.word_index) ==
+               std::tie(rhs.offset, rhs.length, rhs.word_index);
+    };
+    std::vector<std::vector<Match>> expected_matches(kSourcesSize);
+    std::size_t expected_occurances_size = 0;
+    for (std::size_t i = 0; i < kSourcesSize; i++) {
+        actrie.FindAllSubstringsInText(
+            texts[i], [&](const ACTrie::FoundSubstringInfo& info) {
+                expected_matches[i].push_back(Match{
+                    .offset     = info.substring_start_index,
+                    .word_index = info.word_index,
+                    .length = ACTrie::WordLength(info.found_substring.size()),
+                });
+            });
+        std::ranges::sort(expected_matches[i], match_less);
+    }
+
+    class CollectingSink final : public ScanPipeline::MatchesSink {
+    public:
+        explicit CollectingSink(std::size_t sources_size)
+            : matches(sources_size) {}
+        void OnMatches(const ScanPipeline::MatchesBatch& batch) override {
+            std::lock_guard lock(mutex);
+            std::vector<Match>& source_matches = matches[batch.source_index];
+            source_matches.insert(source_matches.end(), batch.matches.begin(),
+                                  batch.matches.end());
+        }
+
+        std::mutex mutex;
+        std::vector<std::vector<Match>> matches;
+    };
+
+    struct PipelineConfig final {
+        std::size_t readers;
+        std::size_t scanners;
+        std::size_t sinks;
+        std::size_t buffer_size;
+        std::size_t buffers_count;
+        std::size_t batch_capacity;
+        std::size_t batches_count;
+    };
+    constexpr PipelineConfig kConfigs[] = {
+        {1, 1, 1, 1 << 20, 0, 1 << 12, 0},
+        {1, 1, 1, 7, 1, 1, 1},
+        {2, 3, 2, 100, 2, 7, 2},
+        {3, 4, 1, 4000, 0, 50, 0},
+    };
+    std::size_t found_occurances_size = 0;
+    bool passed                       = true;
+    Timer timer;
+    for (const PipelineConfig& config : kConfigs) {
+        std::vector<TextByteSource> sources;
+        std::vector<ByteSource*> sources_pointers;
+        for (const std::string& text : texts) {
+            sources.emplace_back(text, 1 + rnd() % 1000);
+        }
+        for (TextByteSource& source : sources) {
+            sources_pointers.push_back(&source);
+        }
+        CollectingSink sink(kSourcesSize);
+        ScanPipeline pipeline(actrie);
+        pipeline.SetThreadsCounts(config.readers, config.scanners, config.sinks)
+            .SetBuffers(config.buffer_size, config.buffers_count,
+                        config.batch_capacity, config.batches_count)
+            .Run(sources_pointers, sink);
+        for (std::size_t i = 0; i < kSourcesSize; i++) {
+            std::ranges::sort(sink.matches[i], match_less);
+            passed = passed && std::ranges::equal(sink.matches[i],
+                                                  expected_matches[i],
+                                                  match_equal);
+            found_occurances_size += sink.matches[i].size();
+            expected_occurances_size += expected_matches[i].size();
+        }
+        const ScanPipeline::Stats stats = pipeline.GetStats();
+        passed = passed && stats.readers.processed_items_count ==
+                               stats.scanners.processed_items_count;
+    }
+
+    // Error of a source is rethrown after the pipeline is drained
+    class FailingSource final : public ByteSource {
+    public:
+        std::size_t Read(std::span<char> buffer) override {
+            if (reads_count_++ == 3) {
+                throw std::runtime_error("read failed");
+            }
+            std::fill(buffer.begin(), buffer.end(), 'a');
+            return buffer.size();
+        }
+
+    private:
+        std::size_t reads_count_ = 0;
+    };
+    FailingSource failing_source;
+    TextByteSource text_source(texts[0]);
+    ByteSource* sources_pointers[] = {&failing_source, &text_source};
+    CollectingSink sink(2);
+    bool thrown = false;
+    try {
+        ScanPipeline(actrie).SetBuffers(64, 2, 16, 2).Run(sources_pointers,
+                                                           sink);
+    } catch (const std::runtime_error&) {
+        thrown = true;
+    }
+    std::ranges::sort(sink.matches[1], match_less);
+    passed = passed && thrown &&
+             std::ranges::equal(sink.matches[1], expected_matches[0],
+                                match_equal);
+    auto time_passed_millis = timer.TimePassed();
+    return {
+        .status = passed ? TestStatus::kPassed : TestStatus::kNotPassed,
+        .found_occurances_size    = found_occurances_size,
+        .expected_occurances_size = expected_occurances_size,
+        .patterns_size            = kPatternsSize + 1,
+        .text_size                = texts_length,
+        .time_passed_millis       = time_passed_millis,
+    };
+}
+
+TestResult Test21Impl() {
+    using ACTrieDS::UringFileScanner;
+    constexpr std::size_t kPatternsSize = 300;
+    std::mt19937 rnd(21);
+    ACTrie actrie;
+    for (const std::string& pattern :
+         GenerateRandomPatterns(kPatternsSize, 6, rnd)) {
+        actrie.AddPattern(pattern);
+    }
+    actrie.AddPattern("abcdabcdabcdabcdabcd");
+    actrie.BuildACTrie();
+    if (!UringFileScanner::IsSupported()) {
+        std::cout << "io_uring is not supported, test 21 is skipped\n";
+        return {
+            .status                   = TestStatus::kPassed,
+            .found_occurances_size    = 0,
+            .expected_occurances_size = 0,
+            .patterns_size            = kPatternsSize + 1,
+            .text_size                = 0,
+            .time_passed_millis       = {},
+        };
+    }
+    // Lengths around the multiples of the smallest buffer size
+    std::vector<std::string> texts;
+    constexpr std::size_t kTextsLengths[] = {0,     1,     4095,  4096,
+                                             4097,  8200,  40000, 300000,
+                                             12288, 100000};
+    for (std::size_t length : kTextsLengths) {
+        texts.push_back(GenerateRandomString(length, kRandomTextSymbols, rnd));
+    }
+    // Patterns crossing the chunks boundaries
+    texts[6].replace(4090, 20, "abcdabcdabcdabcdabcd");
+    texts[6].replace(8180, 20, "abcdabcdabcdabcdabcd");
+    const std::filesystem::path files_directory =
+        std::filesystem::temp_directory_path() / "actrie_test_21";
+    std::filesystem::create_directories(files_directory);
+    std::vector<std::filesystem::path> paths;
+    std::vector<std::vector<OwnedOccurance>> expected_occurances;
+    std::size_t texts_length = 0;
+    for (std::size_t i = 0; i < texts.size(); i++) {
+        paths.push_back(files_directory / (std::to_string(i) + ".txt"));
+        std::ofstream(paths.back(), std::ios::binary) << texts[i];
+        texts_length += texts[i].size();
+        expected_occurances.emplace_back();
+        actrie.FindAllSubstringsInText(
+            texts[i], [&](const ACTrie::FoundSubstringInfo& info) {
+                expected_occurances.back().emplace_back(
+                    info.found_substring, info.substring_start_index,
+                    info.word_index);
+            });
+    }
+    paths.push_back(files_directory / "missing");
+
+    struct Config final {
+        std::size_t threads_count;
+        std::size_t queue_depth;
+        std::size_t buffer_size;
+        bool direct_io;
+    };
+    constexpr Config kConfigs[] = {
+        {.threads_count = 1, .queue_depth = 1, .buffer_size = 1,
+         .direct_io = false},
+        {.threads_count = 3, .queue_depth = 4, .buffer_size = 4096,
+         .direct_io = true},
+        {.threads_count = 2, .queue_depth = 64, .buffer_size = 1 << 20,
+         .direct_io = false},
+        {.threads_count = 1, .queue_depth = 8, .buffer_size = 8192,
+         .direct_io = true},
+    };
+    std::size_t found_occurances_size    = 0;
+    std::size_t expected_occurances_size = 0;
+    bool passed                          = true;
+    Timer timer;
+    for (const Config& config : kConfigs) {
+        std::vector<RecordingSink<UringFileScanner::DocumentSink>> sinks(
+            paths.size());
+        std::vector<UringFileScanner::File> files;
+        for (std::size_t i = 0; i < paths.size(); i++) {
+            files.push_back({.path = paths[i], .sink = &sinks[i]});
+        }
+
+        UringFileScanner scanner(actrie, config.threads_count);
+        scanner.SetQueueDepth(config.queue_depth)
+            .SetBufferSize(config.buffer_size)
+            .SetDirectIO(config.direct_io)
+            .Scan(files);
+        for (std::size_t i = 0; i < texts.size(); i++) {
+            passed =
+                passed && sinks[i].IsCorrect(expected_occurances[i], false);
+            found_occurances_size += sinks[i].OccurancesSize();
+            expected_occurances_size += expected_occurances[i].size();
+        }
+        passed = passed && sinks.back().IsCorrect({}, true);
+    }
+    auto time_passed_millis = timer.TimePassed();
+    std::filesystem::remove_all(files_directory);
+    return {
+        .status = passed ? TestStatus::kPassed : TestStatus::kNotPassed,
+        .found_occurances_size    = found_occurances_size,
+        .expected_occurances_size = expected_occurances_size,
+        .patterns_size            = kPatternsSize + 1,
+        .text_size                = texts_length,
+        .time_passed_millis       = time_passed_millis,
+    };
+}
+
+TestResult Test22Impl() {
+    using ACTrieDS::BinaryMatchesReader;
+    using ACTrieDS::BinaryMatchesWriter;
+    using ACTrieDS::MatchesBlock;
+    using ACTrieDS::MatchesWriter;
+    using ACTrieDS::NdjsonMatchesWriter;
+    using Match = std::tuple<std::uint64_t, ACTrie::WordLength,
+                             ACTrie::WordLength>;
+    constexpr std::size_t kPatternsSize = 200;
+    constexpr std::size_t kTextLength   = 100000;
+    constexpr std::string_view kSymbols = "abcdXYZ";
+    std::mt19937 rnd(22);
+    ACTrie actrie;
+    for (std::size_t i = 0; i < kPatternsSize; i++) {
+        actrie.AddPattern(GenerateRandomString(1 + rnd() % 5, kSymbols, rnd));
+    }
+    actrie.BuildACTrie();
+    const std::string text = GenerateRandomString(kTextLength, kSymbols, rnd);
+    std::vector<Match> expected_matches;
+    actrie.FindAllSubstringsInText(
+        text, [&](const ACTrie::FoundSubstringInfo& info) {
+            expected_matches.emplace_back(
+                info.substring_start_index, info.word_index,
+                static_cast<ACTrie::WordLength>(info.found_substring.size()));
+        });
+
+    const std::filesystem::path files_directory =
+        std::filesystem::temp_directory_path() / "actrie_test_22";
+    std::filesystem::create_directories(files_directory);
+    const std::filesystem::path binary_path = files_directory / "matches.bin";
+    const std::filesystem::path ndjson_path =
+        files_directory / "matches.ndjson";
+    auto write_matches = [&](const std::filesystem::path& path,
+                             bool is_binary, std::size_t block_capacity) {
+        std::FILE* file = std::fopen(path.string().c_str(), "wb");
+        if (file == nullptr) {
+            throw std::runtime_error("can not open " + path.string());
+        }
+        std::unique_ptr<MatchesWriter> writer;
+        if (is_binary) {
+            writer =
+                std::make_unique<BinaryMatchesWriter>(file, block_capacity);
+        } else {
+            writer =
+                std::make_unique<NdjsonMatchesWriter>(file, block_capacity);
+        }
+        actrie.FindAllSubstringsInText(
+            text, [&writer](const ACTrie::FoundSubstringInfo& info) {
+                writer->Add(info);
+            });
+        writer->Finish();
+        std::fclose(file);
+        return writer->WrittenMatchesCount();
+    };
+    auto append_block = [](const MatchesBlock& block,
+                           std::vector<Match>& matches) {
+        for (std::size_t i = 0; i < block.offsets.size(); i++) {
+            matches.emplace_back(block.offsets[i], block.word_indexes[i],
+                                 block.lengths[i]);
+        }
+    };
+    // Numbers of the array "name":[...] of the line
+    auto parse_numbers = [](std::string_view line, std::string_view name) {
+        const std::string key = '"' + std::string(name) + "\":[";
+        std::string_view numbers =
+            line.substr(line.find(key) + key.size());
+        numbers = numbers.substr(0, numbers.find(']'));
+        std::vector<std::uint64_t> result;
+        while (!numbers.empty()) {
+            std::uint64_t number = 0;
+            const char* number_end =
+                std::from_chars(numbers.data(),
+                                numbers.data() + numbers.size(), number)
+                    .ptr;
+            result.push_back(number);
+            // Number and the comma after it
+            numbers.remove_prefix(std::min(
+                std::size_t(number_end - numbers.data()) + 1, numbers.size()));
+        }
+        return result;
+    };
+
+    std::size_t found_occurances_size    = 0;
+    std::size_t expected_occurances_size = 0;
+    bool passed                          = true;
+    Timer timer;
+    for (std::size_t block_capacity : {1U, 7U, 1000U, 1U << 20}) {
+        passed = passed && write_matches(binary_path, true, block_capacity) ==
+                               expected_matches.size();
+        const BinaryMatchesReader reader(binary_path);
+        std::vector<Match> binary_matches;
+        for (std::size_t i = 0; i < reader.BlocksCount(); i++) {
+            const MatchesBlock block = reader.Block(i);
+            passed = passed && !block.offsets.empty() &&
+                     (block.offsets.size() == block_capacity ||
+                      i + 1 == reader.BlocksCount());
+            append_block(block, binary_matches);
+        }
+        passed = passed && reader.BlockCapacity() == block_capacity &&
+                 binary_matches == expected_matches;
+
+        passed = passed && write_matches(ndjson_path, false, block_capacity) ==
+                               expected_matches.size();
+        std::ifstream ndjson_file(ndjson_path);
+        std::vector<Match> ndjson_matches;
+        for (std::string line; std::getline(ndjson_file, line);) {
+            const auto offsets      = parse_numbers(line, "offsets");
+            const auto word_indexes = parse_numbers(line, "word_indexes");
+            const auto lengths      = parse_numbers(line, "lengths");
+            passed = passed && offsets.size() == word_indexes.size() &&
+                     offsets.size() == lengths.size();
+            for (std::size_t i = 0; i < offsets.size() && passed; i++) {
+                ndjson_matches.emplace_back(
+                    offsets[i],
+                    static_cast<ACTrie::WordLength>(word_indexes[i]),
+                    static_cast<ACTrie::WordLength>(lengths[i]));
+            }
+        }
+        passed = passed && ndjson_matches == expected_matches;
+        found_occurances_size += binary_matches.size();
+        expected_occurances_size += expected_matches.size();
+    }
+
+    // Text output is not taken for the binary one
+    bool is_rejected = false;
+    try {
+        const BinaryMatchesReader reader(ndjson_path);
+    } catch (const std::runtime_error&) {
+        is_rejected = true;
+    }
+    passed = passed && is_rejected;
+
+    // Corrupted numbers of the header and of the blocks are rejected: the
+    //  capacity with the overflowing block size and the matches count
+    //  greater than the capacity
+    auto is_corruption_rejected = [&](std::size_t position,
+                                      std::uint64_t value) {
+        write_matches(binary_path, true, 7);
+        {
+            std::fstream file(binary_path,
+                              std::ios::binary | std::ios::in | std::ios::out);
+            file.seekp(static_cast<std::streamoff>(position));
+            file.write(reinterpret_cast<const char*>(&value), sizeof(value));
+        }
+        try {
+            const BinaryMatchesReader reader(binary_path);
+        } catch (const std::runtime_error&) {
+            return true;
+        }
+        return false;
+    };
+    const std::size_t second_block_position =
+        BinaryMatchesWriter::kHeaderSize + BinaryMatchesWriter::BlockSize(7);
+    passed =
+        passed &&
+        is_corruption_rejected(
+            offsetof(BinaryMatchesWriter::BinaryMatchesHeader, block_capacity),
+            std::uint64_t{1} << 62) &&
+        is_corruption_rejected(second_block_position, 8) &&
+        !is_corruption_rejected(second_block_position, 7);
+    auto time_passed_millis = timer.TimePassed();
+    std::filesystem::remove_all(files_directory);
+    return {
+        .status = passed ? TestStatus::kPassed : TestStatus::kNotPassed,
+        .found_occurances_size    = found_occurances_size,
+        .expected_occurances_size = expected_occurances_size,
+        .patterns_size            = kPatternsSize,
+        .text_size                = text.size(),
+        .time_passed_millis       = time_passed_millis,
+    };
+}
+
+TestResult Test23Impl() {
+    using ACTrieDS::LineTracker;
+    using LineMatchMode = ACTrie::LineMatchMode;
+    // Start, word index, line index, line start
+    using LineOccurance = std::tuple<std::size_t, ACTrie::WordLength,
+                                     std::size_t, std::size_t>;
+    constexpr std::size_t kPatternsSize = 100;
+    constexpr std::size_t kTextLength   = 200000;
+    std::mt19937 rnd(23);
+
+    bool passed = true;
+    // Every symbol is a newline, byte counters are full before the sum
+    for (std::size_t length : {0U, 1U, 15U, 31U, 33U, 8160U, 8161U, 50000U}) {
+        passed = passed && LineTracker::CountNewlines(std::string(
+                               length, LineTracker::kNewline)) == length;
+    }
+    const std::string newlines_text =
+        GenerateRandomString(kTextLength, "ab\n", rnd);
+    for (std::size_t i = 0; i < 100; i++) {
+        const std::size_t start  = rnd() % newlines_text.size();
+        const std::size_t length = rnd() % (newlines_text.size() - start);
+        const std::string_view part =
+            std::string_view(newlines_text).substr(start, length);
+        passed = passed && LineTracker::CountNewlines(part) ==
+                               std::size_t(std::ranges::count(part, '\n'));
+    }
+
+    ACTrie actrie;
+    for (std::size_t i = 0; i < kPatternsSize; i++) {
+        actrie.AddPattern(GenerateRandomString(1 + rnd() % 5, "abcd", rnd),
+                          ACTrie::GroupsMask{1} << (i % 2));
+    }
+    actrie.BuildACTrie();
+    // Long and short lines, empty lines and "\r\n" line ends
+    std::string text;
+    while (text.size() < kTextLength) {
+        text += GenerateRandomString(rnd() % 3 == 0 ? rnd() % 400 : rnd() % 8,
+                                     "abcd", rnd);
+        text += rnd() % 5 == 0 ? "\r\n" : "\n";
+    }
+
+    std::vector<std::size_t> lines_indexes;
+    std::vector<std::size_t> lines_starts;
+    for (std::size_t i = 0, line_start = 0; i < text.size(); i++) {
+        lines_indexes.push_back(lines_starts.size());
+        if (text[i] == '\n') {
+            lines_starts.push_back(line_start);
+            line_start = i + 1;
+        }
+    }
+    lines_starts.push_back(text.rfind('\n') + 1);
+
+    std::size_t found_occurances_size    = 0;
+    std::size_t expected_occurances_size = 0;
+    Timer timer;
+    constexpr ACTrie::GroupsMask kGroupsMasks[] = {ACTrie::kAllGroups, 2};
+    for (ACTrie::GroupsMask groups : kGroupsMasks) {
+        std::vector<LineOccurance> expected_all;
+        std::vector<LineOccurance> expected_first;
+        actrie.FindAllSubstringsInText(
+            text, groups, [&](const ACTrie::FoundSubstringInfo& info) {
+                const std::size_t line_index =
+                    lines_indexes[info.substring_start_index];
+                expected_all.emplace_back(info.substring_start_index,
+                                          info.word_index, line_index,
+                                          lines_starts[line_index]);
+                if (expected_first.empty() ||
+                    std::get<2>(expected_first.back()) != line_index) {
+                    expected_first.push_back(expected_all.back());
+                }
+            });
+
+        for (LineMatchMode mode : {LineMatchMode::kAllSubstrings,
+                                   LineMatchMode::kFirstSubstringOfLine}) {
+            std::vector<LineOccurance> found;
+            actrie.FindSubstringsInLines(
+                text, groups, mode,
+                [&found](const ACTrie::FoundInLineInfo& info) {
+                    found.emplace_back(info.substring.substring_start_index,
+                                       info.substring.word_index,
+                                       info.line_index,
+                                       info.line_start_index);
+                });
+            const auto& expected = mode == LineMatchMode::kAllSubstrings
+                                       ? expected_all
+                                       : expected_first;
+            passed = passed && found == expected;
+            found_occurances_size += found.size();
+            expected_occurances_size += expected.size();
+        }
+    }
+    auto time_passed_millis = timer.TimePassed();
+    return {
+        .status = passed ? TestStatus::kPassed : TestStatus::kNotPassed,
+        .found_occurances_size    = found_occurances_size,
+        .expected_occurances_size = expected_occurances_size,
+        .patterns_size            = kPatternsSize,
+        .text_size                = text.size(),
+        .time_passed_millis       = time_passed_millis,
+    };
+}
+
+TestResult Test24Impl() {
+    using ACTrieDS::MatchRange;
+    constexpr std::size_t kPatternsSize = 200;
+    constexpr std::size_t kTextLength   = 100000;
+    constexpr std::size_t kTakenSize    = 5;
+    std::mt19937 rnd(24);
+
+    ACTrie actrie;
+    for (std::size_t i = 0; i < kPatternsSize; i++) {
+        actrie.AddPattern(GenerateRandomString(1 + rnd() % 6, "abcd", rnd),
+                          ACTrie::GroupsMask{1} << (i % 2));
+    }
+    actrie.BuildACTrie();
+    // Regions of 'x', 'y' and 'z' are skipped by the prefilter
+    const std::string text =
+        GenerateRandomString(kTextLength, "abcd#xyzxyz", rnd);
+    auto to_occurance = [](const ACTrie::FoundSubstringInfo& info) {
+        return Occurance(info.found_substring, info.substring_start_index,
+                         info.word_index);
+    };
+
+    bool passed = MatchRange().begin() == std::default_sentinel &&
+                  MatchRange(actrie, "#xyz").begin() == std::default_sentinel;
+    std::size_t found_occurances_size    = 0;
+    std::size_t expected_occurances_size = 0;
+    Timer timer;
+    constexpr ACTrie::GroupsMask kGroupsMasks[] = {ACTrie::kAllGroups, 2};
+    for (bool prefilter_enabled : {false, true}) {
+        actrie.SetPrefilterEnabled(prefilter_enabled);
+        passed = passed && actrie.IsPrefilterActive() == prefilter_enabled;
+        for (ACTrie::GroupsMask groups : kGroupsMasks) {
+            std::vector<Occurance> expected;
+            actrie.FindAllSubstringsInText(
+                text, groups, [&](const ACTrie::FoundSubstringInfo& info) {
+                    expected.push_back(to_occurance(info));
+                });
+
+            std::vector<Occurance> found;
+            for (const auto& info : MatchRange(actrie, text, groups)) {
+                found.push_back(to_occurance(info));
+            }
+            passed = passed && found == expected;
+            found_occurances_size += found.size();
+            expected_occurances_size += expected.size();
+
+            std::vector<Occurance> filtered;
+            auto is_even = [](const ACTrie::FoundSubstringInfo& info) {
+                return info.word_index % 2 == 0;
+            };
+            std::ranges::transform(
+                MatchRange(actrie, text, groups) | std::views::filter(is_even),
+                std::back_inserter(filtered), to_occurance);
+            std::vector<Occurance> expected_filtered;
+            std::ranges::copy_if(expected,
+                                 std::back_inserter(expected_filtered),
+                                 [](const Occurance& occurance) {
+                                     return std::get<2>(occurance) % 2 == 0;
+                                 });
+            passed = passed && filtered == expected_filtered;
+
+            // The last increment of take() finds one more substring, the
+            //  text after it is not scanned. The view itself is copied by the
+            //  adaptors, so the cursor is looked at through ref_view.
+            MatchRange range(actrie, text, groups);
+            std::vector<Occurance> taken;
+            std::ranges::transform(std::ranges::ref_view(range) |
+                                       std::views::take(kTakenSize),
+                                   std::back_inserter(taken), to_occurance);
+            if (expected.size() <= kTakenSize) {
+                passed = false;
+                continue;
+            }
+            const auto& [next_substring, next_start, _] = expected[kTakenSize];
+            passed = passed &&
+                     std::ranges::equal(
+                         taken, expected | std::views::take(kTakenSize)) &&
+                     range.Cursor().position ==
+                         next_start + next_substring.size();
+        }
+    }
+
+    // Empty pattern is found at the root, which ends the output chains
+    ACTrie empty_pattern_actrie;
+    empty_pattern_actrie.AddPattern("").AddPattern("ab").BuildACTrie();
+    constexpr std::string_view kEmptyPatternText = "ab.xab";
+    std::vector<Occurance> expected_empty_pattern_occurances;
+    empty_pattern_actrie.FindAllSubstringsInText(
+        kEmptyPatternText, [&](const ACTrie::FoundSubstringInfo& info) {
+            expected_empty_pattern_occurances.push_back(to_occurance(info));
+        });
+    std::vector<Occurance> empty_pattern_occurances;
+    std::ranges::transform(MatchRange(empty_pattern_actrie, kEmptyPatternText),
+                           std::back_inserter(empty_pattern_occurances),
+                           to_occurance);
+    passed = passed && expected_empty_pattern_occurances.size() == 4 &&
+             empty_pattern_occurances == expected_empty_pattern_occurances;
+    found_occurances_size += empty_pattern_occurances.size();
+    expected_occurances_size += expected_empty_pattern_occurances.size();
+    auto time_passed_millis = timer.TimePassed();
+    return {
+        .status = passed ? TestStatus::kPassed : TestStatus::kNotPassed,
+        .found_occurances_size    = found_occurances_size,
+        .expected_occurances_size = expected_occurances_size,
+        .patterns_size            = kPatternsSize,
+        .text_size                = text.size(),
+        .time_passed_millis       = time_passed_millis,
+    };
+}
+
+TestResult Test25Impl() {
+    using ACTrieDS::FileStreamSource;
+    using ACTrieDS::MemoryStreamSource;
+    using ACTrieDS::ScanPipeline;
+    using ACTrieDS::ScanTask;
+    using ACTrieDS::StreamScheduler;
+    using ACTrieDS::StreamSource;
+    using Match                         = ScanPipeline::Match;
+    constexpr std::size_t kPatternsSize = 300;
+    constexpr std::size_t kStreamsSize  = 2000;
+    std::mt19937 rnd(25);
+    ACTrie actrie;
+    for (const std::string& pattern :
+         GenerateRandomPatterns(kPatternsSize, 6, rnd)) {
+        actrie.AddPattern(pattern);
+    }
+    actrie.AddPattern("abcdabcdabcdabcdabcd");
+    actrie.BuildACTrie();
+
+    std::vector<std::string> texts;
+    std::size_t texts_length = 0;
+    for (std::size_t i = 0; i < kStreamsSize; i++) {
+        texts.push_back(
+            GenerateRandomString(rnd() % 2000, kRandomTextSymbols, rnd));
+        if (i % 10 == 0) {
+            texts.back() += "abcdabcdabcdabcdabcd";
+        }
+        texts_length += texts.back().size();
+    }
+    auto match_equal = [](const Match& lhs, const Match& rhs) {
+        return std::tie(lhs.offset, lhs.length, lhs.word_index) ==
+               std::tie(rhs.offset, rhs.length, rhs.word_index);
+    };
+    std::vector<std::vector<Match>> expected_matches(kStreamsSize);
+    for (std::size_t i = 0; i < kStreamsSize; i++) {
+        actrie.FindAllSubstringsInText(
+            texts[i], [&](const ACTrie::FoundSubstringInfo& info) {
+                expected_matches[i].push_back(Match{
+                    .offset     = info.substring_start_index,
+                    .word_index = info.word_index,
+                    .length = ACTrie::WordLength(info.found_substring.size()),
+                });
+            });
+    }
+
+    class CollectingSink final : public ScanPipeline::MatchesSink {
+    public:
+        explicit CollectingSink(std::size_t sources_size)
+            : matches(sources_size) {}
+        void OnMatches(const ScanPipeline::MatchesBatch& batch) override {
+            std::lock_guard lock(mutex);
+            std::vector<Match>& source_matches = matches[batch.source_index];
+            source_matches.insert(source_matches.end(), batch.matches.begin(),
+                                  batch.matches.end());
+        }
+
+        std::mutex mutex;
+        std::vector<std::vector<Match>> matches;
+    };
+
+    struct SchedulerConfig final {
+        std::size_t threads;
+        std::size_t buffer_size;
+        std::size_t batch_capacity;
+        std::size_t not_ready_period;
+    };
+    constexpr SchedulerConfig kConfigs[] = {
+        {1, StreamScheduler::kDefaultBufferSize,
+         StreamScheduler::kDefaultBatchCapacity, 0},
+        {1, 7, 1, 2},
+        {3, 100, 7, 3},
+        {4, 19, 50, 5},
+    };
+    // Batches of a stream come in order, so the matches are not sorted
+    std::size_t found_occurances_size    = 0;
+    std::size_t expected_occurances_size = 0;
+    bool passed                          = true;
+    Timer timer;
+    for (const SchedulerConfig& config : kConfigs) {
+        std::vector<MemoryStreamSource> sources;
+        std::vector<StreamSource*> sources_pointers;
+        for (const std::string& text : texts) {
+            sources.emplace_back(text, 1 + rnd() % 300,
+                                 config.not_ready_period);
+        }
+        for (MemoryStreamSource& source : sources) {
+            sources_pointers.push_back(&source);
+        }
+        CollectingSink sink(kStreamsSize);
+        StreamScheduler scheduler(actrie, config.threads);
+        scheduler.SetBuffers(config.buffer_size, config.batch_capacity)
+            .Run(sources_pointers, sink);
+        for (std::size_t i = 0; i < kStreamsSize; i++) {
+            passed = passed && std::ranges::equal(sink.matches[i],
+                                                  expected_matches[i],
+                                                  match_equal);
+            found_occurances_size += sink.matches[i].size();
+            expected_occurances_size += expected_matches[i].size();
+        }
+        const StreamScheduler::Stats& stats = scheduler.GetStats();
+        passed = passed && (config.not_ready_period == 0) ==
+                               (stats.not_ready_count == 0);
+    }
+
+    // File-backed stream
+    const std::filesystem::path path =
+        std::filesystem::temp_directory_path() / "actrie_test_25.txt";
+    std::ofstream(path, std::ios::binary) << texts[10];
+    std::FILE* file = std::fopen(path.string().c_str(), "rb");
+    if (file == nullptr) {
+        return {TestStatus::kNotPassed, {}, {}, {}, {}, {}};
+    }
+    FileStreamSource file_source(file);
+    StreamSource* file_sources[] = {&file_source};
+    CollectingSink file_sink(1);
+    StreamScheduler(actrie).SetBuffers(13, 3).Run(file_sources, file_sink);
+    std::fclose(file);
+    std::filesystem::remove(path);
+    passed = passed && std::ranges::equal(file_sink.matches[0],
+                                          expected_matches[10], match_equal);
+
+    // Error of a task is rethrown after the other tasks finish
+    class FailingSource final : public StreamSource {
+    public:
+        ReadResult TryRead(std::span<char> buffer) override {
+            if (reads_count_++ == 3) {
+                throw std::runtime_error("read failed");
+            }
+            std::fill(buffer.begin(), buffer.end(), 'a');
+            return {.status = ReadStatus::kRead, .size = buffer.size()};
+        }
+
+    private:
+        std::size_t reads_count_ = 0;
+    };
+    FailingSource failing_source;
+    MemoryStreamSource text_source(texts[0], 10, 2);
+    CollectingSink sink(2);
+    std::vector<ScanTask> tasks;
+    tasks.push_back(ACTrieDS::ScanStream(actrie, failing_source, 0, 64, 16));
+    tasks.push_back(ACTrieDS::ScanStream(actrie, text_source, 1, 64, 16));
+    bool thrown = false;
+    try {
+        StreamScheduler(actrie, 2).Run(tasks, sink);
+    } catch (const std::runtime_error&) {
+        thrown = true;
+    }
+    passed = passed && thrown &&
+             std::ranges::equal(sink.matches[1], expected_matches[0],
+                                match_equal);
+    auto time_passed_millis = timer.TimePassed();
+    return {
+        .status = passed ? TestStatus::kPassed : TestStatus::kNotPassed,
+        .found_occurances_size    = found_occurances_size,
+        .expected_occurances_size = expected_occurances_size,
+        .patterns_size            = kPatternsSize + 1,
+        .text_size                = texts_length,
+        .time_passed_millis       = time_passed_millis,
+    };
+}
+
+/// @brief Scans the text by the small budgets and checks that the resumed
+///         scans find the same substrings as one scan, with the long output
+///         chains stopped in the middle, and with the observers.
+TestResult Test26Impl() {
+    constexpr std::size_t kPatternsSize = 100;
+    constexpr std::size_t kTextLength   = 50000;
+    constexpr std::size_t kMax = std::numeric_limits<std::size_t>::max();
+    std::mt19937 rnd(26);
+
+    ACTrie actrie;
+    // Nested suffixes give the long output chains
+    for (std::size_t length = 1; length <= 8; length++) {
+        actrie.AddPattern(std::string(length, 'a'));
+    }
+    for (std::size_t i = 0; i < kPatternsSize; i++) {
+        actrie.AddPattern(GenerateRandomString(1 + rnd() % 6, "ab", rnd),
+                          ACTrie::GroupsMask{1} << (i % 2));
+    }
+    actrie.BuildACTrie();
+    const std::string text =
+        GenerateRandomString(kTextLength, "aaaab#xyzxyz", rnd);
+    auto to_occurance = [](const ACTrie::FoundSubstringInfo& info) {
+        return Occurance(info.found_substring, info.substring_start_index,
+                         info.word_index);
+    };
+
+    constexpr ACTrie::ScanBudget kBudgets[] = {
+        {.max_symbols_count = 1, .max_found_substrings_count = 1},
+        {.max_symbols_count = 1, .max_found_substrings_count = kMax},
+        {.max_symbols_count = 7, .max_found_substrings_count = 3},
+        {.max_symbols_count = kMax, .max_found_substrings_count = 1},
+        {.max_symbols_count = 1000, .max_found_substrings_count = 50},
+    };
+    constexpr ACTrie::GroupsMask kGroupsMasks[] = {ACTrie::kAllGroups, 2};
+    bool passed                          = true;
+    std::size_t found_occurances_size    = 0;
+    std::size_t expected_occurances_size = 0;
+    Timer timer;
+    for (bool prefilter_enabled : {false, true}) {
+        actrie.SetPrefilterEnabled(prefilter_enabled);
+        for (ACTrie::GroupsMask groups : kGroupsMasks) {
+            std::vector<Occurance> expected;
+            actrie.FindAllSubstringsInText(
+                text, groups, [&](const ACTrie::FoundSubstringInfo& info) {
+                    expected.push_back(to_occurance(info));
+                });
+            for (const ACTrie::ScanBudget& budget : kBudgets) {
+                std::vector<Occurance> found;
+                ACTrie::ScanCursor cursor;
+                bool finished = false;
+                while (!finished) {
+                    const std::size_t start_position = cursor.position;
+                    const std::size_t found_size     = found.size();
+                    finished = actrie.FindAllSubstringsInText(
+                        text, groups, cursor, budget,
+                        [&](const ACTrie::FoundSubstringInfo& info) {
+                            found.push_back(to_occurance(info));
+                        });
+                    passed =
+                        passed &&
+                        cursor.position - start_position <=
+                            budget.max_symbols_count &&
+                        found.size() - found_size <=
+                            budget.max_found_substrings_count;
+                }
+                passed = passed && cursor.position == text.size() &&
+                         found == expected;
+                found_occurances_size += found.size();
+                expected_occurances_size += expected.size();
+            }
+        }
+    }
+
+    // Empty pattern is found at the root, after each symbol outside the
+    //  patterns
+    ACTrie empty_pattern_actrie;
+    empty_pattern_actrie.AddPattern("").AddPattern("ab").BuildACTrie();
+    constexpr std::string_view kEmptyPatternText      = "ab.xab";
+    constexpr std::size_t kEmptyPatternOccurancesSize = 4;
+    for (const ACTrie::ScanBudget& budget : kBudgets) {
+        std::vector<Occurance> found;
+        ACTrie::ScanCursor cursor;
+        while (!empty_pattern_actrie.FindAllSubstringsInText(
+            kEmptyPatternText, ACTrie::kAllGroups, cursor, budget,
+            [&](const ACTrie::FoundSubstringInfo& info) {
+                found.push_back(to_occurance(info));
+            })) {
+        }
+        passed = passed && found.size() == kEmptyPatternOccurancesSize;
+        found_occurances_size += found.size();
+        expected_occurances_size += kEmptyPatternOccurancesSize;
+    }
+
+    // Observers get the same notifications as from one scan
+    std::vector<Occurance> found_occurances;
+    std::vector<ACTrie::VertexIndex> passed_nodes;
+    ACTrie::FoundSubstringObserver found_substrings_obs(
+        [&](ACTrie::FoundSubstringInfoPassBy info) {
+            found_occurances.push_back(to_occurance(info));
+        });
+    ACTrie::PassingThroughObserver passing_through_obs(
+        [&passed_nodes](ACTrie::PassingThroughInfoPassBy node_index) {
+            passed_nodes.push_back(node_index);
+        });
+    actrie.AddSubscriber(&found_substrings_obs);
+    actrie.AddSubscriber(&passing_through_obs);
+    actrie.FindAllSubstringsInText(text);
+    const std::vector<Occurance> expected_occurances =
+        std::exchange(found_occurances, {});
+    const std::vector<ACTrie::VertexIndex> expected_nodes =
+        std::exchange(passed_nodes, {});
+    ACTrie::ScanCursor cursor;
+    while (!actrie.FindAllSubstringsInText(text, cursor, kBudgets[2])) {
+    }
+    passed = passed && found_occurances == expected_occurances &&
+             passed_nodes == expected_nodes;
+    auto time_passed_millis = timer.TimePassed();
+    return {
+        .status = passed ? TestStatus::kPassed : TestStatus::kNotPassed,
+        .found_occurances_size    = found_occurances_size,
+        .expected_occurances_size = expected_occurances_size,
+        .patterns_size            = kPatternsSize + 8,
+        .text_size                = text.size(),
+        .time_passed_millis       = time_passed_millis,
+    };
+}
+
+/// @brief Checks the patterns with the wildcards against the naive matching
+///         and the reporting order of the ACTrie.
+TestResult Test27Impl() {
+    using ACTrieDS::WildcardMatcher;
+    constexpr std::size_t kPatternsSize     = 300;
+    constexpr std::size_t kMaxPatternLength = 10;
+    constexpr std::size_t kTextLength       = 50000;
+    std::mt19937 rnd(27);
+
+    std::vector<std::string> patterns;
+    while (patterns.size() < kPatternsSize) {
+        std::string pattern = GenerateRandomString(
+            1 + rnd() % kMaxPatternLength, "ab?", rnd);
+        if (pattern.find_first_not_of(WildcardMatcher::kAnySymbol) !=
+            std::string::npos) {
+            patterns.push_back(std::move(pattern));
+        }
+    }
+    patterns.push_back(patterns.front());
+    // Empty pattern takes its index but is never reported
+    patterns.insert(patterns.begin() + 1, "");
+    // Wildcards match the symbols outside the alphabet too
+    const std::string text = GenerateRandomString(kTextLength, "abab#", rnd);
+
+    std::unordered_map<std::string_view, ACTrie::WordLength> patterns_indexes;
+    for (std::size_t i = 0; i < patterns.size(); i++) {
+        patterns_indexes[patterns[i]] = ACTrie::WordLength(i);
+    }
+    std::vector<Occurance> expected_occurances;
+    for (std::size_t start = 0; start < text.size(); start++) {
+        for (const auto& [pattern, word_index] : patterns_indexes) {
+            if (pattern.empty() || text.size() - start < pattern.size()) {
+                continue;
+            }
+            bool matched = true;
+            for (std::size_t i = 0; i < pattern.size() && matched; i++) {
+                matched = pattern[i] == WildcardMatcher::kAnySymbol ||
+                          pattern[i] == text[start + i];
+            }
+            if (matched) {
+                expected_occurances.emplace_back(
+                    std::string_view(text).substr(start, pattern.size()),
+                    start, word_index);
+            }
+        }
+    }
+
+    WildcardMatcher matcher;
+    Timer timer;
+    const std::vector<Occurance> found_occurances =
+        FindOccurances(matcher, patterns, text);
+    auto time_passed_millis = timer.TimePassed();
+    bool passed = matcher.PatternsSize() == patterns.size() &&
+                  matcher.FragmentsSize() != 0 &&
+                  AreSameOccurancesInACTrieOrder(found_occurances,
+                                                 expected_occurances);
+
+    // Bad symbol and the pattern without the fixed symbols are rejected
+    WildcardMatcher bad_input_matcher;
+    std::vector<std::pair<std::size_t, char>> bad_inputs;
+    WildcardMatcher::BadInputPatternObserver bad_input_obs(
+        [&bad_inputs](WildcardMatcher::BadInputPatternInfoPassBy info) {
+            bad_inputs.emplace_back(info.symbol_index, info.bad_symbol);
+        });
+    bad_input_matcher.AddSubscriber(&bad_input_obs);
+    bad_input_matcher.AddPattern("a?%b").AddPattern("???").AddPattern("?b?");
+    const std::vector<std::pair<std::size_t, char>> expected_bad_inputs = {
+        {2, '%'},
+        {2, WildcardMatcher::kAnySymbol},
+    };
+    passed = passed && bad_inputs == expected_bad_inputs &&
+             bad_input_matcher.PatternsSize() == 1;
+    return {
+        .status = passed ? TestStatus::kPassed : TestStatus::kNotPassed,
+        .found_occurances_size    = found_occurances.size(),
+        .expected_occurances_size = expected_occurances.size(),
+        .patterns_size            = patterns.size(),
+        .text_size                = text.size(),
+        .time_passed_millis       = time_passed_millis,
+    };
+}
+
+/// @brief Checks the patterns with the classes against the naive matching,
+///         also with the states limit hit by the scan.
+TestResult Test28Impl() {
+    using ACTrieDS::ClassPatternMatcher;
+    using SymbolsSet = ClassPatternMatcher::SymbolsSet;
+    constexpr std::size_t kPatternsSize     = 200;
+    constexpr std::size_t kMaxPatternLength = 6;
+    constexpr std::size_t kTextLength       = 30000;
+    constexpr std::string_view kTextSymbols = "aabcd#";
+    std::mt19937 rnd(28);
+
+    auto make_set = [kTextSymbols](auto is_in_set) {
+        SymbolsSet set;
+        for (char symbol : kTextSymbols) {
+            set.set(static_cast<std::uint8_t>(symbol), is_in_set(symbol));
+        }
+        return set;
+    };
+    const std::pair<std::string_view, SymbolsSet> kElements[] = {
+        {"a", make_set([](char c) { return c == 'a'; })},
+        {"b", make_set([](char c) { return c == 'b'; })},
+        {"[ab]", make_set([](char c) { return c == 'a' || c == 'b'; })},
+        {"[^a]", make_set([](char c) { return c != 'a'; })},
+        {".", make_set([](char) { return true; })},
+        {"[b-d]", make_set([](char c) { return 'b' <= c && c <= 'd'; })},
+        {"\\#", make_set([](char c) { return c == '#'; })},
+        {"[\\#a-a]", make_set([](char c) { return c == '#' || c == 'a'; })},
+    };
+    // Each element has its own set, so the patterns with the same sets are
+    //  the same strings
+    std::vector<std::string> patterns;
+    std::vector<std::vector<SymbolsSet>> patterns_sets;
+    for (std::size_t i = 0; i < kPatternsSize; i++) {
+        std::string& pattern          = patterns.emplace_back();
+        std::vector<SymbolsSet>& sets = patterns_sets.emplace_back();
+        for (std::size_t length = 1 + rnd() % kMaxPatternLength; length > 0;
+             length--) {
+            const auto& [element, set] =
+                kElements[rnd() % std::size(kElements)];
+            pattern += element;
+            sets.push_back(set);
+        }
+    }
+    patterns.push_back(patterns.front());
+    patterns_sets.push_back(patterns_sets.front());
+    const std::string text =
+        GenerateRandomString(kTextLength, kTextSymbols, rnd);
+
+    std::unordered_map<std::string_view, ACTrie::WordLength> patterns_indexes;
+    for (std::size_t i = 0; i < patterns.size(); i++) {
+        patterns_indexes[patterns[i]] = ACTrie::WordLength(i);
+    }
+    std::vector<Occurance> expected_occurances;
+    for (std::size_t start = 0; start < text.size(); start++) {
+        for (const auto& [pattern, word_index] : patterns_indexes) {
+            const std::vector<SymbolsSet>& sets = patterns_sets[word_index];
+            if (text.size() - start < sets.size()) {
+                continue;
+            }
+            bool matched = true;
+            for (std::size_t i = 0; i < sets.size() && matched; i++) {
+                matched = sets[i].test(
+                    static_cast<std::uint8_t>(text[start + i]));
+            }
+            if (matched) {
+                expected_occurances.emplace_back(
+                    std::string_view(text).substr(start, sets.size()), start,
+                    word_index);
+            }
+        }
+    }
+
+    ClassPatternMatcher matcher;
+    Timer timer;
+    const std::vector<Occurance> found_occurances =
+        FindOccurances(matcher, patterns, text);
+    auto time_passed_millis = timer.TimePassed();
+    // Tiny limit drops the states during the scan
+    ClassPatternMatcher limited_matcher(3);
+    const std::vector<Occurance> limited_found_occurances =
+        FindOccurances(limited_matcher, patterns, text);
+    bool passed = matcher.PatternsSize() == patterns.size() &&
+                  matcher.IsFullyCompiled() &&
+                  matcher.SymbolsClassesSize() == 5 &&
+                  !limited_matcher.IsFullyCompiled() &&
+                  limited_matcher.StatesFlushesCount() != 0 &&
+                  AreSameOccurancesInACTrieOrder(found_occurances,
+                                                 expected_occurances) &&
+                  AreSameOccurancesInACTrieOrder(limited_found_occurances,
+                                                 expected_occurances);
+    // Patterns of the same length found at the same position are ordered by
+    //  the word index, whichever states are built
+    auto report_order = [](const Occurance& occurance) {
+        const auto& [substring, start, word_index] = occurance;
+        return std::tuple(start + substring.size(),
+                          std::numeric_limits<std::size_t>::max() -
+                              substring.size(),
+                          word_index);
+    };
+    std::ranges::sort(expected_occurances, std::less{}, report_order);
+    passed = passed && found_occurances == expected_occurances &&
+             limited_found_occurances == expected_occurances;
+
+    ClassPatternMatcher bad_input_matcher;
+    std::vector<std::pair<std::size_t, char>> bad_inputs;
+    ClassPatternMatcher::BadInputPatternObserver bad_input_obs(
+        [&bad_inputs](ClassPatternMatcher::BadInputPatternInfoPassBy info) {
+            bad_inputs.emplace_back(info.symbol_index, info.bad_symbol);
+        });
+    bad_input_matcher.AddSubscriber(&bad_input_obs);
+    bad_input_matcher.AddPattern("a[bc")
+        .AddPattern("a[]")
+        .AddPattern("[z-a]")
+        .AddPattern("ab]")
+        .AddPattern("ab\\")
+        .AddPattern("[^\\]-]x\\.");
+    const std::vector<std::pair<std::size_t, char>> expected_bad_inputs = {
+        {1, '['}, {2, ']'}, {3, 'a'}, {2, ']'}, {2, '\\'},
+    };
+    passed = passed && bad_inputs == expected_bad_inputs &&
+             bad_input_matcher.PatternsSize() == 1;
+    return {
+        .status = passed ? TestStatus::kPassed : TestStatus::kNotPassed,
+        .found_occurances_size    = found_occurances.size(),
+        .expected_occurances_size = expected_occurances.size(),
+        .patterns_size            = patterns.size(),
+        .text_size                = text.size(),
+        .time_passed_millis       = time_passed_millis,
+    };
+}
+
+/// @brief Patterns without the classes are found like by the ACTrie.
+TestResult Test29Impl() {
+    return DifferentialTestImpl<ACTrieDS::ClassPatternMatcher>(300, 1, 12,
+                                                               1e6, "abcXYZ#");
+}
+
+/// @brief Checks the matching with at most 0, 1 and 2 mismatches against the
+///         naive matching, and the reported numbers of the mismatches.
+TestResult Test30Impl() {
+    using ACTrieDS::ApproximateMatcher;
+    constexpr std::size_t kPatternsSize = 200;
+    constexpr std::size_t kTextLength   = 20000;
+    std::mt19937 rnd(30);
+
+    std::vector<std::string> patterns;
+    for (std::size_t i = 0; i < kPatternsSize; i++) {
+        patterns.push_back(GenerateRandomString(3 + rnd() % 8, "abc", rnd));
+    }
+    patterns.push_back(patterns.front());
+    // Empty pattern takes its index but is never reported
+    patterns.insert(patterns.begin() + 1, "");
+    const std::string text = GenerateRandomString(kTextLength, "abcc#", rnd);
+    std::unordered_map<std::string_view, ACTrie::WordLength> patterns_indexes;
+    for (std::size_t i = 0; i < patterns.size(); i++) {
+        patterns_indexes[patterns[i]] = ACTrie::WordLength(i);
+    }
+    auto count_mismatches = [](std::string_view lhs, std::string_view rhs) {
+        std::size_t mismatches_count = 0;
+        for (std::size_t i = 0; i < lhs.size(); i++) {
+            if (lhs[i] != rhs[i]) {
+                mismatches_count++;
+            }
+        }
+        return mismatches_count;
+    };
+
+    bool passed                          = true;
+    std::size_t found_occurances_size    = 0;
+    std::size_t expected_occurances_size = 0;
+    Timer timer;
+    constexpr std::size_t kMaxMismatches[] = {0, 1, 2};
+    for (std::size_t max_mismatches : kMaxMismatches) {
+        std::vector<Occurance> expected_occurances;
+        for (std::size_t start = 0; start < text.size(); start++) {
+            for (const auto& [pattern, word_index] : patterns_indexes) {
+                if (pattern.empty() ||
+                    text.size() - start < pattern.size()) {
+                    continue;
+                }
+                const std::string_view substring =
+                    std::string_view(text).substr(start, pattern.size());
+                if (count_mismatches(substring, pattern) <= max_mismatches) {
+                    expected_occurances.emplace_back(substring, start,
+                                                     word_index);
+                }
+            }
+        }
+
+        ApproximateMatcher matcher(max_mismatches);
+        bool mismatches_counted = true;
+        ApproximateMatcher::FoundApproximateObserver found_approximate_obs(
+            [&](ApproximateMatcher::FoundApproximateInfoPassBy info) {
+                mismatches_counted =
+                    mismatches_counted &&
+                    info.mismatches_count ==
+                        count_mismatches(info.substring.found_substring,
+                                         patterns[info.substring.word_index]);
+            });
+        matcher.AddSubscriber(&found_approximate_obs);
+        const std::vector<Occurance> found_occurances =
+            FindOccurances(matcher, patterns, text);
+        passed = passed && mismatches_counted &&
+                 matcher.PatternsSize() == patterns.size() &&
+                 matcher.FragmentsSize() != 0 &&
+                 AreSameOccurancesInACTrieOrder(found_occurances,
+                                                expected_occurances);
+        found_occurances_size += found_occurances.size();
+        expected_occurances_size += expected_occurances.size();
+    }
+    auto time_passed_millis = timer.TimePassed();
+
+    // Each of the 3 fragments must have a symbol
+    ApproximateMatcher bad_input_matcher(2);
+    std::vector<std::pair<std::size_t, char>> bad_inputs;
+    ApproximateMatcher::BadInputPatternObserver bad_input_obs(
+        [&bad_inputs](ApproximateMatcher::BadInputPatternInfoPassBy info) {
+            bad_inputs.emplace_back(info.symbol_index, info.bad_symbol);
+        });
+    bad_input_matcher.AddSubscriber(&bad_input_obs);
+    bad_input_matcher.AddPattern("ab").AddPattern("a#cd").AddPattern("abc");
+    const std::vector<std::pair<std::size_t, char>> expected_bad_inputs = {
+        {1, 'b'},
+        {1, '#'},
+    };
+    passed = passed && bad_inputs == expected_bad_inputs &&
+             bad_input_matcher.PatternsSize() == 1;
+    return {
+        .status = passed ? TestStatus::kPassed : TestStatus::kNotPassed,
+        .found_occurances_size    = found_occurances_size,
+        .expected_occurances_size = expected_occurances_size,
+        .patterns_size            = patterns.size(),
+        .text_size                = text.size(),
+        .time_passed_millis       = time_passed_millis,
+    };
+}
+
+/// @brief Checks the matching of the multilingual patterns with and without
+///         the case folding against the naive matching by the code points.
+TestResult Test31Impl() {
+    using ACTrieDS::Utf8Matcher;
+    namespace Utf8 = ACTrieDS::Utf8;
+    constexpr std::size_t kPatternsSize = 150;
+    constexpr std::size_t kWordsSize    = 20000;
+    // Words in the different scripts and cases, with the case variants of
+    //  the different lengths in bytes, and the invalid sequences
+    constexpr std::string_view kValidWords[] = {
+        "error",
+        "ERROR",
+        // привет, ПРИВЕТ
+        "\xD0\xBF\xD1\x80\xD0\xB8\xD0\xB2\xD0\xB5\xD1\x82",
+        "\xD0\x9F\xD0\xA0\xD0\x98\xD0\x92\xD0\x95\xD0\xA2",
+        // σοφός with the final sigma, ΣΟΦΌΣ
+        "\xCF\x83\xCE\xBF\xCF\x86\xCF\x8C\xCF\x82",
+        "\xCE\xA3\xCE\x9F\xCE\xA6\xCE\x8C\xCE\xA3",
+        // straße, STRAẞE with the capital sharp s
+        "stra\xC3\x9F"
+        "e",
+        "STRA\xE1\xBA\x9E"
+        "E",
+        // Kelvin with the Kelvin sign, kelvin
+        "\xE2\x84\xAA"
+        "elvin",
+        "kelvin",
+        // ſtop with the long s, Stop
+        "\xC5\xBF"
+        "top",
+        "Stop",
+        // 日本語, grinning face emoji
+        "\xE6\x97\xA5\xE6\x9C\xAC\xE8\xAA\x9E",
+        "\xF0\x9F\x98\x80",
+    };
+    constexpr std::string_view kInvalidWords[] = {"\xFF", "\xE2\x82", "\x80"};
+    constexpr char32_t kInvalidCodePoint       = Utf8::kMaxCodePoint + 1;
+    std::mt19937 rnd(31);
+
+    // Code points (folded if fold_case) and their offsets, with the size of
+    //  the str as the last offset. Invalid byte is one kInvalidCodePoint.
+    auto decode = [kInvalidCodePoint](std::string_view str, bool fold_case) {
+        std::pair<std::vector<char32_t>, std::vector<std::size_t>> decoded;
+        auto& [code_points, offsets] = decoded;
+        for (std::size_t i = 0; i < str.size();) {
+            const auto [code_point, length] = Utf8::DecodeCodePoint(str, i);
+            offsets.push_back(i);
+            if (length == 0) {
+                code_points.push_back(kInvalidCodePoint);
+                i++;
+                continue;
+            }
+            code_points.push_back(fold_case ? Utf8::SimpleCaseFold(code_point)
+                                            : code_point);
+            i += length;
+        }
+        offsets.push_back(str.size());
+        return decoded;
+    };
+
+    std::string text;
+    for (std::size_t i = 0; i < kWordsSize; i++) {
+        text += rnd() % 50 == 0
+                    ? kInvalidWords[rnd() % std::size(kInvalidWords)]
+                    : kValidWords[rnd() % std::size(kValidWords)];
+        text += rnd() % 4 == 0 ? "" : " ";
+    }
+    std::vector<std::string> patterns;
+    for (std::size_t i = 0; i < kPatternsSize; i++) {
+        const std::string_view word =
+            kValidWords[rnd() % std::size(kValidWords)];
+        const std::vector<std::size_t> offsets = decode(word, false).second;
+        const std::size_t code_points_size     = offsets.size() - 1;
+        const std::size_t length = 1 + rnd() % std::min<std::size_t>(
+                                               code_points_size, 4);
+        const std::size_t start = rnd() % (code_points_size - length + 1);
+        patterns.emplace_back(word.substr(
+            offsets[start], offsets[start + length] - offsets[start]));
+    }
+    patterns.push_back(patterns.front());
+    // Empty pattern takes its index but is never reported
+    patterns.insert(patterns.begin() + 1, "");
+
+    bool passed                          = true;
+    std::size_t found_occurances_size    = 0;
+    std::size_t expected_occurances_size = 0;
+    Timer timer;
+    for (bool fold_case : {false, true}) {
+        const auto [text_code_points, text_offsets] = decode(text, fold_case);
+        std::map<std::vector<char32_t>, ACTrie::WordLength> patterns_indexes;
+        for (std::size_t i = 0; i < patterns.size(); i++) {
+            patterns_indexes[decode(patterns[i], fold_case).first] =
+                ACTrie::WordLength(i);
+        }
+        std::vector<Occurance> expected_occurances;
+        for (const auto& [pattern, word_index] : patterns_indexes) {
+            if (pattern.empty()) {
+                continue;
+            }
+            for (std::size_t start = 0;
+                 start + pattern.size() <= text_code_points.size(); start++) {
+                if (std::equal(pattern.begin(), pattern.end(),
+                               text_code_points.begin() +
+                                   std::ptrdiff_t(start))) {
+                    const std::size_t begin = text_offsets[start];
+                    const std::size_t end =
+                        text_offsets[start + pattern.size()];
+                    expected_occurances.emplace_back(
+                        std::string_view(text).substr(begin, end - begin),
+                        begin, word_index);
+                }
+            }
+        }
+
+        Utf8Matcher matcher(fold_case);
+        const std::vector<Occurance> found_occurances =
+            FindOccurances(matcher, patterns, text);
+        passed = passed && matcher.IsCaseFolding() == fold_case &&
+                 matcher.PatternsSize() == patterns.size() &&
+                 AreSameOccurancesInACTrieOrder(found_occurances,
+                                                expected_occurances);
+        found_occurances_size += found_occurances.size();
+        expected_occurances_size += expected_occurances.size();
+    }
+    auto time_passed_millis = timer.TimePassed();
+
+    Utf8Matcher bad_input_matcher;
+    std::vector<std::pair<std::size_t, char>> bad_inputs;
+    Utf8Matcher::BadInputPatternObserver bad_input_obs(
+        [&bad_inputs](Utf8Matcher::BadInputPatternInfoPassBy info) {
+            bad_inputs.emplace_back(info.symbol_index, info.bad_symbol);
+        });
+    bad_input_matcher.AddSubscriber(&bad_input_obs);
+    // Truncated, unexpected continuation byte, overlong, surrogate
+    bad_input_matcher.AddPattern("\xC3")
+        .AddPattern("ab\x80")
+        .AddPattern("a\xC0\x80")
+        .AddPattern("\xED\xA0\x80")
+        .AddPattern("ok");
+    const std::vector<std::pair<std::size_t, char>> expected_bad_inputs = {
+        {0, '\xC3'},
+        {2, '\x80'},
+        {1, '\xC0'},
+        {0, '\xED'},
+    };
+    passed = passed && bad_inputs == expected_bad_inputs &&
+             bad_input_matcher.PatternsSize() == 1;
+    return {
+        .status = passed ? TestStatus::kPassed : TestStatus::kNotPassed,
+        .found_occurances_size    = found_occurances_size,
+        .expected_occurances_size = expected_occurances_size,
+        .patterns_size            = patterns.size(),
+        .text_size                = text.size(),
+        .time_passed_millis       = time_passed_millis,
+    };
+}
+
 void RunTestWrapper(std::function<TestResult()> test_functions,
                     std::uint32_t test_number) noexcept {
     try {
@@ -232,6 +2551,33 @@ void RunTests() noexcept {
     RunTestWrapper(Test2Impl, 2);
     RunTestWrapper(Test3Impl, 3);
     RunTestWrapper(Test4Impl, 4);
+    RunTestWrapper(Test5Impl, 5);
+    RunTestWrapper(Test6Impl, 6);
+    RunTestWrapper(Test7Impl, 7);
+    RunTestWrapper(Test8Impl, 8);
+    RunTestWrapper(Test9Impl, 9);
+    RunTestWrapper(Test10Impl, 10);
+    RunTestWrapper(Test11Impl, 11);
+    RunTestWrapper(Test12Impl, 12);
+    RunTestWrapper(Test13Impl, 13);
+    RunTestWrapper(Test14Impl, 14);
+    RunTestWrapper(Test15Impl, 15);
+    RunTestWrapper(Test16Impl, 16);
+    RunTestWrapper(Test17Impl, 17);
+    RunTestWrapper(Test18Impl, 18);
+    RunTestWrapper(Test19Impl, 19);
+    RunTestWrapper(Test20Impl, 20);
+    RunTestWrapper(Test21Impl, 21);
+    RunTestWrapper(Test22Impl, 22);
+    RunTestWrapper(Test23Impl, 23);
+    RunTestWrapper(Test24Impl, 24);
+    RunTestWrapper(Test25Impl, 25);
+    RunTestWrapper(Test26Impl, 26);
+    RunTestWrapper(Test27Impl, 27);
+    RunTestWrapper(Test28Impl, 28);
+    RunTestWrapper(Test29Impl, 29);
+    RunTestWrapper(Test30Impl, 30);
+    RunTestWrapper(Test31Impl, 31);
 }
 
 }  // namespace AppSpace